@@ -0,0 +1,145 @@
+#ifndef GDEV_BENCHMARK_H
+#define GDEV_BENCHMARK_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+/**
+ * Per-frame counters that any part of the renderer can add to
+ */
+enum class FrameCounter
+{
+	DrawCalls,
+	Instances,				// Objects drawn (an instanced draw call counts all of its instances)
+	UniformUpdates,			// glUniform*() calls that were made
+	UniformUpdatesSkipped,	// Uniform updates that were dropped because the value did not change
+	UniformBufferUpdates,	// Writes into uniform buffer objects
+	ShadedFragments,		// Fragments that passed the depth test in the shading pass (with --overdraw)
+	CoveredPixels,			// Pixels with at least one shaded fragment (with --overdraw)
+	ObjectsCulled,			// Objects that were outside the view frustum and not drawn
+	BvhNodesTested,			// Bounding volume hierarchy nodes tested against the view frustum (see Bvh.h)
+	OcclusionQueries,		// Occlusion queries issued (see OcclusionCulling.h)
+	ObjectsOccluded,		// Objects that the last occlusion query found hidden, and were not drawn
+	OcclusionStallMicroseconds,	// Time spent waiting for occlusion query results
+	StreamBufferBytes,		// Bytes written into stream buffers (see StreamBuffer.h)
+	StreamBufferStallMicroseconds,	// Time spent waiting for the GPU to finish reading a part of a stream buffer
+	DynamicVertexBytes,		// Bytes of dynamic mesh vertices sent to the GPU (see DynamicMesh.h)
+	DynamicVertexUploads,	// Buffer writes that sent them
+	DynamicUploadMicroseconds,	// Time spent in DynamicMesh::Upload() (including waits for the GPU)
+	StateChanges,			// Program, vertex array and texture bindings that were made (see StateCache.h)
+	StateChangesSkipped,	// Bindings that were dropped because the object was already bound
+	Triangles,				// Triangles drawn (all instances of an instanced draw call)
+	MeshletsCulled,			// Meshlets that were outside the view frustum or facing away, and not drawn (see Meshlet.h)
+	Count
+};
+
+/**
+ * @brief Adds to one of the counters of the current frame.
+ * @param[in] counter Counter to add to
+ * @param[in] amount Amount to add
+ */
+void AddFrameCounter(FrameCounter counter, unsigned long long amount = 1);
+
+/**
+ * @brief Same as glDrawArrays(), but also counted as a draw call in the frame stats.
+ * @param[in] mode Primitive type
+ * @param[in] first Index of the first vertex
+ * @param[in] count Number of vertices
+ */
+void DrawArrays(GLenum mode, GLint first, GLsizei count);
+
+/**
+ * @brief Same as glDrawElements(), but also counted as a draw call in the frame stats.
+ * @param[in] mode Primitive type
+ * @param[in] count Number of indices
+ * @param[in] type Index type (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+ * @param[in] indices Byte offset of the first index in the bound index buffer
+ */
+void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+
+/**
+ * @brief Same as glDrawElementsInstanced(), but also counted as a draw call in the frame stats.
+ * @param[in] mode Primitive type
+ * @param[in] count Number of indices
+ * @param[in] type Index type (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+ * @param[in] indices Byte offset of the first index in the bound index buffer
+ * @param[in] instanceCount Number of instances to draw
+ */
+void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount);
+
+/**
+ * @brief Same as glMultiDrawElements(), but also counted as one draw call in the frame stats.
+ * @param[in] mode Primitive type
+ * @param[in] counts Number of indices of each range
+ * @param[in] type Index type (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+ * @param[in] indices Byte offset of the first index of each range in the bound index buffer
+ * @param[in] drawCount Number of ranges
+ */
+void MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum type, const void* const* indices, GLsizei drawCount);
+
+/**
+ * Collects CPU and GPU frame times and the frame counters, and reports min/median/p99 values.
+ * GPU times come from GL_TIME_ELAPSED queries that are read back a few frames later so that
+ * measuring does not stall the pipeline.
+ */
+class FrameStats
+{
+public:
+	/**
+	 * @brief Creates the timer queries. Requires a current OpenGL context.
+	 * @param[in] warmupFrameCount Number of frames at the start that are not recorded
+	 * (the GPU time of the first frame is never recorded, even without warm-up frames)
+	 */
+	explicit FrameStats(int warmupFrameCount);
+
+	FrameStats(const FrameStats&) = delete;
+	FrameStats& operator=(const FrameStats&) = delete;
+
+	/**
+	 * @brief Marks the start of a frame. Resets the frame counters.
+	 */
+	void BeginFrame();
+
+	/**
+	 * @brief Marks the end of a frame (before swapping buffers).
+	 */
+	void EndFrame();
+
+	/**
+	 * @brief Waits for the GPU to finish, collects the remaining GPU timings and deletes the timer queries.
+	 * Call this before the OpenGL context is destroyed.
+	 */
+	void Finish();
+
+	/**
+	 * @brief Prints the collected statistics. Only the counters that were added to in a measured frame are printed.
+	 * @param[in] out Stream to print to
+	 */
+	void Report(std::ostream& out) const;
+
+private:
+	static const int QUERY_COUNT = 4;
+
+	void CollectQuery(int queryIndex);
+
+	int warmupFrameCount;
+	int frameIndex = 0;
+	GLuint queries[QUERY_COUNT];
+	int queryFrame[QUERY_COUNT];
+	std::chrono::steady_clock::time_point queryStart[QUERY_COUNT];	// When the frame of each query began on the CPU
+
+	std::chrono::steady_clock::time_point frameStart;
+	std::chrono::steady_clock::time_point measureStart;
+	std::chrono::steady_clock::time_point measureEnd;
+
+	std::vector<double> cpuFrameTimes;	// In milliseconds
+	std::vector<double> gpuFrameTimes;	// In milliseconds
+	int rejectedGpuFrameTimes = 0;		// GPU timings that were longer than the frame could have taken
+	std::vector<unsigned long long> counterTotals;
+	std::vector<bool> countersUsed;		// Counters that were added to in a measured frame
+};
+
+#endif
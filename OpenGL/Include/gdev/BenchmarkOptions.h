@@ -0,0 +1,55 @@
+#ifndef GDEV_BENCHMARK_OPTIONS_H
+#define GDEV_BENCHMARK_OPTIONS_H
+
+#include <gdev/DepthPrepass.h>
+#include <gdev/DynamicMesh.h>
+
+#include <string>
+
+/**
+ * Options read from the command line that control how the scene is run
+ */
+struct BenchmarkOptions
+{
+	bool headless = false;		// Render into an offscreen framebuffer instead of a window
+	int frameCount = 500;		// Number of measured frames in headless mode
+	int warmupFrameCount = 10;	// Number of frames rendered before measuring starts
+	int width = 800;			// Width of the window or offscreen framebuffer
+	int height = 600;			// Height of the window or offscreen framebuffer
+	std::string capturePath;	// If not empty, the last headless frame is saved to this file (.ppm)
+	int stressCubeCount = 0;	// Number of extra cubes drawn by the stress scene (0 = no stress scene)
+	bool instancing = true;		// Draw repeated meshes with instanced draws instead of one draw per object
+	int textureThreadCount = 0;	// Number of threads that decode textures (0 = one per CPU core)
+	bool mipmaps = true;		// Build mip chains for the textures and sample them with trilinear filtering
+	bool cookedTextures = false;	// Load the cooked .gtex textures made by Tools/TextureCook instead of the images
+	DepthPrepassMode depthPrepass = DepthPrepassMode::Off;	// Draw the depth of the scene before shading it
+	bool overdraw = false;		// Count the shaded fragments with the stencil buffer (reads it back every frame)
+	bool culling = true;		// Skip objects whose bounding box is outside the view frustum
+	bool bvhCulling = true;		// Cull many objects with a bounding volume hierarchy instead of testing each of them
+	bool occlusionCulling = false;	// Skip objects that occlusion queries found hidden behind other objects
+	int dynamicGridSize = 0;	// Vertices along each side of the animated grid (0 = no grid)
+	DynamicMeshUpload dynamicUpload = DynamicMeshUpload::Auto;	// How the vertices of the animated grid are uploaded
+	float dynamicFraction = 1.0f;	// Fraction of the rows of the animated grid that move each frame
+	std::string modelPath;		// If not empty, a mesh file (.obj or .glb) that is drawn on the floor
+	bool meshOptimization = true;	// Reorder the triangles and vertices of the meshes for the vertex cache, overdraw and vertex fetch
+	bool meshCache = true;		// Load --model from a binary mesh cache next to the file, and write the cache if it is missing or stale
+	int lodCount = 4;			// Simplified levels of detail made for --model, each with half the triangles of the one before (0 = none)
+	float lodPixelError = 1.0f;	// Largest error of the level of detail that --model is drawn with, in pixels on the screen
+	bool meshletCulling = false;	// Draw only the meshlets of --model that are in the view frustum and face the camera
+	float cameraYaw = -90.0f;	// Direction that the camera starts looking in, in degrees around the y-axis (-90 = towards -z)
+};
+
+/**
+ * @brief Reads the benchmark options from the command-line arguments.
+ * Supported arguments: --headless, --frames N, --warmup N, --width N, --height N, --capture file.ppm,
+ * --stress N, --no-instancing, --texture-threads N, --no-mipmaps, --cooked-textures, --depth-prepass,
+ * --depth-prepass-equal, --overdraw, --no-culling, --flat-culling, --occlusion-culling, --dynamic-grid N,
+ * --dynamic-upload subdata|orphan|stream|auto, --dynamic-fraction F, --model file.obj|file.glb,
+ * --no-mesh-optimization, --no-mesh-cache, --lods N, --lod-error PIXELS, --meshlet-culling, --camera-yaw DEGREES
+ * @param[in] argc Number of arguments
+ * @param[in] argv Argument strings
+ * @return The parsed options (defaults are used for anything not given)
+ */
+BenchmarkOptions ParseBenchmarkOptions(int argc, char** argv);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef GDEV_BOUNDS_H
+#define GDEV_BOUNDS_H
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cstddef>
+
+/**
+ * Struct containing an axis-aligned bounding box. The default box is empty (min > max).
+ */
+struct BoundingBox
+{
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+	glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+	glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+};
+
+/**
+ * Struct containing a bounding sphere. The default sphere is empty (radius < 0).
+ */
+struct BoundingSphere
+{
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = -1.0f;
+};
+
+/**
+ * @brief Grows a bounding box to contain a point.
+ * @param[in,out] box Box to grow
+ * @param[in] point Point to contain
+ */
+void ExpandBoundingBox(BoundingBox& box, const glm::vec3& point);
+
+/**
+ * @brief Grows a bounding box to contain another box.
+ * @param[in,out] box Box to grow
+ * @param[in] other Box to contain
+ */
+void ExpandBoundingBox(BoundingBox& box, const BoundingBox& other);
+
+/**
+ * @brief Computes the axis-aligned box that contains a transformed box (the result is not the tightest box
+ * around the transformed points of the object, but it never cuts them off).
+ * @param[in] box Box in local space
+ * @param[in] matrix Transform, e.g. a model matrix (local space -> world space)
+ * @return Box in the transformed space
+ */
+BoundingBox TransformBoundingBox(const BoundingBox& box, const glm::mat4& matrix);
+
+/**
+ * @brief Computes a bounding sphere around the center of a bounding box that contains the given points.
+ * @param[in] box Bounding box of the points
+ * @param[in] points Points
+ * @param[in] pointCount Number of points
+ * @return The bounding sphere
+ */
+BoundingSphere ComputeBoundingSphere(const BoundingBox& box, const glm::vec3* points, size_t pointCount);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef GDEV_BVH_H
+#define GDEV_BVH_H
+
+#include <gdev/Bounds.h>
+#include <gdev/Frustum.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * Struct containing one node of a bounding volume hierarchy.
+ * The objects under a node are a contiguous range of the object list of the tree, so a node that is
+ * completely inside the frustum can hand out all of its objects without visiting its children.
+ */
+struct BvhNode
+{
+	BoundingBox bounds;		// Box around all objects under the node
+	int firstObject = 0;	// First object under the node (index into the object list of the tree)
+	int objectCount = 0;	// Number of objects under the node
+	int leftChild = -1;		// Index of the left child (the right child follows it), -1 for leaves
+	int parent = -1;		// Index of the parent node, -1 for the root
+};
+
+/**
+ * @brief Tests an object against a ray more precisely than its bounding box, e.g. with its triangles.
+ * @param[in] object Index of the object
+ * @param[in,out] distance Distance of the closest hit so far; set it to the distance of the hit if it is closer
+ * @return true if the object was hit closer than 'distance'
+ */
+typedef std::function<bool(int object, float& distance)> BvhRayTest;
+
+/**
+ * A bounding volume hierarchy over the bounding boxes of the objects of a scene, built with the surface area
+ * heuristic (SAH). Objects that move are updated with UpdateObject() or Refit(), which grow the boxes of the
+ * nodes without changing the tree; rebuild it when GetCost() has grown a lot since the last Build().
+ */
+class Bvh
+{
+public:
+	/**
+	 * @brief Builds the tree over the given boxes. Object i of the tree is boxes[i].
+	 * @param[in] boxes World-space bounding boxes of the objects (must not be empty)
+	 * @param[in] boxCount Number of objects
+	 */
+	void Build(const BoundingBox* boxes, size_t boxCount);
+
+	/**
+	 * @brief Updates the boxes of all objects and refits every node of the tree, bottom-up.
+	 * @param[in] boxes New bounding boxes (as many as given to Build())
+	 */
+	void Refit(const BoundingBox* boxes);
+
+	/**
+	 * @brief Updates the box of one object and refits the nodes above it.
+	 * @param[in] object Index of the object
+	 * @param[in] box New bounding box of the object
+	 */
+	void UpdateObject(int object, const BoundingBox& box);
+
+	/**
+	 * @brief Finds the objects whose boxes may be visible. Subtrees outside a frustum plane are skipped,
+	 * and the planes that a node is completely inside of are not tested again for anything below it.
+	 * @param[in] frustum Frustum in world space
+	 * @param[out] visibleObjects Indices of the objects that may be visible (in tree order)
+	 * @return Number of objects that may be visible
+	 */
+	size_t CullFrustum(const Frustum& frustum, std::vector<int>& visibleObjects) const;
+
+	/**
+	 * @brief Finds the closest object along a ray.
+	 * @param[in] origin Start of the ray
+	 * @param[in] direction Direction of the ray (distances are in multiples of its length)
+	 * @param[in,out] distance Longest distance to look at; set to the distance of the hit
+	 * @param[in] rayTest Exact test of the objects whose boxes are hit (if empty, the boxes are the hit)
+	 * @return Index of the closest object that was hit, or -1 if nothing was hit
+	 */
+	int Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, const BvhRayTest& rayTest = BvhRayTest()) const;
+
+	/**
+	 * @brief Finds the objects whose boxes overlap a box.
+	 * @param[in] box Box to look in
+	 * @param[out] objects Indices of the objects that overlap the box
+	 */
+	void QueryBox(const BoundingBox& box, std::vector<int>& objects) const;
+
+	/**
+	 * @brief Finds the objects whose boxes overlap a sphere, e.g. the objects in the range of a point light.
+	 * @param[in] sphere Sphere to look in
+	 * @param[out] objects Indices of the objects that overlap the sphere
+	 */
+	void QuerySphere(const BoundingSphere& sphere, std::vector<int>& objects) const;
+
+	/**
+	 * @brief Computes the SAH cost of the tree (the expected cost of a query, relative to testing one box).
+	 * @return Cost of the tree, or 0 if it is empty
+	 */
+	float GetCost() const;
+
+	size_t GetObjectCount() const { return objectBounds.size(); }
+	size_t GetNodeCount() const { return nodes.size(); }
+	const BoundingBox& GetObjectBounds(int object) const { return objectBounds[object]; }
+
+private:
+	void BuildNode(int nodeIndex, int depth, std::vector<glm::vec3>& centers);
+	void RefitNode(int nodeIndex);
+
+	std::vector<BvhNode> nodes;				// nodes[0] is the root; children always come after their parent
+	std::vector<int> objects;				// Object indices, ordered so that each node covers a range of them
+	std::vector<int> objectLeaves;			// Leaf node of each object
+	std::vector<BoundingBox> objectBounds;	// Bounding box of each object
+};
+
+#endif
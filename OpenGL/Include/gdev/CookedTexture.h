@@ -0,0 +1,95 @@
+#ifndef GDEV_COOKED_TEXTURE_H
+#define GDEV_COOKED_TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <gdev/MipChain.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * A cooked texture (.gtex) is an image that is already in the layout glTexImage2D() wants, so loading it
+ * needs no decoding. The file contains:
+ *
+ * CookedTextureHeader
+ * CookedTextureLevel[levelCount]
+ * The pixels of each level, starting at a multiple of 16 bytes, with rows padded to 4 bytes
+ * (the default GL_UNPACK_ALIGNMENT)
+ *
+ * All numbers are little-endian.
+ */
+
+const char COOKED_TEXTURE_MAGIC[4] = { 'G', 'T', 'E', 'X' };
+const uint32_t COOKED_TEXTURE_VERSION = 1;
+const char COOKED_TEXTURE_EXTENSION[] = ".gtex";
+
+/**
+ * Pixel formats of cooked textures
+ */
+enum class CookedTextureFormat : uint32_t
+{
+	RGBA8 = 0,	// 4 bytes per pixel
+	RGB565 = 1,	// 2 bytes per pixel (GL_UNSIGNED_SHORT_5_6_5); half the size, for textures without alpha
+};
+
+struct CookedTextureHeader
+{
+	char magic[4];			// COOKED_TEXTURE_MAGIC
+	uint32_t version;		// COOKED_TEXTURE_VERSION
+	uint32_t format;		// CookedTextureFormat
+	uint32_t levelCount;	// Number of mip levels (1 = no mipmaps)
+};
+
+struct CookedTextureLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint64_t offset;		// Byte offset of the level from the start of the file
+	uint64_t size;			// Size of the level in bytes (rows are padded to 4 bytes)
+};
+
+static_assert(sizeof(CookedTextureHeader) == 16 && sizeof(CookedTextureLevel) == 24, "Cooked texture structs must not have padding");
+
+/**
+ * Struct containing what a cooked texture file says about its contents
+ */
+struct CookedTextureInfo
+{
+	CookedTextureFormat format = CookedTextureFormat::RGBA8;
+	GLenum internalFormat = GL_RGBA8;		// Arguments for glTexImage2D()
+	GLenum pixelFormat = GL_RGBA;
+	GLenum pixelType = GL_UNSIGNED_BYTE;
+	std::vector<MipLevel> levels;			// Offsets are from the start of the file
+};
+
+/**
+ * @brief Checks whether a file path ends with COOKED_TEXTURE_EXTENSION.
+ * @param[in] filePath Path to check
+ * @return true if the path is a cooked texture
+ */
+bool IsCookedTexturePath(const std::string& filePath);
+
+/**
+ * @brief Writes a cooked texture file.
+ * @param[in] filePath Path of the file to write
+ * @param[in] pixels RGBA8 mip chain, as made by BuildMipChain()
+ * @param[in] levels Mip levels of the chain
+ * @param[in] format Pixel format to store the texture in
+ * @return true if the file was written, false otherwise
+ */
+bool WriteCookedTexture(const std::string& filePath, const std::vector<unsigned char>& pixels, const std::vector<MipLevel>& levels,
+	CookedTextureFormat format);
+
+/**
+ * @brief Reads the header of a cooked texture that is in memory (e.g. a MappedFile), and checks that it is valid:
+ * every level must fit in the file and in a GLsizei, and start after the end of the level before it.
+ * @param[in] data Contents of the file
+ * @param[in] size Size of the file
+ * @param[out] info Format and levels of the texture
+ * @return true if the file is a valid cooked texture, false otherwise
+ */
+bool ReadCookedTexture(const unsigned char* data, size_t size, CookedTextureInfo& info);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef GDEV_DEPTH_PREPASS_H
+#define GDEV_DEPTH_PREPASS_H
+
+#include <glad/glad.h>
+
+/**
+ * How the scene is drawn with respect to depth.
+ * With a depth pre-pass, the scene is first drawn into the depth buffer only (with a cheap shader and just the
+ * positions), and then shaded with depth writes off, so that each pixel runs the expensive fragment shader once.
+ */
+enum class DepthPrepassMode
+{
+	Off,		// Shade everything with GL_LESS, in draw order
+	LessEqual,	// Pre-pass, then shade with GL_LEQUAL
+	Equal,		// Pre-pass, then shade with GL_EQUAL (the vertex shaders of both passes need "invariant gl_Position")
+	Count
+};
+
+/**
+ * @brief Returns the name of a depth pre-pass mode, for printing.
+ * @param[in] mode Depth pre-pass mode
+ * @return Name of the mode
+ */
+const char* GetDepthPrepassModeName(DepthPrepassMode mode);
+
+/**
+ * @brief Sets up the depth state for the depth-only pass: no color writes, depth writes with GL_LESS.
+ */
+void BeginDepthPrepass();
+
+/**
+ * @brief Sets up the depth state for the shading pass.
+ * After a pre-pass, color writes are turned back on and depth writes are turned off.
+ * @param[in] mode Depth pre-pass mode
+ */
+void BeginShadingPass(DepthPrepassMode mode);
+
+/**
+ * @brief Restores the default depth state (depth writes with GL_LESS), which glClear() of the depth buffer needs.
+ */
+void EndShadingPass();
+
+/**
+ * @brief Starts counting the fragments that pass the depth test into the stencil buffer (GL_INCR on depth pass).
+ * The stencil buffer has to be cleared to 0 first.
+ */
+void BeginOverdrawCount();
+
+/**
+ * @brief Stops counting, reads the stencil buffer back and adds the counts to the frame counters
+ * FrameCounter::ShadedFragments and FrameCounter::CoveredPixels. This waits for the GPU to finish the frame.
+ * Counts saturate at 255 per pixel. Does nothing if BeginOverdrawCount() was not called since the last call.
+ * @param[in] width Width of the framebuffer
+ * @param[in] height Height of the framebuffer
+ */
+void EndOverdrawCount(int width, int height);
+
+#endif
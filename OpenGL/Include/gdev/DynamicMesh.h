@@ -0,0 +1,132 @@
+#ifndef GDEV_DYNAMIC_MESH_H
+#define GDEV_DYNAMIC_MESH_H
+
+#include <glad/glad.h>
+
+#include <gdev/Mesh.h>
+#include <gdev/StreamBuffer.h>
+#include <gdev/VertexLayout.h>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Ways that the vertices of a dynamic mesh are sent to the GPU
+ */
+enum class DynamicMeshUpload
+{
+	SubData,	// glBufferSubData() for each range of vertices that changed
+	Orphan,		// glBufferData(nullptr) to orphan the old storage, then upload all vertices into the new one
+	Stream,		// All vertices into the part of a stream buffer of this frame (see StreamBuffer.h)
+	Auto,		// SubData, or Orphan when the ranges that changed cost more to upload than all of the vertices
+	Count
+};
+
+/**
+ * @brief Returns the name of an upload mode, as given to --dynamic-upload.
+ * @param[in] mode Upload mode
+ * @return Name of the mode
+ */
+const char* GetDynamicMeshUploadName(DynamicMeshUpload mode);
+
+/**
+ * A mesh whose vertices change from frame to frame (e.g. vertex animation), with its indices and submeshes fixed.
+ *
+ * A copy of the packed vertices stays on the CPU. Writing vertices marks their range as dirty, and Upload()
+ * sends only the dirty ranges, merged together when the gap between them is cheaper to upload than a separate
+ * glBufferSubData() call. When most of the mesh changed, orphaning the buffer and writing all of it is cheaper,
+ * since the driver hands out new storage instead of waiting for the draws that still read the old one.
+ */
+class DynamicMesh
+{
+public:
+	DynamicMesh() = default;
+	DynamicMesh(const DynamicMesh&) = delete;
+	DynamicMesh& operator=(const DynamicMesh&) = delete;
+
+	/**
+	 * @brief Creates the buffers of the mesh (one vertex buffer per stream of the layout, see CreateMesh()).
+	 * @param[in] builder Builder with the initial vertices, the indices and the submeshes
+	 * @param[in] layout Layout of the vertices (its stride has to be the vertex size of the builder)
+	 * @return true if the mesh was created
+	 */
+	bool Create(const MeshBuilder& builder, const VertexLayout& layout);
+
+	/**
+	 * @brief Returns the packed vertices of a range for writing, and marks the range as dirty.
+	 * @param[in] firstVertex First vertex of the range
+	 * @param[in] vertexCount Number of vertices
+	 * @return Pointer to the first vertex (layout.stride bytes per vertex)
+	 */
+	unsigned char* EditVertices(size_t firstVertex, size_t vertexCount);
+
+	/**
+	 * @brief Copies packed vertices into a range of the mesh, and marks the range as dirty.
+	 * @param[in] firstVertex First vertex to replace
+	 * @param[in] vertices Packed vertices (layout.stride bytes each)
+	 * @param[in] vertexCount Number of vertices
+	 */
+	void WriteVertices(size_t firstVertex, const void* vertices, size_t vertexCount);
+
+	/**
+	 * @brief Sends the vertices to the GPU. Call it once per frame, before the draws of the mesh.
+	 * With DynamicMeshUpload::Stream, all vertices are written every frame (the part of the stream buffer is new),
+	 * and the vertex arrays of the mesh have to be set up again with SetVertexArray() afterwards
+	 * (also after the first Upload() in another mode, which goes back to the buffers of the mesh).
+	 * The bytes, the calls and the time are added to FrameCounter::DynamicVertexBytes, DynamicVertexUploads
+	 * and DynamicUploadMicroseconds.
+	 * @param[in] mode How to send the vertices
+	 * @param[in,out] streamBuffer Buffer for DynamicMeshUpload::Stream (must have room for all vertices)
+	 */
+	void Upload(DynamicMeshUpload mode, StreamBuffer* streamBuffer = nullptr);
+
+	/**
+	 * @brief Sets up the vertex attributes and the index buffer in the vertex array object that is bound,
+	 * reading the vertices from where the last Upload() put them.
+	 * @param[in] streamMask Vertex streams to read (see SetMeshVertexArray())
+	 */
+	void SetVertexArray(GLuint streamMask = ALL_VERTEX_STREAMS) const;
+
+	/**
+	 * @brief Recomputes the bounds of the submeshes from the vertices on the CPU.
+	 * They are the bounds of the vertices given to Create() until this is called.
+	 */
+	void UpdateBounds();
+
+	/**
+	 * @brief Deletes the buffers of the mesh.
+	 */
+	void Delete();
+
+	const Mesh& GetMesh() const { return mesh; }
+	const VertexLayout& GetLayout() const { return layout; }
+	size_t GetVertexCount() const { return layout.stride > 0 ? vertexData.size() / layout.stride : 0; }
+	const unsigned char* GetVertexData() const { return vertexData.data(); }
+
+private:
+	/**
+	 * Struct containing a range of vertices [first, end)
+	 */
+	struct VertexRange
+	{
+		size_t first;
+		size_t end;
+	};
+
+	void MarkDirty(size_t firstVertex, size_t vertexCount);
+	void UploadDirty(DynamicMeshUpload mode, StreamBuffer* streamBuffer);
+	void UploadRanges();
+	void UploadAll();
+	void UploadToStreamBuffer(StreamBuffer& streamBuffer);
+
+	Mesh mesh;
+	VertexLayout layout;
+	std::vector<unsigned char> vertexData;		// Packed vertices (layout.stride bytes each)
+	std::vector<GLuint> indices;				// For UpdateBounds()
+	std::vector<VertexRange> dirtyRanges;		// Ranges written since the last Upload(), in the order they were written
+	std::vector<unsigned char> streamData;		// Vertices of one stream, before they are uploaded
+	GLuint streamBufferId = 0;					// Stream buffer of the last Upload(), or 0 if the vertices are in the mesh
+	GLintptr streamOffsets[MAX_VERTEX_STREAMS] = {};	// Offset of each stream in the stream buffer
+};
+
+#endif
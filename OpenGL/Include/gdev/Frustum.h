@@ -0,0 +1,56 @@
+#ifndef GDEV_FRUSTUM_H
+#define GDEV_FRUSTUM_H
+
+#include <gdev/Bounds.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+/**
+ * Struct containing the six planes of a view frustum (left, right, bottom, top, near, far).
+ * Each plane is (normal, distance) with the normal pointing into the frustum, so a point p is inside
+ * a plane when dot(normal, p) + distance >= 0.
+ */
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+/**
+ * @brief Extracts the frustum planes from a view-projection matrix (Gribb/Hartmann).
+ * The planes are in the space that the matrix transforms from, e.g. world space for projection * view.
+ * @param[in] viewProjectionMatrix Projection matrix times view matrix
+ * @return The normalized frustum planes
+ */
+Frustum ExtractFrustum(const glm::mat4& viewProjectionMatrix);
+
+/**
+ * @brief Tests whether a box is at least partly inside the frustum. Boxes near the corners of the frustum
+ * can pass without being inside, but boxes that are inside never fail.
+ * @param[in] frustum Frustum to test against
+ * @param[in] box Box in the space of the frustum (must not be empty)
+ * @return true if the box may be visible
+ */
+bool IsBoxInFrustum(const Frustum& frustum, const BoundingBox& box);
+
+/**
+ * @brief Tests whether a sphere is at least partly inside the frustum (with the same corner cases as boxes).
+ * @param[in] frustum Frustum to test against
+ * @param[in] sphere Sphere in the space of the frustum
+ * @return true if the sphere may be visible
+ */
+bool IsSphereInFrustum(const Frustum& frustum, const BoundingSphere& sphere);
+
+/**
+ * @brief Tests many boxes against the frustum, four at a time with SSE when it is available.
+ * Gives the same results as IsBoxInFrustum() (up to rounding for boxes that touch a plane).
+ * @param[in] frustum Frustum to test against
+ * @param[in] boxes Boxes in the space of the frustum (must not be empty)
+ * @param[in] boxCount Number of boxes
+ * @param[out] visible One flag per box: 1 if the box may be visible, 0 if it is outside
+ * @return Number of boxes that may be visible
+ */
+size_t CullBoundingBoxes(const Frustum& frustum, const BoundingBox* boxes, size_t boxCount, unsigned char* visible);
+
+#endif
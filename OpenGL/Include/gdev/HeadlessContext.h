@@ -0,0 +1,47 @@
+#ifndef GDEV_HEADLESS_CONTEXT_H
+#define GDEV_HEADLESS_CONTEXT_H
+
+#include <glad/glad.h>
+
+#include <string>
+
+/**
+ * Struct containing an OpenGL context that has no window, and the offscreen framebuffer we render into.
+ * On Linux this uses a surfaceless EGL display, so it works without an X server (e.g. Mesa llvmpipe).
+ */
+struct HeadlessContext
+{
+	void* display = nullptr;	// EGLDisplay
+	void* context = nullptr;	// EGLContext
+	GLuint framebuffer = 0;
+	GLuint colorRenderbuffer = 0;
+	GLuint depthRenderbuffer = 0;
+	int width = 0;
+	int height = 0;
+};
+
+/**
+ * @brief Creates an OpenGL 3.3 core context without a window, loads the OpenGL functions with GLAD,
+ * and binds an offscreen framebuffer (RGBA8 color, 24-bit depth, 8-bit stencil) of the given size.
+ * @param[out] headlessContext Context to fill in
+ * @param[in] width Width of the offscreen framebuffer
+ * @param[in] height Height of the offscreen framebuffer
+ * @return true if the context was created, false otherwise
+ */
+bool CreateHeadlessContext(HeadlessContext& headlessContext, int width, int height);
+
+/**
+ * @brief Deletes the offscreen framebuffer and destroys the context.
+ * @param[in] headlessContext Context to destroy
+ */
+void DestroyHeadlessContext(HeadlessContext& headlessContext);
+
+/**
+ * @brief Saves the color buffer of the offscreen framebuffer to a binary PPM image.
+ * @param[in] headlessContext Context whose framebuffer is saved
+ * @param[in] filePath Path of the image to write
+ * @return true if the image was written, false otherwise
+ */
+bool SaveHeadlessFramebuffer(const HeadlessContext& headlessContext, const std::string& filePath);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef GDEV_INSTANCE_BUFFER_H
+#define GDEV_INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+/**
+ * Per-instance data of an instanced draw, matching these vertex shader inputs:
+ *
+ * layout(location = 4) in mat4 instanceModelMatrix;	// Uses locations 4 to 7
+ * layout(location = 8) in int instanceMaterialIndex;
+ * layout(location = 9) in mat3 instanceNormalMatrix;	// Uses locations 9 to 11
+ */
+struct InstanceData
+{
+	glm::mat4 modelMatrix;	// Local space -> world space
+	GLint materialIndex;	// Index into the material array of the shader
+	glm::mat3 normalMatrix;	// See ComputeNormalMatrix()
+};
+
+// First attribute location of the per-instance data (the mat4 takes 4 locations, the material index 1, the mat3 3)
+const GLuint INSTANCE_ATTRIBUTE_LOCATION = 4;
+
+/**
+ * Struct containing a vertex buffer with per-instance data
+ */
+struct InstanceBuffer
+{
+	GLuint id = 0;			// OpenGL handle to the buffer
+	GLsizei capacity = 0;	// Number of instances the buffer has room for
+	GLsizei count = 0;		// Number of instances written by the last update
+};
+
+/**
+ * @brief Creates a buffer with room for a number of instances.
+ * @param[in] capacity Number of instances
+ * @param[in] usage Usage hint (GL_STATIC_DRAW if the instances never move, GL_DYNAMIC_DRAW otherwise)
+ * @return The created instance buffer
+ */
+InstanceBuffer CreateInstanceBuffer(GLsizei capacity, GLenum usage);
+
+/**
+ * @brief Replaces the instances in the buffer. Instances past the capacity are dropped.
+ * @param[in] buffer Buffer to write to
+ * @param[in] instances Instance data
+ * @param[in] instanceCount Number of instances
+ */
+void UpdateInstanceBuffer(InstanceBuffer& buffer, const InstanceData* instances, GLsizei instanceCount);
+
+/**
+ * @brief Sets up the per-instance attributes (glVertexAttribDivisor(..., 1)) of the vertex array object that is bound.
+ * @param[in] buffer Buffer that the attributes read from
+ */
+void SetInstanceAttributes(const InstanceBuffer& buffer);
+
+/**
+ * @brief Sets up the per-instance attributes to read InstanceData from any buffer, e.g. from the part of a
+ * stream buffer that was written this frame (see StreamBuffer.h).
+ * @param[in] bufferId Buffer that the attributes read from
+ * @param[in] offset Byte offset of the first instance in the buffer
+ */
+void SetInstanceAttributes(GLuint bufferId, GLintptr offset);
+
+/**
+ * @brief Deletes the instance buffer.
+ * @param[in] buffer Buffer to delete
+ */
+void DeleteInstanceBuffer(InstanceBuffer& buffer);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef GDEV_MAPPED_FILE_H
+#define GDEV_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Struct containing a read-only memory mapping of a whole file.
+ * The operating system pages the file in as it is read, so nothing is copied up front.
+ */
+struct MappedFile
+{
+	const unsigned char* data = nullptr;	// Contents of the file (nullptr if not mapped)
+	size_t size = 0;						// Size of the file in bytes
+	void* fileHandle = nullptr;				// HANDLE on Windows, unused elsewhere
+	void* mappingHandle = nullptr;			// HANDLE on Windows, unused elsewhere
+};
+
+/**
+ * @brief Maps a file into memory for reading.
+ * @param[out] file Mapping to fill in
+ * @param[in] filePath Path to the file
+ * @return true if the file was mapped, false otherwise (e.g. it does not exist or is empty)
+ */
+bool OpenMappedFile(MappedFile& file, const std::string& filePath);
+
+/**
+ * @brief Unmaps a file. Does nothing if the file is not mapped.
+ * @param[in] file Mapping to close
+ */
+void CloseMappedFile(MappedFile& file);
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef GDEV_MESH_H
+#define GDEV_MESH_H
+
+#include <glad/glad.h>
+
+#include <gdev/Bounds.h>
+#include <gdev/VertexLayout.h>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Struct containing a range of the index buffer that is drawn with one draw call
+ */
+struct SubMesh
+{
+	GLenum mode = GL_TRIANGLES;	// Primitive type
+	GLuint firstIndex = 0;		// First index of the range
+	GLsizei indexCount = 0;		// Number of indices in the range
+	BoundingBox bounds;			// Bounds of the vertices in local space (empty if the mesh has no vertex layout)
+	BoundingSphere sphere;
+};
+
+/**
+ * Builds an indexed mesh out of unindexed vertices.
+ * Vertices are compared byte by byte, and identical vertices are stored only once, so make sure that
+ * every byte of a packed vertex is written (e.g. zero the buffer before PackVertexAttribute() fills it in).
+ */
+class MeshBuilder
+{
+public:
+	/**
+	 * @param[in] vertexSize Size of one packed vertex in bytes (e.g. layout.stride of its VertexLayout)
+	 */
+	explicit MeshBuilder(size_t vertexSize);
+
+	/**
+	 * @brief Adds a vertex, reusing an identical vertex that was added before.
+	 * @param[in] vertex Vertex data (vertexSize bytes)
+	 * @return Index of the vertex
+	 */
+	GLuint AddVertex(const void* vertex);
+
+	/**
+	 * @brief Makes room for more vertices, so that adding them does not grow the vertex data and the hash table
+	 * over and over.
+	 * @param[in] vertexCount Total number of unique vertices that the builder is expected to hold
+	 */
+	void Reserve(size_t vertexCount);
+
+	/**
+	 * @brief Adds a submesh made of the given unindexed vertices.
+	 * Triangle fans and strips are turned into triangle lists, so that consecutive submeshes
+	 * can be combined and drawn with a single draw call.
+	 * @param[in] mode Primitive type the vertices are drawn with
+	 * @param[in] vertices Vertex data
+	 * @param[in] vertexCount Number of vertices
+	 * @return Index of the new submesh
+	 */
+	int AddSubMesh(GLenum mode, const void* vertices, size_t vertexCount);
+
+	/**
+	 * @brief Adds a submesh made of the given indices into the vertices added so far.
+	 * @param[in] mode Primitive type the indices are drawn with
+	 * @param[in] indices Indices
+	 * @param[in] indexCount Number of indices
+	 * @return Index of the new submesh
+	 */
+	int AddIndexedSubMesh(GLenum mode, const GLuint* indices, size_t indexCount);
+
+	/**
+	 * @brief Adds a submesh that covers several consecutive submeshes, so that they can be drawn with one draw call.
+	 * The submeshes need to use the same primitive type, and it has to be a list type (e.g. GL_TRIANGLES).
+	 * @param[in] firstSubMesh First submesh to cover
+	 * @param[in] subMeshCount Number of submeshes to cover
+	 * @return Index of the new submesh
+	 */
+	int CombineSubMeshes(int firstSubMesh, int subMeshCount);
+
+	/**
+	 * @brief Replaces a range of the indices, e.g. with the same triangles in another order.
+	 * @param[in] firstIndex First index of the range
+	 * @param[in] newIndices New indices of the range
+	 * @param[in] indexCount Number of indices in the range
+	 */
+	void ReplaceIndices(size_t firstIndex, const GLuint* newIndices, size_t indexCount);
+
+	/**
+	 * @brief Moves the vertices to new places in the vertex data, and updates the indices that refer to them.
+	 * @param[in] newVertexIndices New index of each vertex (each index from 0 to GetVertexCount() - 1 once)
+	 */
+	void RemapVertices(const std::vector<GLuint>& newVertexIndices);
+
+	size_t GetVertexSize() const { return vertexSize; }
+	size_t GetVertexCount() const { return vertexData.size() / vertexSize; }
+	size_t GetSourceVertexCount() const { return sourceVertexCount; }
+	const unsigned char* GetVertexData() const { return vertexData.data(); }
+	const std::vector<GLuint>& GetIndices() const { return indices; }
+	const std::vector<SubMesh>& GetSubMeshes() const { return subMeshes; }
+
+private:
+	void Rehash(size_t bucketCount);
+
+	size_t vertexSize;
+	size_t sourceVertexCount = 0;		// Number of vertices given to AddVertex() before merging
+	std::vector<unsigned char> vertexData;
+	std::vector<GLuint> indices;
+	std::vector<SubMesh> subMeshes;
+	std::vector<GLuint> buckets;		// Open-addressing hash table of vertex indices (~0u = empty)
+};
+
+/**
+ * Struct containing the buffers of an indexed mesh on the GPU
+ */
+struct Mesh
+{
+	GLuint vertexBuffers[MAX_VERTEX_STREAMS] = {};	// VBO with the unique vertices, one per vertex stream
+	int vertexStreamCount = 0;
+	GLuint indexBuffer = 0;				// EBO with the indices
+	GLenum indexType = GL_UNSIGNED_INT;	// GL_UNSIGNED_SHORT if all indices fit in 16 bits
+	GLsizei vertexCount = 0;
+	GLsizei indexCount = 0;
+	std::vector<SubMesh> subMeshes;
+};
+
+/**
+ * @brief Uploads a built mesh to a vertex buffer and an index buffer (16-bit indices when possible).
+ * The index buffer has to be bound to the vertex array object with glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ...)
+ * while the VAO is bound.
+ * @param[in] builder Builder with the mesh data
+ * @param[in] usage Buffer usage hint (e.g. GL_STATIC_DRAW)
+ * @return The created mesh
+ */
+Mesh CreateMesh(const MeshBuilder& builder, GLenum usage);
+
+/**
+ * @brief Uploads a built mesh like CreateMesh(builder, usage), but with the vertices split into
+ * one vertex buffer per stream of the layout. The bounds of the submeshes are computed from the
+ * attribute at location 0, which is the position in all of our shaders.
+ * @param[in] builder Builder with the mesh data (its vertex size has to be layout.stride)
+ * @param[in] layout Layout of the vertices of the mesh
+ * @param[in] usage Buffer usage hint (e.g. GL_STATIC_DRAW)
+ * @return The created mesh
+ */
+Mesh CreateMesh(const MeshBuilder& builder, const VertexLayout& layout, GLenum usage);
+
+/**
+ * @brief Computes the bounding box and sphere of each submesh from the positions of its vertices
+ * (the attribute at location 0).
+ * @param[in] layout Layout of the vertices
+ * @param[in] vertices Packed vertices (layout.stride bytes each)
+ * @param[in] vertexCount Number of vertices
+ * @param[in] indices Indices that the submeshes are ranges of
+ * @param[in,out] subMeshes Submeshes whose bounds are replaced
+ */
+void ComputeSubMeshBounds(const VertexLayout& layout, const unsigned char* vertices, size_t vertexCount, const GLuint* indices,
+	std::vector<SubMesh>& subMeshes);
+
+/**
+ * @brief Sets up the vertex attributes and the index buffer of a mesh in the vertex array object that is bound.
+ * @param[in] mesh Mesh whose buffers the vertex array reads from
+ * @param[in] layout Layout of the vertices of the mesh (the one it was created with)
+ * @param[in] streamMask Vertex streams to read (e.g. 1u << 0 for a pass that only needs stream 0)
+ */
+void SetMeshVertexArray(const Mesh& mesh, const VertexLayout& layout, GLuint streamMask = ALL_VERTEX_STREAMS);
+
+/**
+ * @brief Draws one submesh with glDrawElements(). The VAO of the mesh must be bound.
+ * @param[in] mesh Mesh to draw
+ * @param[in] subMeshIndex Submesh to draw
+ */
+void DrawSubMesh(const Mesh& mesh, int subMeshIndex);
+
+/**
+ * @brief Draws several instances of one submesh with glDrawElementsInstanced(). The VAO of the mesh must be bound,
+ * and it should have per-instance attributes (see InstanceBuffer.h).
+ * @param[in] mesh Mesh to draw
+ * @param[in] subMeshIndex Submesh to draw
+ * @param[in] instanceCount Number of instances
+ */
+void DrawSubMeshInstanced(const Mesh& mesh, int subMeshIndex, GLsizei instanceCount);
+
+/**
+ * @brief Deletes the buffers of the mesh.
+ * @param[in] mesh Mesh to delete
+ */
+void DeleteMesh(Mesh& mesh);
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef GDEV_MESH_CACHE_H
+#define GDEV_MESH_CACHE_H
+
+#include <glad/glad.h>
+
+#include <gdev/Bounds.h>
+#include <gdev/Mesh.h>
+#include <gdev/MeshSimplifier.h>
+#include <gdev/Meshlet.h>
+#include <gdev/VertexLayout.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * A mesh cache (.gmesh) is a built mesh that is already in the layout the buffers of a Mesh want, so loading it
+ * needs no parsing: the file is memory-mapped and its blobs are passed to glBufferData() as they are.
+ * It is written next to the file the mesh was imported from, and remembers a hash of that file, so a cache
+ * whose source has changed is ignored. The file contains:
+ *
+ * MeshCacheHeader
+ * MeshCacheAttribute[attributeCount]	The vertex layout the vertices are stored in
+ * MeshCacheStream[streamCount]
+ * MeshCacheSubMesh[subMeshCount]
+ * MeshCacheLod[lodCount]				The levels of detail, from the full mesh to the simplest
+ * MeshCacheMeshlet[meshletCount]		The meshlets of all levels of detail
+ * The indices (16-bit if every index fits, like CreateMesh()) and the vertices of each stream,
+ * each starting at a multiple of 16 bytes
+ *
+ * All numbers are little-endian.
+ */
+
+const char MESH_CACHE_MAGIC[4] = { 'G', 'M', 'S', 'H' };
+const uint32_t MESH_CACHE_VERSION = 3;
+const char MESH_CACHE_EXTENSION[] = ".gmesh";
+
+// Flags of a mesh cache; a cache is only used if it was written with the same flags
+const uint32_t MESH_CACHE_OPTIMIZED = 1u << 0;	// The mesh went through OptimizeMesh()
+const int MESH_CACHE_LOD_SHIFT = 8;				// Bits 8 to 15 hold the number of levels of detail that were asked for
+
+struct MeshCacheHeader
+{
+	char magic[4];				// MESH_CACHE_MAGIC
+	uint32_t version;			// MESH_CACHE_VERSION
+	uint64_t sourceHash;		// HashMeshSource() of the file the mesh was imported from
+	uint32_t flags;				// MESH_CACHE_* flags
+	uint32_t attributeCount;
+	uint32_t streamCount;
+	uint32_t subMeshCount;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t indexType;			// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	uint32_t stride;			// Size of one packed vertex in bytes (all streams together)
+	float boundsMin[3];			// Bounds of all of the vertices
+	float boundsMax[3];
+	uint64_t indexOffset;		// Byte offset of the indices from the start of the file
+	uint64_t indexSize;			// Size of the indices in bytes
+	uint32_t lodCount;
+	uint32_t meshletCount;
+};
+
+struct MeshCacheAttribute
+{
+	uint32_t location;
+	uint32_t format;			// VertexAttributeFormat
+	uint32_t offset;
+	uint32_t stream;
+	uint32_t streamOffset;
+};
+
+struct MeshCacheStream
+{
+	uint32_t stride;			// Size of the vertex of the stream in bytes
+	uint32_t unused;
+	uint64_t offset;			// Byte offset of the vertices of the stream from the start of the file
+	uint64_t size;				// Size of the vertices in bytes
+};
+
+struct MeshCacheSubMesh
+{
+	uint32_t mode;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float boundsMin[3];
+	float boundsMax[3];
+	float sphereCenter[3];
+	float sphereRadius;
+};
+
+struct MeshCacheLod
+{
+	uint32_t subMesh;
+	float error;
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+};
+
+struct MeshCacheMeshlet
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float sphereCenter[3];
+	float sphereRadius;
+	float coneApex[3];
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+static_assert(sizeof(MeshCacheHeader) == 96 && sizeof(MeshCacheAttribute) == 20 && sizeof(MeshCacheStream) == 24
+	&& sizeof(MeshCacheSubMesh) == 52 && sizeof(MeshCacheLod) == 16 && sizeof(MeshCacheMeshlet) == 52,
+	"Mesh cache structs must not have padding");
+
+/**
+ * Struct containing what a mesh cache file says about its contents
+ */
+struct MeshCacheInfo
+{
+	uint64_t sourceHash = 0;
+	uint32_t flags = 0;
+	VertexLayout layout;
+	GLenum indexType = GL_UNSIGNED_INT;
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	BoundingBox bounds;
+	std::vector<SubMesh> subMeshes;
+	std::vector<MeshLod> lods;
+	std::vector<Meshlet> meshlets;
+	size_t indexOffset = 0;							// Offsets are from the start of the file
+	size_t indexSize = 0;
+	size_t streamOffsets[MAX_VERTEX_STREAMS] = {};
+	size_t streamSizes[MAX_VERTEX_STREAMS] = {};
+};
+
+/**
+ * @brief Hashes the contents of a source file, to tell whether a mesh cache was made from it.
+ * The file is read 8 bytes at a time in four independent lanes, so hashing a large OBJ file
+ * takes a small fraction of the time parsing it does.
+ * @param[in] filePath Path to the file
+ * @param[out] hash Hash of the file
+ * @return true if the file was read, false otherwise
+ */
+bool HashMeshSource(const std::string& filePath, uint64_t& hash);
+
+/**
+ * @brief Returns the path of the mesh cache of a source file (the source path with MESH_CACHE_EXTENSION appended,
+ * e.g. model.obj -> model.obj.gmesh).
+ * @param[in] sourcePath Path to the file the mesh is imported from
+ * @return Path of the cache
+ */
+std::string GetMeshCachePath(const std::string& sourcePath);
+
+/**
+ * @brief Writes a mesh cache file.
+ * @param[in] filePath Path of the file to write
+ * @param[in] sourceHash HashMeshSource() of the file the mesh was imported from
+ * @param[in] flags MESH_CACHE_* flags that describe how the mesh was built
+ * @param[in] builder Builder with the mesh data (its vertex size has to be layout.stride)
+ * @param[in] layout Layout of the vertices
+ * @param[in] subMeshes Submeshes with their bounds (e.g. the ones of the Mesh that CreateMesh() made from the builder)
+ * @param[in] lods Levels of detail of the mesh (empty if it has none)
+ * @param[in] meshlets Meshlets of the levels of detail (empty if they were not split into meshlets)
+ * @return true if the file was written, false otherwise
+ */
+bool WriteMeshCache(const std::string& filePath, uint64_t sourceHash, uint32_t flags, const MeshBuilder& builder,
+	const VertexLayout& layout, const std::vector<SubMesh>& subMeshes, const std::vector<MeshLod>& lods,
+	const std::vector<Meshlet>& meshlets);
+
+/**
+ * @brief Reads the header and the tables of a mesh cache that is in memory (e.g. a MappedFile), and checks that it is valid.
+ * @param[in] data Contents of the file
+ * @param[in] size Size of the file
+ * @param[out] info Layout, submeshes, levels of detail, meshlets and blob offsets of the mesh
+ * @return true if the file is a valid mesh cache, false otherwise
+ */
+bool ReadMeshCache(const unsigned char* data, size_t size, MeshCacheInfo& info);
+
+/**
+ * @brief Creates a mesh from a mesh cache file, if the file exists and is up to date: it has to have been written
+ * from the same source, with the same flags and vertex layout. The file is mapped and its blobs go straight
+ * into the vertex and index buffers.
+ * @param[in] filePath Path of the cache
+ * @param[in] sourceHash HashMeshSource() of the file the mesh is imported from
+ * @param[in] flags MESH_CACHE_* flags that the mesh would be built with
+ * @param[in] layout Layout of the vertices
+ * @param[in] usage Buffer usage hint (e.g. GL_STATIC_DRAW)
+ * @param[out] mesh The created mesh
+ * @param[out] lods Levels of detail of the mesh
+ * @param[out] meshlets Meshlets of the levels of detail
+ * @return true if the mesh was created, false if the cache is missing, stale or invalid
+ */
+bool LoadMeshCache(const std::string& filePath, uint64_t sourceHash, uint32_t flags, const VertexLayout& layout, GLenum usage,
+	Mesh& mesh, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef GDEV_MESH_IMPORTER_H
+#define GDEV_MESH_IMPORTER_H
+
+#include <gdev/Mesh.h>
+#include <gdev/VertexLayout.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Attributes of the vertex layout that the importer writes (indices returned by AddVertexAttribute(), or -1 to
+ * leave them out). Normals and tangents that the file does not have are generated; missing UV-coordinates
+ * are (0, 0) and missing colors are white.
+ */
+struct MeshImportAttributes
+{
+	int position = -1;	// xyz, w = 1
+	int normal = -1;
+	int uv = -1;		// (0, 0) is the lower-left corner of the texture, as in the rest of the project
+	int color = -1;		// RGBA in [0, 1]
+	int tangent = -1;	// Direction of increasing u in xyz, and in w the sign of the bitangent: cross(normal, tangent) * w
+};
+
+/**
+ * @brief Imports a Wavefront OBJ (.obj) or binary glTF 2.0 (.glb) file into a mesh builder.
+ * The file is memory-mapped and parsed in place, without copying it or splitting it into lines.
+ *
+ * - OBJ: each object (o), group (g) or material (usemtl) becomes a submesh. Polygons are split into triangle fans.
+ *   Vertex colors are read from "v x y z r g b" lines. Vertices that share a position get smooth normals if
+ *   the faces have none.
+ * - glTF: each triangle primitive of each mesh becomes a submesh, in local space (node transforms are ignored).
+ *   The buffer has to be the binary chunk of the file; sparse accessors and compressed data are not supported.
+ *
+ * Vertices are merged twice: corners with the same OBJ indices are packed once, and MeshBuilder then merges
+ * the packed vertices that are identical.
+ * @param[in] filePath Path to the file
+ * @param[in] layout Layout of the vertices of the builder
+ * @param[in] attributes Attributes of the layout to fill in
+ * @param[in,out] builder Builder to add the vertices and submeshes to (its vertex size has to be layout.stride)
+ * @param[out] subMeshNames If not nullptr, gets the name of each submesh that was added (the OBJ group or glTF mesh)
+ * @return Index of the first submesh that was added, or -1 if the file could not be read
+ */
+int ImportMesh(const std::string& filePath, const VertexLayout& layout, const MeshImportAttributes& attributes,
+	MeshBuilder& builder, std::vector<std::string>* subMeshNames = nullptr);
+
+#endif
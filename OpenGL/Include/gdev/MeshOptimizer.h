@@ -0,0 +1,87 @@
+#ifndef GDEV_MESH_OPTIMIZER_H
+#define GDEV_MESH_OPTIMIZER_H
+
+#include <glad/glad.h>
+
+#include <gdev/Mesh.h>
+#include <gdev/VertexLayout.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Size of the FIFO post-transform vertex cache that ACMR is measured with (a typical size for desktop GPUs)
+const int ACMR_CACHE_SIZE = 16;
+
+/**
+ * Struct containing what OptimizeMesh() did
+ */
+struct MeshOptimizeStats
+{
+	size_t triangleCount = 0;	// Triangles that were reordered
+	size_t clusterCount = 0;	// Clusters that the overdraw pass sorted
+	float acmrBefore = 0.0f;	// Average cache miss ratio (vertex shader runs per triangle) before
+	float acmrAfter = 0.0f;		// ... and after
+};
+
+/**
+ * @brief Computes the average cache miss ratio of a triangle list: how many times the vertex shader runs per triangle
+ * with a FIFO post-transform cache. 3 is the worst; about 0.5 to 0.7 is the best that a closed mesh can get.
+ * @param[in] indices Indices of the triangles
+ * @param[in] indexCount Number of indices (a multiple of 3)
+ * @param[in] vertexCount Number of vertices (all indices are less than this)
+ * @param[in] cacheSize Number of vertices that the cache holds
+ * @return Cache misses per triangle (0 if there are no triangles)
+ */
+float ComputeAcmr(const GLuint* indices, size_t indexCount, size_t vertexCount, int cacheSize = ACMR_CACHE_SIZE);
+
+/**
+ * @brief Reorders triangles so that they reuse the vertices that the previous triangles left in the post-transform
+ * cache, with Tom Forsyth's linear-speed algorithm: each step emits the triangle whose vertices score highest,
+ * where vertices score higher the more recently they were used and the fewer triangles they have left.
+ * @param[out] destination Reordered indices (indexCount of them; must not be the same array as indices)
+ * @param[in] indices Indices of the triangles
+ * @param[in] indexCount Number of indices (a multiple of 3)
+ * @param[in] vertexCount Number of vertices (all indices are less than this)
+ */
+void OptimizeVertexCache(GLuint* destination, const GLuint* indices, size_t indexCount, size_t vertexCount);
+
+/**
+ * @brief Reorders clusters of triangles so that the ones facing out of the mesh are drawn first, where they hide
+ * the triangles behind them from the depth test (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+ * Locality and Reduced Overdraw", 2007). The indices should already be in vertex cache order: clusters are split
+ * where that order starts over with a cold cache, and more finely as long as the ACMR stays within the threshold.
+ * @param[out] destination Reordered indices (indexCount of them; must not be the same array as indices)
+ * @param[in] indices Indices of the triangles, in vertex cache order
+ * @param[in] indexCount Number of indices (a multiple of 3)
+ * @param[in] positions Position of each vertex
+ * @param[in] vertexCount Number of vertices (all indices are less than this)
+ * @param[in] threshold How much worse the ACMR may get for smaller clusters (e.g. 1.05 for 5% worse)
+ * @return Number of clusters
+ */
+size_t OptimizeOverdraw(GLuint* destination, const GLuint* indices, size_t indexCount, const glm::vec3* positions,
+	size_t vertexCount, float threshold);
+
+/**
+ * @brief Computes a new order of the vertices that follows the order the indices use them in, so that
+ * the vertex fetches of a draw read memory mostly from front to back. Vertices that no index uses go last.
+ * @param[out] remap New index of each vertex
+ * @param[in] indices Indices
+ * @param[in] indexCount Number of indices
+ * @param[in] vertexCount Number of vertices (all indices are less than this)
+ */
+void ComputeVertexFetchRemap(std::vector<GLuint>& remap, const GLuint* indices, size_t indexCount, size_t vertexCount);
+
+/**
+ * @brief Runs the three passes over a built mesh: vertex cache order and overdraw order for the triangles
+ * of each submesh, then vertex fetch order for the vertices. Submeshes keep drawing the same triangles,
+ * including ones made with CombineSubMeshes(). Submeshes that are not triangle lists are left as they are.
+ * @param[in,out] builder Builder with the mesh data
+ * @param[in] layout Layout of the vertices (the positions are the attribute at location 0)
+ * @param[in] overdrawThreshold See OptimizeOverdraw()
+ * @return ACMR before and after, and the sizes of the work done
+ */
+MeshOptimizeStats OptimizeMesh(MeshBuilder& builder, const VertexLayout& layout, float overdrawThreshold = 1.05f);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef GDEV_MESH_SIMPLIFIER_H
+#define GDEV_MESH_SIMPLIFIER_H
+
+#include <glad/glad.h>
+
+#include <gdev/Mesh.h>
+#include <gdev/VertexLayout.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// How much lower than the allowed pixel error the error of a coarser level of detail has to be before
+// SelectMeshLod() switches to it, so that an object near the switching distance does not pop back and forth
+const float LOD_HYSTERESIS = 0.25f;
+
+/**
+ * Struct containing one level of detail of a mesh
+ */
+struct MeshLod
+{
+	int subMesh = -1;		// Submesh with the triangles of the level
+	float error = 0.0f;		// How far the surface of the level may be from the full mesh, in the units of the mesh
+	int firstMeshlet = 0;	// Meshlets of the level, if it was split into meshlets (see Meshlet.h)
+	int meshletCount = 0;
+};
+
+/**
+ * @brief Simplifies a triangle list by collapsing edges in the order of their quadric error (Garland and Heckbert,
+ * "Surface Simplification Using Quadric Error Metrics", 1997). A vertex is only ever collapsed onto one of its
+ * neighbours, so the simplified triangles use the same vertices as the full mesh and can share its vertex buffer.
+ * Vertices on the border of the mesh and on attribute seams (several vertices with the same position, e.g. UV seams
+ * or hard edges) do not move, and collapses that would flip a triangle are skipped.
+ * @param[out] destination Simplified indices (room for indexCount of them)
+ * @param[in] indices Indices of the triangles
+ * @param[in] indexCount Number of indices (a multiple of 3)
+ * @param[in] positions Position of each vertex
+ * @param[in] vertexCount Number of vertices (all indices are less than this)
+ * @param[in] targetIndexCount Number of indices to simplify down to
+ * @param[out] error Largest distance that a collapse moved the surface, in the units of the positions
+ * @return Number of simplified indices (more than targetIndexCount if the mesh could not be simplified further)
+ */
+size_t SimplifyMesh(GLuint* destination, const GLuint* indices, size_t indexCount, const glm::vec3* positions, size_t vertexCount,
+	size_t targetIndexCount, float& error);
+
+/**
+ * @brief Makes levels of detail of a submesh, each with half the triangles of the one before, and adds them to
+ * the builder as submeshes that use the same vertices. Fewer levels are made if the mesh stops getting simpler.
+ * @param[in,out] builder Builder with the mesh data
+ * @param[in] layout Layout of the vertices (the positions are the attribute at location 0)
+ * @param[in] subMesh Submesh to simplify (a triangle list)
+ * @param[in] lodCount Number of simplified levels to make
+ * @return The levels of detail from the full submesh (error 0) to the simplest
+ */
+std::vector<MeshLod> GenerateMeshLods(MeshBuilder& builder, const VertexLayout& layout, int subMesh, int lodCount);
+
+/**
+ * @brief Computes how many pixels of the screen a length of one unit covers at a distance from the camera.
+ * @param[in] fieldOfViewY Vertical field of view of the projection in radians
+ * @param[in] viewportHeight Height of the viewport in pixels
+ * @param[in] distance Distance from the camera
+ * @return Pixels per unit
+ */
+float GetLodPixelsPerUnit(float fieldOfViewY, int viewportHeight, float distance);
+
+/**
+ * @brief Picks the simplest level of detail whose error covers at most maxPixelError pixels on the screen.
+ * A coarser level than the current one has to be LOD_HYSTERESIS below the limit to be picked.
+ * @param[in] lods Levels of detail, from the full mesh to the simplest
+ * @param[in] pixelsPerUnit Pixels that one unit of the mesh covers (see GetLodPixelsPerUnit(), times the scale of the object)
+ * @param[in] maxPixelError Largest error that may be visible, in pixels
+ * @param[in] currentLod Level that the object was drawn with in the last frame
+ * @return Index of the level to draw
+ */
+int SelectMeshLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxPixelError, int currentLod);
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef GDEV_MESHLET_H
+#define GDEV_MESHLET_H
+
+#include <glad/glad.h>
+
+#include <gdev/Bounds.h>
+#include <gdev/Frustum.h>
+#include <gdev/Mesh.h>
+#include <gdev/VertexLayout.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Largest meshlets that BuildMeshlets() makes (the sizes that mesh shader hardware likes, which also keeps
+// each meshlet small enough to be culled on its own)
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+/**
+ * Struct containing a meshlet: a run of triangles of the index buffer that use few vertices and face
+ * roughly the same way, with the bounds that CullMeshlets() tests it with
+ */
+struct Meshlet
+{
+	GLuint firstIndex = 0;		// First index of the run
+	GLsizei indexCount = 0;		// Number of indices in the run
+	BoundingSphere sphere;		// Bounds of the triangles
+	glm::vec3 coneApex = glm::vec3(0.0f);	// Normal cone: the meshlet faces away from any point p with
+	glm::vec3 coneAxis = glm::vec3(0.0f);	// dot(normalize(coneApex - p), coneAxis) > coneCutoff
+	float coneCutoff = 1.0f;	// Sine of the angle of the cone; 1 with a zero axis if the normals spread too far to cull
+};
+
+/**
+ * Struct containing the index ranges of one glMultiDrawElements() call
+ */
+struct MeshletDrawList
+{
+	std::vector<GLsizei> counts;		// Number of indices of each range
+	std::vector<const void*> offsets;	// Byte offset of each range in the index buffer
+};
+
+/**
+ * @brief Splits the triangles of a submesh into meshlets, in the order of the index buffer, so that the meshlets
+ * are ranges of it and the indices do not change. After OptimizeMesh() the triangles are in vertex cache order,
+ * which keeps the triangles of each meshlet next to each other on the surface.
+ * @param[in] builder Builder with the mesh data
+ * @param[in] layout Layout of the vertices (the positions are the attribute at location 0)
+ * @param[in] subMesh Submesh to split (a triangle list)
+ * @param[in,out] meshlets Meshlets to add to
+ * @return Number of meshlets that were added
+ */
+size_t BuildMeshlets(const MeshBuilder& builder, const VertexLayout& layout, int subMesh, std::vector<Meshlet>& meshlets);
+
+/**
+ * @brief Tests whether a meshlet may be visible: its sphere has to be at least partly inside the frustum,
+ * and the camera must not be behind all of its triangles.
+ * @param[in] meshlet Meshlet to test
+ * @param[in] frustum Frustum in the space of the mesh
+ * @param[in] cameraPosition Position of the camera in the space of the mesh
+ * @return true if the meshlet may be visible
+ */
+bool IsMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition);
+
+/**
+ * @brief Tests many meshlets like IsMeshletVisible(), four at a time with SSE when it is available.
+ * The cone test assumes that only the front faces can be seen, i.e. the mesh is closed or back faces are culled.
+ * The space of the mesh can be scaled uniformly, but not stretched, or the cones would change their angles.
+ * @param[in] meshlets Meshlets to test
+ * @param[in] meshletCount Number of meshlets
+ * @param[in] frustum Frustum in the space of the mesh (e.g. ExtractFrustum(projection * view * model))
+ * @param[in] cameraPosition Position of the camera in the space of the mesh
+ * @param[out] visible One flag per meshlet: 1 if it may be visible, 0 if it is culled
+ * @return Number of meshlets that may be visible
+ */
+size_t CullMeshlets(const Meshlet* meshlets, size_t meshletCount, const Frustum& frustum, const glm::vec3& cameraPosition,
+	unsigned char* visible);
+
+/**
+ * @brief Collects the index ranges of the visible meshlets for glMultiDrawElements(). Visible meshlets that are
+ * next to each other in the index buffer are merged into one range.
+ * @param[in] meshlets Meshlets
+ * @param[in] visible Visibility flag of each meshlet (from CullMeshlets())
+ * @param[in] meshletCount Number of meshlets
+ * @param[in] indexType Index type of the mesh (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+ * @param[out] drawList Index ranges to draw
+ * @return Number of ranges
+ */
+size_t CompactMeshletDraws(const Meshlet* meshlets, const unsigned char* visible, size_t meshletCount, GLenum indexType,
+	MeshletDrawList& drawList);
+
+/**
+ * @brief Draws the ranges of a draw list with one glMultiDrawElements() call. The VAO of the mesh must be bound.
+ * @param[in] mesh Mesh that the meshlets belong to
+ * @param[in] drawList Index ranges to draw (nothing is drawn if it is empty)
+ */
+void DrawMeshlets(const Mesh& mesh, const MeshletDrawList& drawList);
+
+#endif
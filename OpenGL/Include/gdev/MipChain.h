@@ -0,0 +1,38 @@
+#ifndef GDEV_MIP_CHAIN_H
+#define GDEV_MIP_CHAIN_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Struct containing the size and position of one mip level inside a mip chain
+ */
+struct MipLevel
+{
+	int width = 0;
+	int height = 0;
+	size_t offset = 0;	// Byte offset of the level's first row
+	size_t size = 0;	// Size of the level in bytes
+};
+
+/**
+ * @brief Computes the number of mip levels of a full mip chain (down to 1x1).
+ * @param[in] width Width of the base level
+ * @param[in] height Height of the base level
+ * @return Number of levels, including the base level
+ */
+int GetMipLevelCount(int width, int height);
+
+/**
+ * @brief Builds a mip chain out of an RGBA8 image. Each level is made with a 2x2 box filter from the level above it.
+ * The levels are stored one after another, each with tightly packed rows (which are 4-byte aligned, since pixels are 4 bytes).
+ * @param[in] pixels RGBA8 pixels of the base level
+ * @param[in] width Width of the base level
+ * @param[in] height Height of the base level
+ * @param[in] levelCount Number of levels to build (at most GetMipLevelCount(width, height); 1 = only the base level)
+ * @param[out] levels Size and position of each level
+ * @return Pixels of all levels
+ */
+std::vector<unsigned char> BuildMipChain(const unsigned char* pixels, int width, int height, int levelCount, std::vector<MipLevel>& levels);
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef GDEV_OCCLUSION_CULLING_H
+#define GDEV_OCCLUSION_CULLING_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Most objects that one occlusion query can cover (see OcclusionCuller::BeginQuery())
+const int MAX_OCCLUSION_QUERY_OBJECTS = 8;
+
+/**
+ * Occlusion culling with GL_ANY_SAMPLES_PASSED queries that uses the visibility of earlier frames, like
+ * coherent hierarchical culling (CHC++) does, but for a flat list of objects instead of the nodes of a hierarchy.
+ *
+ * Each frame, the objects that were visible are drawn, and the objects that were hidden are only tested:
+ * their bounding boxes are drawn without color and depth writes inside a query, after everything else,
+ * so that the whole visible scene can hide them. The results are read in the following frames, only once
+ * the GPU has them, so the CPU does not wait for the GPU unless a query is MAX_QUERY_LATENCY frames old.
+ *
+ * - Visible objects are only tested every few frames, with a query around their real draw call.
+ * - Hidden objects are tested every frame. Several hidden objects can share one query, and they are only
+ *   tested one by one again if that query finds that one of them became visible.
+ * - Objects are identified by an index that has to stay the same from frame to frame.
+ *   Objects that were not looked at last frame (e.g. because they were outside the frustum) count as visible.
+ */
+class OcclusionCuller
+{
+public:
+	OcclusionCuller() = default;
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	/**
+	 * @brief Starts a new frame: reads the results of the queries that are done, and waits for the ones that are
+	 * too old (the waiting time is added to FrameCounter::OcclusionStallMicroseconds).
+	 */
+	void BeginFrame();
+
+	/**
+	 * @brief Returns whether an object was visible the last time it was tested, and marks it as looked at this frame.
+	 * Call this once per frame for each object that is inside the view frustum.
+	 * @param[in] object Index of the object
+	 * @return false if the object is hidden and does not need to be drawn
+	 */
+	bool IsVisible(int object);
+
+	/**
+	 * @brief Returns whether an object should be tested this frame.
+	 * @param[in] object Index of the object
+	 * @return true if the object has no query in flight and it is time to test it again
+	 */
+	bool IsQueryDue(int object) const;
+
+	/**
+	 * @brief Returns whether an object has been hidden long enough to share a query with other hidden objects.
+	 * @param[in] object Index of the object
+	 * @return true if the object is likely to stay hidden
+	 */
+	bool CanShareQuery(int object) const;
+
+	/**
+	 * @brief Starts a query for one or more objects. Everything drawn until EndQuery() counts for all of them:
+	 * if any sample passes the depth test, all of them become visible.
+	 * @param[in] objects Indices of the objects
+	 * @param[in] objectCount Number of objects (at most MAX_OCCLUSION_QUERY_OBJECTS)
+	 */
+	void BeginQuery(const int* objects, int objectCount);
+
+	/**
+	 * @brief Ends the query started with BeginQuery().
+	 */
+	void EndQuery();
+
+	/**
+	 * @brief Deletes the query objects. Requires the OpenGL context to still exist.
+	 */
+	void Delete();
+
+private:
+	/**
+	 * Struct containing what is known about the visibility of one object
+	 */
+	struct ObjectState
+	{
+		int lastLookedAtFrame = -2;	// Frame in which IsVisible() was last called for the object
+		int nextQueryFrame = 0;		// Visible objects are not tested again before this frame
+		int hiddenQueryCount = 0;	// Number of queries in a row that found the object hidden
+		bool visible = true;
+		bool queryPending = false;
+	};
+
+	/**
+	 * Struct containing a query whose result has not been read yet
+	 */
+	struct PendingQuery
+	{
+		GLuint query;
+		int frame;		// Frame in which the query was issued
+		int objects[MAX_OCCLUSION_QUERY_OBJECTS];
+		int objectCount;
+	};
+
+	void ApplyResult(const PendingQuery& pendingQuery, bool anySamplesPassed);
+
+	std::vector<ObjectState> objectStates;
+	std::vector<PendingQuery> pendingQueries;	// In the order they were issued
+	std::vector<GLuint> freeQueries;			// Query objects that can be reused
+	std::vector<GLuint> allQueries;				// Every query object that was created, for Delete()
+	int frameIndex = 0;
+};
+
+/**
+ * @brief Sets up the state for drawing bounding boxes into occlusion queries: depth test with GL_LEQUAL,
+ * but no color or depth writes.
+ */
+void BeginOcclusionBoxes();
+
+/**
+ * @brief Restores the default state after BeginOcclusionBoxes() (color and depth writes with GL_LESS).
+ */
+void EndOcclusionBoxes();
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef GDEV_RENDER_QUEUE_H
+#define GDEV_RENDER_QUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Passes that a draw can be submitted to, in the order that they are drawn
+ */
+enum class RenderPass
+{
+	Depth,		// Depth pre-pass (front to back)
+	Opaque,		// Shading of opaque objects (grouped by program and texture, then front to back)
+	Count
+};
+
+/**
+ * Bit layout of a sort key, from the most significant bits to the least significant:
+ * pass (4 bits) | program (8 bits) | texture (12 bits) | depth (24 bits) | mesh (16 bits)
+ * Sorting the keys orders the draws by pass, then groups them by program and texture to save state changes,
+ * and draws each group front to back so that the depth test can reject hidden fragments early.
+ */
+const int SORT_KEY_MESH_BITS = 16;
+const int SORT_KEY_DEPTH_BITS = 24;
+const int SORT_KEY_TEXTURE_BITS = 12;
+const int SORT_KEY_PROGRAM_BITS = 8;
+const int SORT_KEY_PASS_BITS = 4;
+
+/**
+ * @brief Packs the fields of a draw into a sort key. Fields that are too large for their bits are truncated.
+ * @param[in] pass Pass of the draw
+ * @param[in] program Index of the shader program (not the OpenGL handle)
+ * @param[in] texture Index or handle of the texture
+ * @param[in] depth Distance from the camera, from 0 (near) to 1 (far); clamped
+ * @param[in] mesh Index of the mesh or submesh
+ * @return The sort key
+ */
+unsigned long long MakeSortKey(RenderPass pass, unsigned int program, unsigned int texture, float depth, unsigned int mesh);
+
+/**
+ * @brief Returns the pass of a sort key made by MakeSortKey().
+ * @param[in] key Sort key
+ * @return Pass of the draw
+ */
+RenderPass GetSortKeyPass(unsigned long long key);
+
+/**
+ * Struct containing a draw in the render queue
+ */
+struct RenderQueueItem
+{
+	unsigned long long key;	// See MakeSortKey()
+	unsigned int payload;	// What to draw, e.g. an index into an array of draws kept by the caller
+};
+
+/**
+ * A list of draws that is filled during the frame, sorted by key, and then drawn in order.
+ * The memory is allocated up front, so submitting and sorting do not allocate unless the capacity is exceeded.
+ */
+class RenderQueue
+{
+public:
+	/**
+	 * @param[in] capacity Number of draws to allocate memory for
+	 */
+	explicit RenderQueue(size_t capacity);
+
+	/**
+	 * @brief Removes all draws, keeping the memory.
+	 */
+	void Clear() { count = 0; }
+
+	/**
+	 * @brief Adds a draw. The queue grows if it is full.
+	 * @param[in] key Sort key (see MakeSortKey())
+	 * @param[in] payload What to draw
+	 */
+	void Submit(unsigned long long key, unsigned int payload);
+
+	/**
+	 * @brief Sorts the draws by key with a radix sort (8 bits per pass, stable).
+	 * Passes where every key has the same byte are skipped.
+	 */
+	void Sort();
+
+	size_t GetCount() const { return count; }
+	const RenderQueueItem* begin() const { return items.data(); }
+	const RenderQueueItem* end() const { return items.data() + count; }
+
+private:
+	std::vector<RenderQueueItem> items;
+	std::vector<RenderQueueItem> sortBuffer;	// Second buffer that the radix sort passes move the items into
+	size_t count = 0;
+};
+
+#endif
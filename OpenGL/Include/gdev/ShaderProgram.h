@@ -0,0 +1,113 @@
+#ifndef GDEV_SHADER_PROGRAM_H
+#define GDEV_SHADER_PROGRAM_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Struct containing data about an active uniform of a shader program
+ */
+struct ShaderUniform
+{
+	std::string name;			// Name without the "[0]" suffix of arrays
+	unsigned int nameHash = 0;	// HashUniformName() of the name
+	GLint location = -1;		// Uniform location (-1 for uniforms inside uniform blocks)
+	GLenum type = GL_NONE;		// GLSL type, e.g. GL_FLOAT_MAT4
+	GLint size = 0;				// Number of array elements (1 if not an array)
+	bool hasValue = false;		// Whether 'value' holds what was last sent to OpenGL
+	unsigned char value[64];	// Last value sent to OpenGL (large enough for a mat4)
+};
+
+/**
+ * A linked shader program together with a table of its active uniforms.
+ * The uniforms are looked up once when the program is created, so setting a uniform never calls
+ * glGetUniformLocation(), and a value that has not changed since the last call is not sent again.
+ *
+ * Like glUniform*(), the SetUniform() functions change the program that is currently in use,
+ * so call UseProgram(program.id) (see StateCache.h) first.
+ */
+struct ShaderProgram
+{
+	GLuint id = 0;	// OpenGL handle to the program
+	std::vector<ShaderUniform> uniforms;
+	// Hash table of the uniforms by name: each slot holds an index into 'uniforms' (-1 if empty). A lookup starts
+	// at the slot of the name hash and moves on to the next slot until the name matches, so names whose hashes
+	// collide are all found. Its size is a power of two, at least twice the number of uniforms.
+	std::vector<int> uniformSlots;
+
+	/**
+	 * @brief Finds an active uniform by name.
+	 * @param[in] name Uniform name
+	 * @return Index of the uniform, or -1 if the program has no active uniform with that name
+	 */
+	int FindUniform(const char* name) const;
+
+	/**
+	 * @brief Returns the location of an active uniform without asking OpenGL.
+	 * @param[in] name Uniform name
+	 * @return Uniform location, or -1 if the program has no active uniform with that name
+	 */
+	GLint GetUniformLocation(const char* name) const;
+
+	/**
+	 * @brief Sets a uniform of the program, skipping the OpenGL call if the value did not change.
+	 * Setting a uniform that is not active (e.g. optimized out by the compiler) does nothing.
+	 * @param[in] name Uniform name
+	 * @param[in] value New value
+	 */
+	void SetUniform(const char* name, int value);
+	void SetUniform(const char* name, float value);
+	void SetUniform(const char* name, const glm::vec3& value);
+	void SetUniform(const char* name, const glm::vec4& value);
+	void SetUniform(const char* name, const glm::mat3& value);
+	void SetUniform(const char* name, const glm::mat4& value);
+
+	/**
+	 * @brief Attaches a uniform block of the program to a binding point (GLSL 330 has no layout(binding = N)).
+	 * Does nothing if the program has no active block with that name.
+	 * @param[in] blockName Name of the uniform block
+	 * @param[in] bindingPoint Binding point that the uniform buffer is bound to
+	 */
+	void BindUniformBlock(const char* blockName, GLuint bindingPoint);
+
+private:
+	ShaderUniform* PrepareUpdate(const char* name, GLenum type, const void* value, size_t valueSize);
+};
+
+/**
+ * @brief Computes the hash used to look up uniform names (32-bit FNV-1a).
+ * @param[in] name Name to hash
+ * @return Hash of the name
+ */
+unsigned int HashUniformName(const char* name);
+
+/**
+ * @brief Creates a shader program based on the provided file paths for the vertex and fragment shaders,
+ * and reads the list of its active uniforms.
+ * @param[in] vertexShaderFilePath Vertex shader file path
+ * @param[in] fragmentShaderFilePath Fragment shader file path
+ * @return The created shader program
+ */
+ShaderProgram CreateShaderProgram(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
+
+/**
+ * @brief Creates a shader based on the provided shader type and the path to the file containing the shader source.
+ * @param[in] shaderType Shader type
+ * @param[in] shaderFilePath Path to the file containing the shader source
+ * @return OpenGL handle to the created shader
+ */
+GLuint CreateShaderFromFile(const GLuint& shaderType, const std::string& shaderFilePath);
+
+/**
+ * @brief Creates a shader based on the provided shader type and the string containing the shader source.
+ * @param[in] shaderType Shader type
+ * @param[in] shaderSource Shader source string
+ * @return OpenGL handle to the created shader
+ */
+GLuint CreateShaderFromSource(const GLuint& shaderType, const std::string& shaderSource);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef GDEV_STATE_CACHE_H
+#define GDEV_STATE_CACHE_H
+
+#include <glad/glad.h>
+
+/**
+ * A shadow copy of the OpenGL bindings that change most often during a frame (program, vertex array, textures).
+ * The functions below work like the OpenGL calls they wrap, but skip the call if the same object is already bound,
+ * and count issued and skipped calls in the frame stats (FrameCounter::StateChanges and StateChangesSkipped).
+ *
+ * The cache only knows about changes made through these functions, so code that binds these objects directly
+ * (or deletes a bound object, which unbinds it) has to call InvalidateStateCache() afterwards.
+ * There is one cache for the current OpenGL context.
+ */
+
+// Number of texture units whose bindings are cached (binding a higher unit is never skipped)
+const GLuint STATE_CACHE_TEXTURE_UNITS = 16;
+
+/**
+ * @brief Same as glUseProgram(), but skipped if the program is already in use.
+ * @param[in] program Program to use
+ */
+void UseProgram(GLuint program);
+
+/**
+ * @brief Same as glBindVertexArray(), but skipped if the vertex array object is already bound.
+ * @param[in] vertexArray Vertex array object to bind
+ */
+void BindVertexArray(GLuint vertexArray);
+
+/**
+ * @brief Binds a texture to a texture unit: glActiveTexture() and glBindTexture(), each skipped if it would not
+ * change anything. Only GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY and GL_TEXTURE_CUBE_MAP bindings are cached.
+ * @param[in] unit Texture unit (0 for GL_TEXTURE0)
+ * @param[in] target Texture target (e.g. GL_TEXTURE_2D)
+ * @param[in] texture Texture to bind
+ */
+void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+/**
+ * @brief Forgets all cached bindings, so that the next call of each function is issued.
+ */
+void InvalidateStateCache();
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef GDEV_STREAM_BUFFER_H
+#define GDEV_STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+// Number of parts a stream buffer is split into: the CPU writes one while the GPU may still be reading the others
+const int STREAM_BUFFER_FRAME_COUNT = 3;
+
+/**
+ * Struct containing a buffer for data that is written every frame (per-frame uniforms, instance data,
+ * dynamic vertices), used as a ring of STREAM_BUFFER_FRAME_COUNT parts, one per frame.
+ *
+ * The part of the current frame is mapped with GL_MAP_UNSYNCHRONIZED_BIT, so mapping never waits for the GPU
+ * to finish the draws that read the buffer. A fence after the last draw of each frame tells us when the GPU
+ * is done with a part, and we only wait for it when we come back around to that part, three frames later.
+ *
+ * Data can go in any binding of the buffer: glBindBufferRange() for uniform blocks, or a vertex attribute offset.
+ * The buffer has to be unmapped (UnmapStreamBuffer()) before the draws that read it.
+ */
+struct StreamBuffer
+{
+	GLuint id = 0;						// OpenGL handle to the buffer
+	GLsizeiptr frameSize = 0;			// Size of the part that one frame writes
+	GLsizeiptr uniformAlignment = 256;	// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, for data read by uniform blocks
+	int frame = 0;						// Part of the buffer that the current frame writes
+	GLsync fences[STREAM_BUFFER_FRAME_COUNT] = {};	// Signaled when the GPU is done with the draws of each part
+	GLintptr writeOffset = 0;			// Offset of the next write, from the start of the current part
+	GLintptr mappedOffset = 0;			// Start of the mapped range, from the start of the current part
+	unsigned char* mapped = nullptr;	// Mapped memory, or nullptr if the buffer is not mapped
+};
+
+/**
+ * @brief Creates a stream buffer.
+ * @param[in] frameSize Most bytes that are written in one frame (including padding for alignment)
+ * @return The created stream buffer
+ */
+StreamBuffer CreateStreamBuffer(GLsizeiptr frameSize);
+
+/**
+ * @brief Reserves room in the part of the current frame and maps it if it is not mapped yet.
+ * The first write of a frame waits for the GPU if it is still reading the part from three frames ago
+ * (the waiting time is added to FrameCounter::StreamBufferStallMicroseconds).
+ * @param[in,out] buffer Buffer to write to
+ * @param[in] size Number of bytes
+ * @param[in] alignment The offset is a multiple of this (e.g. buffer.uniformAlignment for glBindBufferRange())
+ * @param[out] offset Offset of the reserved bytes from the start of the buffer
+ * @return Pointer to write the bytes to, or nullptr if the part of this frame is full
+ */
+void* AllocateStreamBuffer(StreamBuffer& buffer, GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset);
+
+/**
+ * @brief Copies data into the part of the current frame (see AllocateStreamBuffer()).
+ * @param[in,out] buffer Buffer to write to
+ * @param[in] data Data to copy
+ * @param[in] size Number of bytes
+ * @param[in] alignment The offset is a multiple of this
+ * @return Offset of the data from the start of the buffer, or -1 if the part of this frame is full
+ */
+GLintptr WriteStreamBuffer(StreamBuffer& buffer, const void* data, GLsizeiptr size, GLsizeiptr alignment);
+
+/**
+ * @brief Flushes the bytes written since the buffer was mapped and unmaps it, so that draws can read them.
+ * Does nothing if the buffer is not mapped. Later writes in the same frame map the rest of the part again.
+ * @param[in,out] buffer Buffer to unmap
+ */
+void UnmapStreamBuffer(StreamBuffer& buffer);
+
+/**
+ * @brief Call after the last draw that reads the buffer in this frame: adds a fence for the part of this frame,
+ * and moves on to the next part.
+ * @param[in,out] buffer Buffer to advance
+ */
+void EndStreamBufferFrame(StreamBuffer& buffer);
+
+/**
+ * @brief Deletes the stream buffer and its fences.
+ * @param[in] buffer Buffer to delete
+ */
+void DeleteStreamBuffer(StreamBuffer& buffer);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef GDEV_TEXTURE_LOADER_H
+#define GDEV_TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <gdev/CookedTexture.h>
+#include <gdev/MappedFile.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Loads image files into textures in the background.
+ * Worker threads decode the images with stb_image at the same time, build their mip chains,
+ * and hand the pixels back to the OpenGL thread through a list guarded by the same mutex as the queue. The OpenGL thread
+ * takes the whole list under that mutex and uploads the images through a pixel buffer object whenever Update() or
+ * WaitAll() is called; WaitAll() sleeps on a condition variable until a worker adds to the list.
+ * Cooked textures (.gtex files, see CookedTexture.h) are memory-mapped and uploaded as they are, without decoding.
+ *
+ * Load(), Update() and WaitAll() need the OpenGL context to be current; the destructor only stops the threads.
+ */
+class TextureLoader
+{
+public:
+	/**
+	 * @brief Starts the worker threads.
+	 * @param[in] threadCount Number of worker threads (0 = one per CPU core)
+	 * @param[in] generateMipmaps Build a full mip chain and sample it with GL_LINEAR_MIPMAP_LINEAR
+	 * (otherwise only the base level is uploaded and sampled with GL_LINEAR)
+	 */
+	TextureLoader(int threadCount, bool generateMipmaps);
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	/**
+	 * @brief Creates a texture and queues its image file for loading.
+	 * The texture has no image until the file has been decoded and uploaded.
+	 * @param[in] filePath Path to the image file or cooked texture
+	 * @param[in] flipVertically Flip the image so that its first row is at v = 0 (what the u-v coordinates expect).
+	 * Cooked textures were already flipped when they were cooked.
+	 * @return OpenGL handle to the texture
+	 */
+	GLuint Load(const std::string& filePath, bool flipVertically = true);
+
+	/**
+	 * @brief Uploads the images that have been decoded since the last call, without waiting for the others.
+	 * @return Number of textures that were uploaded
+	 */
+	int Update();
+
+	/**
+	 * @brief Waits until every queued image is decoded and uploaded, then frees the upload buffer.
+	 * The OpenGL thread sleeps while the workers decode, and wakes up to upload each image they finish.
+	 */
+	void WaitAll();
+
+	int GetThreadCount() const { return static_cast<int>(workers.size()); }
+
+private:
+	/**
+	 * An image that is queued, being decoded, or waiting to be uploaded
+	 */
+	struct ImageJob
+	{
+		std::string filePath;
+		GLuint texture = 0;
+		bool flipVertically = true;
+		std::vector<unsigned char> pixels;	// Decoded RGBA8 mip chain (empty for cooked textures)
+		MappedFile cookedFile;				// Mapped cooked texture (empty for decoded images)
+		CookedTextureInfo info;				// Format and levels; the level offsets are from levelData
+		const unsigned char* levelData = nullptr;	// pixels.data() or cookedFile.data (nullptr if loading failed)
+
+		~ImageJob() { CloseMappedFile(cookedFile); }
+	};
+
+	void WorkerMain();
+	void Upload(const ImageJob& job);
+
+	bool generateMipmaps;
+	std::vector<std::thread> workers;
+
+	// Images waiting for a worker
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::deque<ImageJob*> queuedJobs;
+	bool stopping = false;
+
+	// Decoded images in the order they were decoded (guarded by queueMutex); the OpenGL thread takes the whole list at once
+	std::vector<ImageJob*> decodedJobs;
+	std::condition_variable jobDecoded;	// Notified when a worker adds to decodedJobs
+
+	int pendingJobCount = 0;	// Jobs that were queued but not uploaded yet (only used by the OpenGL thread)
+	GLuint uploadBuffer = 0;	// Pixel buffer object used to upload the images
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef GDEV_TRANSFORM_H
+#define GDEV_TRANSFORM_H
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief Computes the matrix that transforms normals from local space to world space,
+ * i.e. transpose(inverse(mat3(modelMatrix))), without doing a full 4x4 inverse.
+ * Rotations, translations and (non-uniform) scales along the local axes take a fast path;
+ * the result is the rotation part itself for rigid transforms.
+ * @param[in] modelMatrix Model matrix (local space -> world space)
+ * @return The normal matrix
+ */
+glm::mat3 ComputeNormalMatrix(const glm::mat4& modelMatrix);
+
+#endif
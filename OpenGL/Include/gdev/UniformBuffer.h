@@ -0,0 +1,121 @@
+#ifndef GDEV_UNIFORM_BUFFER_H
+#define GDEV_UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+// Binding points of the uniform blocks that our shaders use
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+const GLuint MATERIAL_UNIFORMS_BINDING = 1;
+const GLuint MATERIAL_ARRAY_UNIFORMS_BINDING = 2;
+
+// Size of the material array used by instanced draws
+const int MAX_MATERIALS = 16;
+
+/**
+ * Per-frame data, matching this std140 block in the shaders:
+ *
+ * layout(std140) uniform FrameUniforms
+ * {
+ *     mat4 viewMatrix;
+ *     mat4 projectionMatrix;
+ *     vec3 cameraPosition;
+ *     vec3 lightPos;
+ * };
+ */
+struct FrameUniforms
+{
+	glm::mat4 viewMatrix;
+	glm::mat4 projectionMatrix;
+	glm::vec3 cameraPosition;
+	float padding0;				// std140 aligns vec3 to 16 bytes
+	glm::vec3 lightPos;
+	float padding1;
+};
+
+static_assert(sizeof(FrameUniforms) == 160, "FrameUniforms must match the std140 layout");
+
+/**
+ * Phong material data, matching this std140 block in the shaders:
+ *
+ * layout(std140) uniform MaterialUniforms
+ * {
+ *     vec3 ambientIntensity;
+ *     float ambientComponent;
+ *     vec3 diffuseIntensity;
+ *     float diffuseComponent;
+ *     vec3 specularIntensity;
+ *     float specularComponent;
+ *     float shine;
+ * };
+ */
+struct MaterialUniforms
+{
+	glm::vec3 ambientIntensity;
+	float ambientComponent;
+	glm::vec3 diffuseIntensity;
+	float diffuseComponent;
+	glm::vec3 specularIntensity;
+	float specularComponent;
+	float shine;
+	float padding[3];			// std140 rounds the block size up to 16 bytes
+};
+
+static_assert(sizeof(MaterialUniforms) == 64, "MaterialUniforms must match the std140 layout");
+
+/*
+ * Instanced draws pick their material from an array, which uses the same struct layout
+ * (std140 array elements of a struct are 64 bytes apart, just like sizeof(MaterialUniforms)):
+ *
+ * layout(std140) uniform MaterialArrayUniforms
+ * {
+ *     Material materials[MAX_MATERIALS];
+ * };
+ */
+
+/**
+ * Struct containing a uniform buffer object that holds one or more copies of a uniform block
+ */
+struct UniformBuffer
+{
+	GLuint id = 0;				// OpenGL handle to the buffer
+	GLuint bindingPoint = 0;	// Binding point the block is attached to
+	GLsizeiptr elementSize = 0;	// Size of one copy of the block
+	GLsizeiptr stride = 0;		// Distance between copies (elementSize rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+	GLsizei elementCount = 0;	// Number of copies in the buffer
+};
+
+/**
+ * @brief Creates a uniform buffer with room for a number of copies of a uniform block.
+ * If there is only one copy, the whole buffer is bound to the binding point right away.
+ * @param[in] bindingPoint Binding point the block is attached to
+ * @param[in] elementSize Size of the block (e.g. sizeof(FrameUniforms))
+ * @param[in] elementCount Number of copies
+ * @param[in] usage Usage hint (GL_DYNAMIC_DRAW for data that changes every frame, GL_STATIC_DRAW otherwise)
+ * @return The created uniform buffer
+ */
+UniformBuffer CreateUniformBuffer(GLuint bindingPoint, GLsizeiptr elementSize, GLsizei elementCount, GLenum usage);
+
+/**
+ * @brief Writes one copy of the uniform block with a single buffer update.
+ * @param[in] buffer Buffer to write to
+ * @param[in] elementIndex Copy to write
+ * @param[in] data Block data (elementSize bytes)
+ */
+void UpdateUniformBuffer(const UniformBuffer& buffer, GLsizei elementIndex, const void* data);
+
+/**
+ * @brief Attaches one copy of the uniform block to the binding point, so that the next draws use it.
+ * @param[in] buffer Buffer to bind
+ * @param[in] elementIndex Copy to bind
+ */
+void BindUniformBuffer(const UniformBuffer& buffer, GLsizei elementIndex);
+
+/**
+ * @brief Deletes the uniform buffer.
+ * @param[in] buffer Buffer to delete
+ */
+void DeleteUniformBuffer(UniformBuffer& buffer);
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef GDEV_VERTEX_LAYOUT_H
+#define GDEV_VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Formats that a vertex attribute can be stored in on the GPU.
+ * Every format is a multiple of 4 bytes, so attributes never need padding between them.
+ */
+enum class VertexAttributeFormat
+{
+	Float2,		// 2 x 32-bit float (8 bytes)
+	Float3,		// 3 x 32-bit float (12 bytes)
+	Float4,		// 4 x 32-bit float (16 bytes)
+	Half2,		// 2 x 16-bit float (4 bytes), e.g. UV-coordinates
+	Half4,		// 4 x 16-bit float (8 bytes), e.g. positions (w = 1)
+	Snorm16x2,	// 2 x 16-bit signed normalized (4 bytes), for values in [-1, 1]
+	Snorm16x4,	// 4 x 16-bit signed normalized (8 bytes), for values in [-1, 1]
+	Unorm8x4,	// 4 x 8-bit unsigned normalized (4 bytes), e.g. RGBA8 colors
+	Snorm10x3,	// 3 x 10-bit signed normalized + 2 unused bits (4 bytes, GL_INT_2_10_10_10_REV), e.g. normals
+};
+
+// Maximum number of vertex buffers (streams) that the attributes of a layout can be split into
+static const int MAX_VERTEX_STREAMS = 4;
+
+// Stream masks for SetVertexLayout(); bit N selects stream N
+static const GLuint ALL_VERTEX_STREAMS = (1u << MAX_VERTEX_STREAMS) - 1;
+
+/**
+ * Struct containing one attribute of a vertex layout
+ */
+struct VertexAttribute
+{
+	GLuint location = 0;		// Attribute location in the vertex shader
+	VertexAttributeFormat format = VertexAttributeFormat::Float3;
+	GLuint offset = 0;			// Byte offset inside the packed vertex (all streams together)
+	GLuint stream = 0;			// Vertex buffer that the attribute is stored in
+	GLuint streamOffset = 0;	// Byte offset inside the vertex of its stream
+};
+
+/**
+ * Describes how vertices are stored in vertex buffers. The shaders always see floats,
+ * so changing the format of an attribute does not require changing the shaders.
+ *
+ * Vertices are packed and merged with all of their attributes together (see MeshBuilder), but the
+ * attributes can be split into several streams on the GPU. For example, with the position in stream 0
+ * and everything else in stream 1, a depth-only pass reads nothing but the positions.
+ */
+struct VertexLayout
+{
+	std::vector<VertexAttribute> attributes;
+	GLsizei stride = 0;			// Size of one packed vertex in bytes (all streams together)
+	int streamCount = 1;
+	GLsizei streamStrides[MAX_VERTEX_STREAMS] = {};	// Size of the vertex of each stream in bytes
+};
+
+/**
+ * @brief Appends an attribute to the end of a vertex layout.
+ * @param[in] layout Layout to add to
+ * @param[in] location Attribute location in the vertex shader
+ * @param[in] format Format to store the attribute in
+ * @param[in] stream Vertex buffer to store the attribute in (0 to MAX_VERTEX_STREAMS - 1)
+ * @return Index of the new attribute, or -1 if the stream is out of range
+ */
+int AddVertexAttribute(VertexLayout& layout, GLuint location, VertexAttributeFormat format, GLuint stream = 0);
+
+/**
+ * @brief Converts an attribute value to the attribute's format and writes it into a vertex.
+ * Values are clamped to the range of normalized formats; unused components are ignored.
+ * @param[in] layout Layout of the vertex
+ * @param[in] attributeIndex Attribute to write (as returned by AddVertexAttribute())
+ * @param[in] value Attribute value
+ * @param[out] vertex Start of the vertex (layout.stride bytes)
+ */
+void PackVertexAttribute(const VertexLayout& layout, int attributeIndex, const glm::vec4& value, unsigned char* vertex);
+
+/**
+ * @brief Reads an attribute value back out of a packed vertex (the inverse of PackVertexAttribute()).
+ * @param[in] layout Layout of the vertex
+ * @param[in] attributeIndex Attribute to read
+ * @param[in] vertex Start of the vertex (layout.stride bytes)
+ * @return Attribute value; components that the format does not have are 0 (and w is 1)
+ */
+glm::vec4 UnpackVertexAttribute(const VertexLayout& layout, int attributeIndex, const unsigned char* vertex);
+
+/**
+ * @brief Finds the attribute that is read from a given location.
+ * @param[in] layout Layout to search
+ * @param[in] location Attribute location in the vertex shader
+ * @return Index of the attribute, or -1 if the layout has no attribute at that location
+ */
+int FindVertexAttribute(const VertexLayout& layout, GLuint location);
+
+/**
+ * @brief Copies the attributes of one stream out of packed vertices.
+ * @param[in] layout Layout of the vertices
+ * @param[in] vertices Packed vertices (layout.stride bytes each)
+ * @param[in] vertexCount Number of vertices
+ * @param[in] stream Stream to copy
+ * @param[out] streamData Vertices of the stream (layout.streamStrides[stream] bytes each)
+ */
+void ExtractVertexStream(const VertexLayout& layout, const unsigned char* vertices, size_t vertexCount, int stream,
+	std::vector<unsigned char>& streamData);
+
+/**
+ * @brief Copies the attributes of one stream out of packed vertices into memory that is already allocated,
+ * e.g. a mapped buffer.
+ * @param[in] layout Layout of the vertices
+ * @param[in] vertices Packed vertices (layout.stride bytes each)
+ * @param[in] vertexCount Number of vertices
+ * @param[in] stream Stream to copy
+ * @param[out] streamData Vertices of the stream (room for vertexCount * layout.streamStrides[stream] bytes)
+ */
+void ExtractVertexStream(const VertexLayout& layout, const unsigned char* vertices, size_t vertexCount, int stream,
+	unsigned char* streamData);
+
+/**
+ * @brief Sets up glVertexAttribPointer() for the attributes of the layout, in the vertex array object that is bound.
+ * Attributes of streams that are not in the mask are left disabled, so a pass that only needs some of the
+ * attributes can have its own vertex array object that does not fetch the others.
+ * @param[in] layout Layout of the vertices
+ * @param[in] vertexBuffers Buffer of each stream of the layout
+ * @param[in] streamMask Streams to set up (bit N selects stream N)
+ * @param[in] streamOffsets Byte offset of the first vertex in the buffer of each stream (nullptr if they all start at 0)
+ */
+void SetVertexLayout(const VertexLayout& layout, const GLuint* vertexBuffers, GLuint streamMask = ALL_VERTEX_STREAMS,
+	const GLintptr* streamOffsets = nullptr);
+
+#endif
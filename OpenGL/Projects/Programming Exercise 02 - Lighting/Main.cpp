@@ -3,15 +3,13 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <string>
-
-// Include stb_image for loading images
-// Remember to define STB_IMAGE_IMPLEMENTATION first before including
-// to avoid linker errors
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <vector>
 
 // We include glm to give us access to vectors (glm::vec3) and matrices (glm::mat4)
 #include <glm/glm.hpp>
@@ -19,72 +17,212 @@
 #include <glm/gtc/matrix_transform.hpp>
 // This gives us access to the glm::value_ptr() function, which converts a vector/matrix to a pointer that OpenGL accepts
 #include <glm/gtc/type_ptr.hpp>
+// This gives us access to glm::two_pi(), which we use for the waves of the animated grid
+#include <glm/gtc/constants.hpp>
+// This gives us access to glm::intersectRayTriangle(), which we use for picking objects with the mouse
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/intersect.hpp>
+
+// Headless rendering and frame statistics for benchmarking
+#include <gdev/Benchmark.h>
+#include <gdev/BenchmarkOptions.h>
+#include <gdev/HeadlessContext.h>
+// Shader programs with cached uniform locations
+#include <gdev/ShaderProgram.h>
+// Uniform buffer objects for per-frame and per-material data
+#include <gdev/UniformBuffer.h>
+// Indexed meshes
+#include <gdev/Mesh.h>
+// Textures loaded on worker threads (this is where stb_image is used now)
+#include <gdev/TextureLoader.h>
+// Per-instance data for instanced draws
+#include <gdev/InstanceBuffer.h>
+// Normal matrices computed on the CPU
+#include <gdev/Transform.h>
+// Depth pre-pass and overdraw counting
+#include <gdev/DepthPrepass.h>
+// Sorting the draws of a frame
+#include <gdev/RenderQueue.h>
+// Skipping redundant program, vertex array and texture bindings
+#include <gdev/StateCache.h>
+// Frustum culling with bounding boxes
+#include <gdev/Frustum.h>
+// Bounding volume hierarchy for culling and picking many objects
+#include <gdev/Bvh.h>
+// Skipping objects that are hidden behind other objects
+#include <gdev/OcclusionCulling.h>
+// Streaming per-frame data through a ring buffer
+#include <gdev/StreamBuffer.h>
+// Meshes whose vertices change every frame
+#include <gdev/DynamicMesh.h>
+// Loading meshes from OBJ and glTF files
+#include <gdev/MeshImporter.h>
+// Reordering triangles and vertices for the vertex cache, overdraw and vertex fetch
+#include <gdev/MeshOptimizer.h>
+// Binary mesh caches that are loaded without parsing
+#include <gdev/MeshCache.h>
+// Simplified levels of detail of meshes
+#include <gdev/MeshSimplifier.h>
+// Splitting meshes into meshlets that are culled on their own
+#include <gdev/Meshlet.h>
 
 // ---------------
 // Function declarations
 // ---------------
 
 /**
- * @brief Creates a shader program based on the provided file paths for the vertex and fragment shaders.
- * @param[in] vertexShaderFilePath Vertex shader file path
- * @param[in] fragmentShaderFilePath Fragment shader file path
- * @return OpenGL handle to the created shader program
+ * @brief Function for handling the event when the size of the framebuffer changed.
+ * @param[in] window Reference to the window
+ * @param[in] width New width
+ * @param[in] height New height
  */
-GLuint CreateShaderProgram(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
+void FramebufferSizeChangedCallback(GLFWwindow* window, int width, int height);
 
 /**
- * @brief Creates a shader based on the provided shader type and the path to the file containing the shader source.
- * @param[in] shaderType Shader type
- * @param[in] shaderFilePath Path to the file containing the shader source
- * @return OpenGL handle to the created shader
+ * @brief Creates the uniform block data of a Phong material that uses the global light intensities.
+ * @param[in] ambientComponent Ambient reflection of the material
+ * @param[in] diffuseComponent Diffuse reflection of the material
+ * @param[in] specularComponent Specular reflection of the material
+ * @param[in] shine Shininess of the material
+ * @return Material data to upload to the material uniform buffer
  */
-GLuint CreateShaderFromFile(const GLuint& shaderType, const std::string& shaderFilePath);
+MaterialUniforms CreateMaterial(float ambientComponent, float diffuseComponent, float specularComponent, float shine);
 
 /**
- * @brief Creates a shader based on the provided shader type and the string containing the shader source.
- * @param[in] shaderType Shader type
- * @param[in] shaderSource Shader source string
- * @return OpenGL handle to the created shader
+ * @brief Places cubes on a 3D grid in front of the camera for the stress scene.
+ * @param[in] cubeCount Number of cubes
+ * @param[in] materialCount Number of materials to cycle through
+ * @return Model matrix and material of each cube
  */
-GLuint CreateShaderFromSource(const GLuint& shaderType, const std::string& shaderSource);
+std::vector<InstanceData> CreateStressCubes(int cubeCount, int materialCount);
 
 /**
- * @brief Function for handling the event when the size of the framebuffer changed.
- * @param[in] window Reference to the window
- * @param[in] width New width
- * @param[in] height New height
+ * @brief Adds the flat grid of vertices that the animated grid starts as. The vertex of row r and column c
+ * gets index r * gridSize + c, and positions are in units of one grid cell, centered on the origin
+ * (whole and half numbers, so that they are exact in the 16-bit floats of the position stream).
+ * @param[in,out] builder Empty builder to add the vertices and the submesh to
+ * @param[in] layout Layout of the vertices
+ * @param[in] gridSize Number of vertices along each side
+ * @return Index of the submesh, or -1 if the vertices could not be added one by one
  */
-void FramebufferSizeChangedCallback(GLFWwindow* window, int width, int height);
+int BuildDynamicGrid(MeshBuilder& builder, const VertexLayout& layout, int gridSize);
 
 /**
- * Struct containing data about a vertex
+ * @brief Moves rows of the animated grid to the height of a wave at a point in time, and updates their normals.
+ * @param[in,out] grid Grid made with BuildDynamicGrid()
+ * @param[in] gridSize Number of vertices along each side
+ * @param[in] firstRow First row to move
+ * @param[in] rowCount Number of rows to move (rows past the last one wrap around to the first one)
+ * @param[in] time Time of the wave in seconds
  */
-struct Vertex
+void AnimateDynamicGrid(DynamicMesh& grid, int gridSize, int firstRow, int rowCount, float time);
+
+/**
+ * Struct containing one draw of the scene, so that it can be drawn by more than one pass
+ */
+struct SceneDraw
 {
-	GLfloat x, y, z;	// Position
-	GLubyte r, g, b;	// Color
-	GLfloat u, v;		// UV-coordinates
-	GLfloat nx, ny, nz; //normal vector
+	glm::mat4 modelMatrix;
+	glm::mat3 normalMatrix;
+	int material;		// Index into the material uniform buffer
+	GLuint texture;
+	int subMesh;
+	int program;		// SceneProgram that draws the object
+	int object;			// Index of the object that stays the same from frame to frame, for occlusion queries (-1 if none)
 };
 
+/**
+ * @brief Creates a draw of the scene. The normal matrix is the same for every vertex of the object,
+ * so it is computed once here instead of in main.vsh.
+ * @param[in] modelMatrix Model matrix of the object
+ * @param[in] material Material of the object
+ * @param[in] texture Texture of the object
+ * @param[in] subMesh Submesh to draw
+ * @return The draw
+ */
+SceneDraw CreateSceneDraw(const glm::mat4& modelMatrix, int material, GLuint texture, int subMesh);
+
+/**
+ * @brief Creates the draw of one stress cube, for drawing the cubes without instancing.
+ * @param[in] stressCube Model matrix, normal matrix and material of the cube
+ * @param[in] texture Texture of the cube
+ * @param[in] subMesh Submesh to draw
+ * @param[in] object Index of the cube among the objects of the scene
+ * @return The draw
+ */
+SceneDraw CreateStressCubeDraw(const InstanceData& stressCube, GLuint texture, int subMesh, int object);
+
+/**
+ * @brief Computes the model matrix that stretches a mesh over a bounding box, for drawing the box.
+ * @param[in] box Box to cover
+ * @param[in] meshBounds Bounds of the mesh in local space (e.g. of a cube)
+ * @return Model matrix of the mesh
+ */
+glm::mat4 CreateBoundingBoxMatrix(const BoundingBox& box, const BoundingBox& meshBounds);
+
+/**
+ * @brief Finds the stress cube under a point of the screen. The hierarchy finds the cubes whose boxes are hit,
+ * and those are tested triangle by triangle.
+ * @param[in] stressBvh Hierarchy over the world-space boxes of the stress cubes
+ * @param[in] stressCubes Stress cubes
+ * @param[in] cubeTriangles Vertex positions of the triangles of the cube, in local space
+ * @param[in] viewProjectionMatrix Projection matrix times view matrix
+ * @param[in] screenPoint Point on the screen in normalized device coordinates (-1 to 1)
+ * @return Index of the closest cube under the point, or -1 if there is none
+ */
+int PickStressCube(const Bvh& stressBvh, const std::vector<InstanceData>& stressCubes, const std::vector<glm::vec3>& cubeTriangles,
+	const glm::mat4& viewProjectionMatrix, const glm::vec2& screenPoint);
+
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void processInput(GLFWwindow *window);
 
 glm::vec3 cameraPosition = { 0.0f, 0.0f, 0.0f };//for wasd
 
 glm::vec3 lightPos = { 0.0f, 1.0f, 0.0f };
-float shine = 32.0f;
 
-float ambientComponent = 0.1f;
 glm::vec3 ambientIntensity = { 1.0f, 1.0f, 1.0f };
-float diffuseComponent = 1.0f;
 glm::vec3 diffuseIntensity = { 1.0f, 1.0f, 1.0f };
-float specularComponent = 1.0f;
 glm::vec3 specularIntensity = { 1.0f, 1.0f, 1.0f };
 
+// Vertex buffers that the attributes of the meshes are split into
+enum VertexStream
+{
+	POSITION_STREAM,	// Position only, for passes that only need the depth
+	ATTRIBUTE_STREAM	// Everything else
+};
+
+// Shader programs that the objects of the scene are drawn with (index in the render queue sort keys)
+enum SceneProgram
+{
+	MAIN_PROGRAM,		// main.vsh/main.fsh, one object per draw
+	INSTANCED_PROGRAM,	// instanced.vsh/instanced.fsh, all stress cubes in one draw
+	DYNAMIC_GRID_PROGRAM,	// main.vsh/main.fsh with the vertex arrays of the animated grid
+	MODEL_PROGRAM			// main.vsh/main.fsh with the vertex arrays of the model loaded with --model
+};
+
+// Height of the waves of the animated grid, relative to its size
+const float DYNAMIC_GRID_WAVE_HEIGHT = 0.02f;
+
+// Materials used by the objects in the scene (index into the material uniform buffer)
+enum SceneMaterial
+{
+	QUAD_MATERIAL,
+	ROOM_MATERIAL,
+	BODY_MATERIAL,
+	HEAD_MATERIAL,
+	MATERIAL_COUNT
+};
+
 glm::vec3 target = { 0.0f, 0.0f, -1.0f }; // Target is a specific point that the camera is looking at
 glm::vec3 up = { 0.0f, 0.1f, 0.0f }; // Global up vector (which will be used by the lookAt function to calculate the camera's right and up vectors)
 
+// Depth pre-pass mode, cycled with the P key
+DepthPrepassMode depthPrepassMode = DepthPrepassMode::Off;
+bool depthPrepassKeyDown = false;
+
+// Whether the left mouse button was down last frame (a click picks the stress cube under the cursor)
+bool pickButtonDown = false;
+
 // timing
 float deltaTime = 0.0f;	// time between current frame and last frame
 float lastFrame = 0.0f;
@@ -104,676 +242,455 @@ float roundOff(float var)
 
 /**
  * @brief Main function
+ * @param[in] argc Number of command-line arguments
+ * @param[in] argv Command-line arguments (see ParseBenchmarkOptions() for the supported ones)
  * @return An integer indicating whether the program ended successfully or not.
  * A value of 0 indicates the program ended succesfully, while a non-zero value indicates
  * something wrong happened during execution.
  */
-int main()
+int main(int argc, char** argv)
 {
-	// Initialize GLFW
-	int glfwInitStatus = glfwInit();
-	if (glfwInitStatus == GLFW_FALSE)
-	{
-		std::cerr << "Failed to initialize GLFW!" << std::endl;
-		return 1;
-	}
-
-	// Tell GLFW that we prefer to use OpenGL 3.3
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	// Read the command-line options (e.g. --headless --frames 500)
+	BenchmarkOptions options = ParseBenchmarkOptions(argc, argv);
 
-	// Tell GLFW that we prefer to use the modern OpenGL
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	int windowWidth = options.width;
+	int windowHeight = options.height;
+	GLFWwindow* window = nullptr;
+	HeadlessContext headlessContext;
 
-	// Tell GLFW to create a window
-	int windowWidth = 800;
-	int windowHeight = 600;
-	GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "Hello Triangle", nullptr, nullptr);
-	if (window == nullptr)
+	if (options.headless)
 	{
-		std::cerr << "Failed to create GLFW window!" << std::endl;
-		glfwTerminate();
-		return 1;
+		// Render into an offscreen framebuffer without opening a window
+		if (!CreateHeadlessContext(headlessContext, windowWidth, windowHeight))
+		{
+			return 1;
+		}
 	}
-
-	// Tell GLFW to use the OpenGL context that was assigned to the window that we just created
-	glfwMakeContextCurrent(window);
-
-	// Register the callback function that handles when the framebuffer size has changed
-	glfwSetFramebufferSizeCallback(window, FramebufferSizeChangedCallback);
-
-	// Tell GLAD to load the OpenGL function pointers
-	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+	else
 	{
-		std::cerr << "Failed to initialize GLAD!" << std::endl;
-		return 1;
-	}
-
-	// --- Vertex specification ---
-	
-	// Set up the data for each vertex of the quad
-	// These vertices are in LOCAL SPACE
-	Vertex vertices[78];
-
-	//frontmost face to view space
-		//bottom left (in relation to own normal vector)
-		vertices[0].x = 1.0f;	vertices[0].y = -1.0f;	vertices[0].z = -1.0f;
-		vertices[0].r = 255;	vertices[0].g = 255;		vertices[0].b = 255;
-		vertices[0].u = 0.0f;	vertices[0].v = 0.0f;
-		vertices[0].nx = 0.0f;	vertices[0].ny = 0.0f;	vertices[0].nz = -1.0f;
-
-		//bottom right (in relation to own normal vector)
-		vertices[1].x = -1.0f;	vertices[1].y = -1.0f;	vertices[1].z = -1.0f;
-		vertices[1].r = 255;		vertices[1].g = 255;	vertices[1].b = 255;
-		vertices[1].u = 1.0f;	vertices[1].v = 0.0f;
-		vertices[1].nx = 0.0f;	vertices[1].ny = 0.0f;	vertices[1].nz = -1.0f;
-
-
-		//top right (in relation to own normal vector)
-		vertices[2].x = 1.0f;	vertices[2].y = 1.0f;	vertices[2].z = -1.0f;
-		vertices[2].r = 255;	vertices[2].g = 255;		vertices[2].b = 255;
-		vertices[2].u = 0.0f;	vertices[2].v = 1.0f;
-		vertices[2].nx = 0.0f;	vertices[2].ny = 0.0f;	vertices[2].nz = -1.0f;
-
-		//bottom left (in relation to own normal vector)
-		vertices[3].x = -1.0f;	vertices[3].y = -1.0f;	vertices[3].z = -1.0f;
-		vertices[3].r = 255;	vertices[3].g = 255;		vertices[3].b = 255;
-		vertices[3].u = 1.0f;	vertices[3].v = 0.0f;
-		vertices[3].nx = 0.0f;	vertices[3].ny = 0.0f;	vertices[3].nz = -1.0f;
-
-		//top left (in relation to own normal vector)
-		vertices[4].x = -1.0f;	vertices[4].y = 1.0f;	vertices[4].z = -1.0f;
-		vertices[4].r = 255;		vertices[4].g = 255;	vertices[4].b = 255;
-		vertices[4].u = 1.0f;	vertices[4].v = 1.0f;
-		vertices[4].nx = 0.0f;	vertices[4].ny = 0.0f;	vertices[4].nz = -1.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[5].x = 1.0f;	vertices[5].y = 1.0f;	vertices[5].z = -1.0f;
-		vertices[5].r = 255;		vertices[5].g = 255;		vertices[5].b = 255;
-		vertices[5].u = 0.0f;	vertices[5].v = 1.0f;
-		vertices[5].nx = 0.0f;	vertices[5].ny = 0.0f;	vertices[5].nz = -1.0f;
-
-
-	//backmost face to view space
-		//bottom right (in relation to own normal vector)
-		vertices[6].x = -1.0f;	vertices[6].y = -1.0f;	vertices[6].z = 1.0f;
-		vertices[6].r = 255;	vertices[6].g = 255;		vertices[6].b = 255;
-		vertices[6].u = 0.0f;	vertices[6].v = 0.0f;
-		vertices[6].nx = 0.0f;	vertices[6].ny = 0.0f;	vertices[6].nz = 1.0f;
-
-		//bottom left (in relation to own normal vector)
-		vertices[7].x = 1.0f;	vertices[7].y = -1.0f;	vertices[7].z = 1.0f;
-		vertices[7].r = 255;	vertices[7].g = 255;	vertices[7].b = 255;
-		vertices[7].u = 1.0f;	vertices[7].v = 0.0f;
-		vertices[7].nx = 0.0f;	vertices[7].ny = 0.0f;	vertices[7].nz = 1.0f;
-
-		//top left (in relation to own normal vector)
-		vertices[8].x = 1.0f;	vertices[8].y = 1.0f;	vertices[8].z = 1.0f;
-		vertices[8].r = 255;	vertices[8].g = 255;		vertices[8].b = 255;
-		vertices[8].u = 1.0f;	vertices[8].v = 1.0f;
-		vertices[8].nx = 0.0f;	vertices[8].ny = 0.0f;	vertices[8].nz = 1.0f;
-
-		//bottom right (in relation to own normal vector)
-		vertices[9].x = -1.0f;	vertices[9].y = -1.0f;	vertices[9].z = 1.0f;
-		vertices[9].r = 255;	vertices[9].g = 255;		vertices[9].b = 255;
-		vertices[9].u = 0.0f;	vertices[9].v = 0.0f;
-		vertices[9].nx = 0.0f;	vertices[9].ny = 0.0f;	vertices[9].nz = 1.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[10].x = -1.0f;	vertices[10].y = 1.0f;	vertices[10].z = 1.0f;
-		vertices[10].r = 255;	vertices[10].g = 255;	vertices[10].b = 255;
-		vertices[10].u = 0.0f;	vertices[10].v = 1.0f;
-		vertices[10].nx = 0.0f;	vertices[10].ny = 0.0f;	vertices[10].nz = 1.0f;
-
-		//top left (in relation to own normal vector)
-		vertices[11].x = 1.0f;	vertices[11].y = 1.0f;	vertices[11].z = 1.0f;
-		vertices[11].r = 255;	vertices[11].g = 255;		vertices[11].b = 255;
-		vertices[11].u = 1.0f;	vertices[11].v = 1.0f;
-		vertices[11].nx = 0.0f;	vertices[11].ny = 0.0f;	vertices[11].nz = 1.0f;
-
-	//leftmost face to view space
-		//bottom left (in relation to own normal vector)
-		vertices[12].x = -1.0f;	vertices[12].y = -1.0f;	vertices[12].z = -1.0f;
-		vertices[12].r = 255;	vertices[12].g = 255;		vertices[12].b = 255;
-		vertices[12].u = 0.0f;	vertices[12].v = 0.0f;
-		vertices[12].nx = -1.0f; vertices[12].ny = 0.0f;	vertices[12].nz = 0.0f;
-
-		//bottom right (in relation to own normal vector)
-		vertices[13].x = -1.0f;	vertices[13].y = -1.0f;	vertices[13].z = 1.0f;
-		vertices[13].r = 255;	vertices[13].g = 255;	vertices[13].b = 255;
-		vertices[13].u = 1.0f;	vertices[13].v = 0.0f;
-		vertices[13].nx = -1.0f; vertices[13].ny = 0.0f;	vertices[13].nz = 0.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[14].x = -1.0f;	vertices[14].y = 1.0f;	vertices[14].z = 1.0f;
-		vertices[14].r = 255;	vertices[14].g = 255;		vertices[14].b = 255;
-		vertices[14].u = 1.0f;	vertices[14].v = 1.0f;
-		vertices[14].nx = -1.0f; vertices[14].ny = 0.0f;	vertices[14].nz = 0.0f;
-
-		//bottom left (in relation to own normal vector)
-		vertices[15].x = -1.0f;	vertices[15].y = -1.0f;	vertices[15].z = -1.0f;
-		vertices[15].r = 255;	vertices[15].g = 255;		vertices[15].b = 255;
-		vertices[15].u = 0.0f;	vertices[15].v = 0.0f;
-		vertices[15].nx = -1.0f; vertices[15].ny = 0.0f;	vertices[15].nz = 0.0f;
-
-		//top left (in relation to own normal vector)
-		vertices[16].x = -1.0f;	vertices[16].y = 1.0f;	vertices[16].z = -1.0f;
-		vertices[16].r = 255;	vertices[16].g = 255;	vertices[16].b = 255;
-		vertices[16].u = 0.0f;	vertices[16].v = 1.0f;
-		vertices[16].nx = -1.0f; vertices[16].ny = 0.0f;	vertices[16].nz = 0.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[17].x = -1.0f;	vertices[17].y = 1.0f;	vertices[17].z = 1.0f;
-		vertices[17].r = 255;	vertices[17].g = 255;		vertices[17].b = 255;
-		vertices[17].u = 1.0f;	vertices[17].v = 1.0f;
-		vertices[17].nx = -1.0f; vertices[17].ny = 0.0f;	vertices[17].nz = 0.0f;
-
-
-	//rightmost face to view space
-		//bottom left (in relation to own normal vector)
-		vertices[18].x = 1.0f;	vertices[18].y = -1.0f;	vertices[18].z = 1.0f;
-		vertices[18].r = 255;	vertices[18].g = 255;		vertices[18].b = 255;
-		vertices[18].u = 0.0f;	vertices[18].v = 0.0f;
-		vertices[18].nx = 1.0f; vertices[18].ny = 0.0f;	vertices[18].nz = 0.0f;
-
-		//bottom right (in relation to own normal vector)
-		vertices[19].x = 1.0f;	vertices[19].y = -1.0f;	vertices[19].z = -1.0f;
-		vertices[19].r = 255;		vertices[19].g = 255;	vertices[19].b = 255;
-		vertices[19].u = 1.0f;	vertices[19].v = 0.0f;
-		vertices[19].nx = 1.0f; vertices[19].ny = 0.0f;	vertices[19].nz = 0.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[20].x = 1.0f;	vertices[20].y = 1.0f;	vertices[20].z = -1.0f;
-		vertices[20].r = 255;	vertices[20].g = 255;		vertices[20].b = 255;
-		vertices[20].u = 1.0f;	vertices[20].v = 1.0f;
-		vertices[20].nx = 1.0f; vertices[20].ny = 0.0f;	vertices[20].nz = 0.0f;
-
-		//bottom left (in relation to own normal vector)
-		vertices[21].x = 1.0f;	vertices[21].y = -1.0f;	vertices[21].z = 1.0f;
-		vertices[21].r = 255;	vertices[21].g = 255;		vertices[21].b = 255;
-		vertices[21].u = 0.0f;	vertices[21].v = 0.0f;
-		vertices[21].nx = 1.0f; vertices[21].ny = 0.0f;	vertices[21].nz = 0.0f;
-
-		//top left (in relation to own normal vector)
-		vertices[22].x = 1.0f;	vertices[22].y = 1.0f;	vertices[22].z = 1.0f;
-		vertices[22].r = 255;	vertices[22].g = 255;	vertices[22].b = 255;
-		vertices[22].u = 0.0f;	vertices[22].v = 1.0f;
-		vertices[22].nx = 1.0f; vertices[22].ny = 0.0f;	vertices[22].nz = 0.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[23].x = 1.0f;	vertices[23].y = 1.0f;	vertices[23].z = -1.0f;
-		vertices[23].r = 255;		vertices[23].g = 255;		vertices[23].b = 255;
-		vertices[23].u = 1.0f;	vertices[23].v = 1.0f;
-		vertices[23].nx = 1.0f; vertices[23].ny = 0.0f;	vertices[23].nz = 0.0f;
-
-
-	//topmost face to view space
-		//bottom left (in relation to own normal vector)
-		vertices[24].x = -1.0f;	vertices[24].y = 1.0f;	vertices[24].z = 1.0f;
-		vertices[24].r = 255;	vertices[24].g = 255;		vertices[24].b = 255;
-		vertices[24].u = 0.0f;	vertices[24].v = 0.0f;
-		vertices[24].nx = 0.0f; vertices[24].ny = 1.0f;	vertices[24].nz = 0.0f;
-
-		//bottom right (in relation to own normal vector)
-		vertices[25].x = 1.0f;	vertices[25].y = 1.0f;	vertices[25].z = 1.0f;
-		vertices[25].r = 255;		vertices[25].g = 255;	vertices[25].b = 255;
-		vertices[25].u = 1.0f;	vertices[25].v = 0.0f;
-		vertices[25].nx = 0.0f; vertices[25].ny = 1.0f;	vertices[25].nz = 0.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[26].x = 1.0f;	vertices[26].y = 1.0f;	vertices[26].z = -1.0f;
-		vertices[26].r = 255;	vertices[26].g = 255;		vertices[26].b = 255;
-		vertices[26].u = 1.0f;	vertices[26].v = 1.0f;
-		vertices[26].nx = 0.0f; vertices[26].ny = 1.0f;	vertices[26].nz = 0.0f;
-
-		//bottom left (in relation to own normal vector)
-		vertices[27].x = -1.0f;	vertices[27].y = 1.0f;	vertices[27].z = 1.0f;
-		vertices[27].r = 255;	vertices[27].g = 255;		vertices[27].b = 255;
-		vertices[27].u = 0.0f;	vertices[27].v = 0.0f;
-		vertices[27].nx = 0.0f; vertices[27].ny = 1.0f;	vertices[27].nz = 0.0f;
-
-		//top left (in relation to own normal vector)
-		vertices[28].x = -1.0f;	vertices[28].y = 1.0f;	vertices[28].z = -1.0f;
-		vertices[28].r = 255;		vertices[28].g = 255;	vertices[28].b = 255;
-		vertices[28].u = 0.0f;	vertices[28].v = 1.0f;
-		vertices[28].nx = 0.0f; vertices[28].ny = 1.0f;	vertices[28].nz = 0.0f;
-
-		//top right (in relation to own normal vector)
-		vertices[29].x = 1.0f;	vertices[29].y = 1.0f;	vertices[29].z = -1.0f;
-		vertices[29].r = 255;		vertices[29].g = 255;		vertices[29].b = 255;
-		vertices[29].u = 1.0f;	vertices[29].v = 1.0f;
-		vertices[29].nx = 0.0f; vertices[29].ny = 1.0f;	vertices[29].nz = 0.0f;
-
-
-	//bottommost face to view space
-		//bottom left (in relation to own normal vector)
-	vertices[30].x = 1.0f;	vertices[30].y = -1.0f;	vertices[30].z = 1.0f;
-	vertices[30].r = 255;	vertices[30].g = 255;		vertices[30].b = 255;
-	vertices[30].u = 1.0f;	vertices[30].v = 1.0f;
-	vertices[30].nx = 0.0f; vertices[30].ny = -1.0f;	vertices[30].nz = 0.0f;
-
-	//bottom right (in relation to own normal vector)
-	vertices[31].x = -1.0f;	vertices[31].y = -1.0f;	vertices[31].z = 1.0f;
-	vertices[31].r = 255;		vertices[31].g = 255;	vertices[31].b = 255;
-	vertices[31].u = 0.0f;	vertices[31].v = 1.0f;
-	vertices[31].nx = 0.0f; vertices[31].ny = -1.0f; vertices[31].nz = 0.0f;
-
-	//top right (in relation to own normal vector)
-	vertices[32].x = -1.0f;	vertices[32].y = -1.0f;	vertices[32].z = -1.0f;
-	vertices[32].r = 255;		vertices[32].g = 255;		vertices[32].b = 255;
-	vertices[32].u = 0.0f;	vertices[32].v = 0.0f;
-	vertices[32].nx = 0.0f; vertices[32].ny = -1.0f; vertices[32].nz = 0.0f;
-
-	//bottom left (in relation to own normal vector)
-	vertices[33].x = 1.0f;	vertices[33].y = -1.0f;	vertices[33].z = 1.0f;
-	vertices[33].r = 255;	vertices[33].g = 255;		vertices[33].b = 255;
-	vertices[33].u = 1.0f;	vertices[33].v = 1.0f;
-	vertices[33].nx = 0.0f; vertices[33].ny = -1.0f; vertices[33].nz = 0.0f;
-
-	//top left (in relation to own normal vector)
-	vertices[34].x = 1.0f;	vertices[34].y = -1.0f;	vertices[34].z = -1.0f;
-	vertices[34].r = 255;		vertices[34].g = 255;	vertices[34].b = 255;
-	vertices[34].u = 1.0f;	vertices[34].v = 0.0f;
-	vertices[34].nx = 0.0f; vertices[34].ny = -1.0f; vertices[34].nz = 0.0f;
-
-	//top right (in relation to own normal vector)
-	vertices[35].x = -1.0f;	vertices[35].y = -1.0f;	vertices[35].z = -1.0f;
-	vertices[35].r = 255;		vertices[35].g = 255;		vertices[35].b = 255;
-	vertices[35].u = 0.0f;	vertices[35].v = 0.0f;
-	vertices[35].nx = 0.0f; vertices[35].ny = -1.0f; vertices[35].nz = 0.0f;
-
-
-	//for quad
-		//bottom left (in relation to own normal vector)
-	vertices[36].x = -0.5f;	vertices[36].y = -1.0f;	vertices[36].z = 0.0f;
-	vertices[36].r = 255;	vertices[36].g = 255;	vertices[36].b = 255;
-	vertices[36].u = 0.0f;	vertices[36].v = 0.0f;
-	vertices[36].nx = 0.0f; vertices[36].ny = 0.0f; vertices[36].nz = 1.0f;
-
-	//bottom right (in relation to own normal vector)
-	vertices[37].x = 0.5f;	vertices[37].y = -1.0f;	vertices[37].z = 0.0f;
-	vertices[37].r = 255;	vertices[37].g = 255;	vertices[37].b = 255;
-	vertices[37].u = 1.0f;	vertices[37].v = 0.0f;
-	vertices[37].nx = 0.0f; vertices[37].ny = 0.0f; vertices[37].nz = 1.0f;
-
-	//top right (in relation to own normal vector)
-	vertices[38].x = 0.3f;	vertices[38].y = 0.0f;	vertices[38].z = 0.0f;
-	vertices[38].r = 255;	vertices[38].g = 255;	vertices[38].b = 255;
-	vertices[38].u = 1.0f;	vertices[38].v = 1.0f;
-	vertices[38].nx = 0.0f; vertices[38].ny = 0.0f; vertices[38].nz = 1.0f;
-
-	//bottom left (in relation to own normal vector)
-	vertices[39].x = -0.5f;	vertices[39].y = -1.0f;	vertices[39].z = 0.0f;
-	vertices[39].r = 255;	vertices[39].g = 255;	vertices[39].b = 255;
-	vertices[39].u = 0.0f;	vertices[39].v = 0.0f;
-	vertices[39].nx = 0.0f; vertices[39].ny = 0.0f; vertices[39].nz = 1.0f;
-
-	//top left (in relation to own normal vector)
-	vertices[40].x = -0.3f;	vertices[40].y = 0.0f;	vertices[40].z = 0.0f;
-	vertices[40].r = 255;	vertices[40].g = 255;	vertices[40].b = 255;
-	vertices[40].u = 0.0f;	vertices[40].v = 1.0f;
-	vertices[40].nx = 0.0f; vertices[40].ny = 0.0f; vertices[40].nz = 1.0f;
-
-	//top right (in relation to own normal vector)
-	vertices[41].x = 0.3f;	vertices[41].y = 0.0f;	vertices[41].z = 0.0f;
-	vertices[41].r = 255;	vertices[41].g = 255;	vertices[41].b = 255;
-	vertices[41].u = 1.0f;	vertices[41].v = 1.0f;
-	vertices[41].nx = 0.0f; vertices[41].ny = 0.0f; vertices[41].nz = 1.0f;
-
-	//box
-		//+z face
-	vertices[42].x = -0.5f;	vertices[42].y = -0.5f;	vertices[42].z = 0.5f;
-	vertices[42].r = 255;	vertices[42].g = 255;		vertices[42].b = 255;
-	vertices[42].u = 0.0f;	vertices[42].v = 0.0f;
-	vertices[42].nx = 0.0f; vertices[42].ny = 0.0f; vertices[42].nz = 1.0f;
-
-	vertices[43].x = 0.5f;	vertices[43].y = -0.5f;	vertices[43].z = 0.5f;
-	vertices[43].r = 255;		vertices[43].g = 255;	vertices[43].b = 255;
-	vertices[43].u = 1.0f;	vertices[43].v = 0.0f;
-	vertices[42].nx = 0.0f; vertices[42].ny = 0.0f; vertices[42].nz = 1.0f;
-
-	vertices[44].x = 0.5f;	vertices[44].y = 0.5f;	vertices[44].z = 0.5f;
-	vertices[44].r = 255;		vertices[44].g = 255;		vertices[44].b = 255;
-	vertices[44].u = 1.0f;	vertices[44].v = 1.0f;
-	vertices[44].nx = 0.0f; vertices[44].ny = 0.0f; vertices[44].nz = 1.0f;
-
-	vertices[45].x = -0.5f;	vertices[45].y = 0.5f;	vertices[45].z = 0.5f;
-	vertices[45].r = 255;		vertices[45].g = 255;		vertices[45].b = 255;
-	vertices[45].u = 0.0f;	vertices[45].v = 1.0f;
-	vertices[45].nx = 0.0f; vertices[45].ny = 0.0f; vertices[45].nz = 1.0f;
-
-	//+x face
-	vertices[46].x = 0.5f;	vertices[46].y = -0.5f;	vertices[46].z = 0.5f;
-	vertices[46].r = 255;	vertices[46].g = 255;		vertices[46].b = 255;
-	vertices[46].u = 0.0f;	vertices[46].v = 0.0f;
-	vertices[46].nx = 1.0f; vertices[46].ny = 0.0f; vertices[46].nz = 0.0f;
-
-	vertices[47].x = 0.5f;	vertices[47].y = -0.5f;	vertices[47].z = -0.5f;
-	vertices[47].r = 255;		vertices[47].g = 255;		vertices[47].b = 255;
-	vertices[47].u = 1.0f;	vertices[47].v = 0.0f;
-	vertices[47].nx = 1.0f; vertices[47].ny = 0.0f; vertices[47].nz = 0.0f;
-
-	vertices[48].x = 0.5f;	vertices[48].y = 0.5f;	vertices[48].z = -0.5f;
-	vertices[48].r = 255;		vertices[48].g = 255;	vertices[48].b = 255;
-	vertices[48].u = 1.0f;	vertices[48].v = 1.0f;
-	vertices[48].nx = 1.0f; vertices[48].ny = 0.0f; vertices[48].nz = 0.0f;
-
-	vertices[49].x = 0.5f;	vertices[49].y = 0.5f;	vertices[49].z = 0.5f;
-	vertices[49].r = 255;		vertices[49].g = 255;		vertices[49].b = 255;
-	vertices[49].u = 0.0f;	vertices[49].v = 1.0f;
-	vertices[49].nx = 1.0f; vertices[49].ny = 0.0f; vertices[49].nz = 0.0f;
-
-	//-z face
-	vertices[50].x = 0.5f;	vertices[50].y = -0.5f;	vertices[50].z = -0.5f;
-	vertices[50].r = 255;		vertices[50].g = 255;		vertices[50].b = 255;
-	vertices[50].u = 0.0f;	vertices[50].v = 0.0f;
-	vertices[50].nx = 0.0f; vertices[50].ny = 0.0f; vertices[50].nz = -1.0f;
-
-	vertices[51].x = -0.5f;	vertices[51].y = -0.5f;	vertices[51].z = -0.5f;
-	vertices[51].r = 255;		vertices[51].g = 255;		vertices[51].b = 255;
-	vertices[51].u = 1.0f;	vertices[51].v = 0.0f;
-	vertices[51].nx = 0.0f; vertices[51].ny = 0.0f; vertices[51].nz = -1.0f;
-
-	vertices[52].x = -0.5f;	vertices[52].y = 0.5f;	vertices[52].z = -0.5f;
-	vertices[52].r = 255;		vertices[52].g = 255;		vertices[52].b = 255;
-	vertices[52].u = 1.0f;	vertices[52].v = 1.0f;
-	vertices[52].nx = 0.0f; vertices[52].ny = 0.0f; vertices[52].nz = -1.0f;
-
-	vertices[53].x = 0.5f;	vertices[53].y = 0.5f;	vertices[53].z = -0.5f;
-	vertices[53].r = 255;		vertices[53].g = 255;		vertices[53].b = 255;
-	vertices[53].u = 0.0f;	vertices[53].v = 1.0f;
-	vertices[53].nx = 0.0f; vertices[53].ny = 0.0f; vertices[53].nz = -1.0f;
-
-	//-x face
-	vertices[54].x = -0.5f;	vertices[54].y = -0.5f;	vertices[54].z = -0.5f;
-	vertices[54].r = 255;		vertices[54].g = 255;		vertices[54].b = 255;
-	vertices[54].u = 0.0f;	vertices[54].v = 0.0f;
-	vertices[54].nx = -1.0f; vertices[54].ny = 0.0f; vertices[54].nz = 0.0f;
-
-	vertices[55].x = -0.5f;	vertices[55].y = -0.5f;	vertices[55].z = 0.5f;
-	vertices[55].r = 255;		vertices[55].g = 255;		vertices[55].b = 255;
-	vertices[55].u = 1.0f;	vertices[55].v = 0.0f;
-	vertices[55].nx = -1.0f; vertices[55].ny = 0.0f; vertices[55].nz = 0.0f;
-
-	vertices[56].x = -0.5f;	vertices[56].y = 0.5f;	vertices[56].z = 0.5f;
-	vertices[56].r = 255;		vertices[56].g = 255;		vertices[56].b = 255;
-	vertices[56].u = 1.0f;	vertices[56].v = 1.0f;
-	vertices[56].nx = -1.0f; vertices[56].ny = 0.0f; vertices[56].nz = 0.0f;
-
-	vertices[57].x = -0.5f;	vertices[57].y = 0.5f;	vertices[57].z = -0.5f;
-	vertices[57].r = 255;		vertices[57].g = 255;		vertices[57].b = 255;
-	vertices[57].u = 0.0f;	vertices[57].v = 1.0f;
-	vertices[57].nx = -1.0f; vertices[57].ny = 0.0f; vertices[57].nz = 0.0f;
-
-	//+y face
-	vertices[58].x = -0.5f;	vertices[58].y = 0.5f;	vertices[58].z = 0.5f;
-	vertices[58].r = 255;		vertices[58].g = 255;		vertices[58].b = 255;
-	vertices[58].u = 0.0f;	vertices[58].v = 0.0f;
-	vertices[58].nx = 0.0f; vertices[58].ny = 1.0f; vertices[58].nz = 0.0f;
-
-	vertices[59].x = 0.5f;	vertices[59].y = 0.5f;	vertices[59].z = 0.5f;
-	vertices[59].r = 255;		vertices[59].g = 255;		vertices[59].b = 255;
-	vertices[59].u = 1.0f;	vertices[59].v = 0.0f;
-	vertices[59].nx = 0.0f; vertices[59].ny = 1.0f; vertices[59].nz = 0.0f;
-
-	vertices[60].x = 0.5f;	vertices[60].y = 0.5f;	vertices[60].z = -0.5f;
-	vertices[60].r = 255;		vertices[60].g = 255;		vertices[60].b = 255;
-	vertices[60].u = 1.0f;	vertices[60].v = 1.0f;
-	vertices[60].nx = 0.0f; vertices[60].ny = 1.0f; vertices[60].nz = 0.0f;
-
-	vertices[61].x = -0.5f;	vertices[61].y = 0.5f;	vertices[61].z = -0.5f;
-	vertices[61].r = 255;		vertices[61].g = 255;		vertices[61].b = 255;
-	vertices[61].u = 0.0f;	vertices[61].v = 1.0f;
-	vertices[61].nx = 0.0f; vertices[61].ny = 1.0f; vertices[61].nz = 0.0f;
-
-	//-y
-	vertices[62].x = -0.5f;	vertices[62].y = -0.5f;	vertices[62].z = -0.5f;
-	vertices[62].r = 255;		vertices[62].g = 255;		vertices[62].b = 255;
-	vertices[62].u = 0.0f;	vertices[62].v = 0.0f;
-	vertices[62].nx = 0.0f; vertices[62].ny = -1.0f; vertices[62].nz = 0.0f;
-
-	vertices[63].x = 0.5f;	vertices[63].y = -0.5f;	vertices[63].z = -0.5f;
-	vertices[63].r = 255;		vertices[63].g = 255;		vertices[63].b = 255;
-	vertices[63].u = 1.0f;	vertices[63].v = 0.0f;
-	vertices[63].nx = 0.0f; vertices[63].ny = -1.0f; vertices[63].nz = 0.0f;
-
-	vertices[64].x = 0.5f;	vertices[64].y = -0.5f;	vertices[64].z = 0.5f;
-	vertices[64].r = 255;		vertices[64].g = 255;		vertices[64].b = 255;
-	vertices[64].u = 1.0f;	vertices[64].v = 1.0f;
-	vertices[64].nx = 0.0f; vertices[64].ny = -1.0f; vertices[64].nz = 0.0f;
-
-	vertices[65].x = -0.5f;	vertices[65].y = -0.5f;	vertices[65].z = 0.5f;
-	vertices[65].r = 255;		vertices[65].g = 255;		vertices[65].b = 255;
-	vertices[65].u = 0.0f;	vertices[65].v = 1.0f;
-	vertices[65].nx = 0.0f; vertices[65].ny = -1.0f; vertices[65].nz = 0.0f;
-
-	//hat
-		//+z face
-	vertices[66].x = -0.5f;	vertices[66].y = 0.5f;	vertices[66].z = 0.5f;
-	vertices[66].r = 255;		vertices[66].g = 255;		vertices[66].b = 255;
-	vertices[66].u = 0.0f;	vertices[66].v = 0.0f;
-	vertices[66].nx = 0.0f; vertices[66].ny = 0.5f; vertices[66].nz = 0.5f;
-
-	vertices[67].x = 0.5f;	vertices[67].y = 0.5f;	vertices[67].z = 0.5f;
-	vertices[67].r = 255;		vertices[67].g = 255;		vertices[67].b = 255;
-	vertices[67].u = 0.0f;	vertices[67].v = 1.0f;
-	vertices[67].nx = 0.0f; vertices[67].ny = 0.5f; vertices[67].nz = 0.5f;
-
-	vertices[68].x = 0.0f;	vertices[68].y = 1.0f;	vertices[68].z = 0.0f;
-	vertices[68].r = 255;		vertices[68].g = 255;		vertices[68].b = 255;
-	vertices[68].u = 0.5f;	vertices[68].v = 1.0f;
-	vertices[68].nx = 0.0f; vertices[68].ny = 0.5f; vertices[68].nz = 0.5f;
-
-	//+x face
-	vertices[69].x = 0.5f;	vertices[69].y = 0.5f;	vertices[69].z = 0.5f;
-	vertices[69].r = 255;		vertices[69].g = 255;		vertices[69].b = 255;
-	vertices[69].u = 0.0f;	vertices[69].v = 0.0f;
-	vertices[69].nx = 0.5f; vertices[69].ny = 0.5f; vertices[69].nz = 0.0f;
-
-	vertices[70].x = 0.5f;	vertices[70].y = 0.5f;	vertices[70].z = -0.5f;
-	vertices[70].r = 255;		vertices[70].g = 255;		vertices[70].b = 255;
-	vertices[70].u = 0.0f;	vertices[70].v = 1.0f;
-	vertices[70].nx = 0.5f; vertices[70].ny = 0.5f; vertices[70].nz = 0.0f;
-
-	vertices[71].x = 0.0f;	vertices[71].y = 1.0f;	vertices[71].z = 0.0f;
-	vertices[71].r = 255;		vertices[71].g = 255;		vertices[71].b = 255;
-	vertices[71].u = 0.5f;	vertices[71].v = 1.0f;
-	vertices[71].nx = 0.5f; vertices[71].ny = 0.5f; vertices[71].nz = 0.0f;
-
-	//-z face
-	vertices[72].x = 0.5f;	vertices[72].y = 0.5f;	vertices[72].z = -0.5f;
-	vertices[72].r = 255;		vertices[72].g = 255;		vertices[72].b = 255;
-	vertices[72].u = 0.0f;	vertices[72].v = 0.0f;
-	vertices[72].nx = 0.0f; vertices[72].ny = 0.5f; vertices[72].nz = -0.5f;
-
-	vertices[73].x = -0.5f;	vertices[73].y = 0.5f;	vertices[73].z = -0.5f;
-	vertices[73].r = 255;		vertices[73].g = 255;		vertices[73].b = 255;
-	vertices[73].u = 0.0f;	vertices[73].v = 1.0f;
-	vertices[73].nx = 0.0f; vertices[73].ny = 0.5f; vertices[73].nz = -0.5f;
-
-	vertices[74].x = 0.0f;	vertices[74].y = 1.0f;	vertices[74].z = 0.0f;
-	vertices[74].r = 255;		vertices[74].g = 255;		vertices[74].b = 255;
-	vertices[74].u = 0.5f;	vertices[74].v = 1.0f;
-	vertices[74].nx = 0.0f; vertices[74].ny = 0.5f; vertices[74].nz = -0.5f;
-
-	//-x face
-	vertices[75].x = -0.5f;	vertices[75].y = 0.5f;	vertices[75].z = -0.5f;
-	vertices[75].r = 255;		vertices[75].g = 255;		vertices[75].b = 255;
-	vertices[75].u = 0.0f;	vertices[75].v = 0.0f;
-	vertices[75].nx = -0.5f; vertices[75].ny = 0.5f; vertices[75].nz = 0.0f;
-
-	vertices[76].x = -0.5f;	vertices[76].y = 0.5f;	vertices[76].z = 0.5f;
-	vertices[76].r = 255;		vertices[76].g = 255;		vertices[76].b = 255;
-	vertices[76].u = 0.0f;	vertices[76].v = 1.0f;
-	vertices[76].nx = -0.5f; vertices[76].ny = 0.5f; vertices[76].nz = 0.0f;
-
-	vertices[77].x = 0.0f;	vertices[77].y = 1.0f;	vertices[77].z = 0.0f;
-	vertices[77].r = 255;		vertices[77].g = 255;		vertices[77].b = 255;
-	vertices[77].u = 0.5f;	vertices[77].v = 1.0f;
-	vertices[77].nx = -0.5f; vertices[77].ny = 0.5f; vertices[77].nz = 0.0f;
-
-	// Create a vertex buffer object (VBO), and upload our vertices data to the VBO
-	GLuint vbo;
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Create a vertex array object that contains data on how to map vertex attributes
-	// (e.g., position, color) to vertex shader properties.
-	GLuint vao;
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	
-	// Vertex attribute 0 - Position
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		// Initialize GLFW
+		int glfwInitStatus = glfwInit();
+		if (glfwInitStatus == GLFW_FALSE)
+		{
+			std::cerr << "Failed to initialize GLFW!" << std::endl;
+			return 1;
+		}
 
-	// Vertex attribute 1 - Color
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)(offsetof(Vertex, r)));
+		// Tell GLFW that we prefer to use OpenGL 3.3
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 
-	// Vertex attribute 2 - UV-coordinates
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, u)));
+		// Tell GLFW that we prefer to use the modern OpenGL
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-	// Vertex attribute 3 - normal coordinates
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, nx)));
+		// Tell GLFW to create a window
+		window = glfwCreateWindow(windowWidth, windowHeight, "Hello Triangle", nullptr, nullptr);
+		if (window == nullptr)
+		{
+			std::cerr << "Failed to create GLFW window!" << std::endl;
+			glfwTerminate();
+			return 1;
+		}
 
-	glBindVertexArray(0);
+		// Tell GLFW to use the OpenGL context that was assigned to the window that we just created
+		glfwMakeContextCurrent(window);
 
-	// Create a variable that will contain the ID of our first texture (pepe.jpg),
-	// and use glGenTextures() to generate the texture itself
-	GLuint tex0;
-	glGenTextures(1, &tex0);
+		// Register the callback function that handles when the framebuffer size has changed
+		glfwSetFramebufferSizeCallback(window, FramebufferSizeChangedCallback);
 
-	// --- Load our pepe.jpg image using stb_image ---
+		// Tell GLAD to load the OpenGL function pointers
+		if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+		{
+			std::cerr << "Failed to initialize GLAD!" << std::endl;
+			return 1;
+		}
+	}
 
-	// Im image-space (pixels), (0, 0) is the upper-left corner of the image
-	// However, in u-v coordinates, (0, 0) is the lower-left corner of the image
-	// This means that the image will appear upside-down when we use the image data as is
-	// This function tells stbi to flip the image vertically so that it is not upside-down when we use it
-	stbi_set_flip_vertically_on_load(true);
+	// --- Load our textures ---
 
-	// 'imageWidth' and imageHeight will contain the width and height of the loaded image respectively
-	int imageWidth, imageHeight, numChannels;
+	// The images are decoded on worker threads while we set up the rest of the scene,
+	// and are uploaded to the GPU before the first frame (see WaitAll() below).
+	// In image-space (pixels), (0, 0) is the upper-left corner of the image, but in u-v coordinates,
+	// (0, 0) is the lower-left corner, so the loader flips the images vertically for us.
+	std::chrono::steady_clock::time_point textureLoadStart = std::chrono::steady_clock::now();
+	// Cooked textures (made from the images with Tools/TextureCook) are loaded without decoding.
+	TextureLoader textureLoader(options.textureThreadCount, options.mipmaps);
+	std::string textureExtension = options.cookedTextures ? COOKED_TEXTURE_EXTENSION : ".jpg";
+	GLuint tex0 = textureLoader.Load("pepe" + textureExtension);
+	GLuint tex1 = textureLoader.Load("bioshock" + textureExtension);
+	GLuint tex2 = textureLoader.Load("color" + textureExtension);
 
-	// Read the image data of our pepe.jpg image, and store it in an unsigned char array
-	unsigned char* imageData = stbi_load("pepe.jpg", &imageWidth, &imageHeight, &numChannels, 0);
+	// --- Vertex specification ---
 
-	// Make sure that we actually loaded the image before uploading the data to the GPU
-	if (imageData != nullptr)
+	// The vertices of the meshes are in LOCAL SPACE, in scene.obj.
+	// They are packed into a compact layout: half-float position and UV, 8-bit color, 10-bit normal.
+	// The shaders still see floats, so they do not need to change.
+	// The position has a vertex buffer of its own, so that position-only passes do not fetch the rest.
+	VertexLayout vertexLayout;
+	AddVertexAttribute(vertexLayout, 0, VertexAttributeFormat::Half4, POSITION_STREAM);		// Position (w = 1)
+	AddVertexAttribute(vertexLayout, 1, VertexAttributeFormat::Unorm8x4, ATTRIBUTE_STREAM);	// Color
+	AddVertexAttribute(vertexLayout, 2, VertexAttributeFormat::Half2, ATTRIBUTE_STREAM);		// UV-coordinates
+	AddVertexAttribute(vertexLayout, 3, VertexAttributeFormat::Snorm10x3, ATTRIBUTE_STREAM);	// Normal
+
+	MeshImportAttributes importAttributes;
+	importAttributes.position = 0;
+	importAttributes.color = 1;
+	importAttributes.uv = 2;
+	importAttributes.normal = 3;
+
+	// Build an indexed mesh out of the groups of the file, which become its submeshes in this order.
+	// The back face comes first so that the faces the head draws with the same texture are next to each other.
+	// Identical vertices are stored only once, and the draws use an index buffer (EBO) to refer to them.
+	static const char* scenePartNames[] = { "cubeBack", "cubeFront", "cubeSides", "quad", "hat" };
+	const int scenePartCount = sizeof(scenePartNames) / sizeof(scenePartNames[0]);
+	MeshBuilder meshBuilder(vertexLayout.stride);
+	std::vector<std::string> partNames;
+	std::chrono::steady_clock::time_point importStart = std::chrono::steady_clock::now();
+	int firstPart = ImportMesh("scene.obj", vertexLayout, importAttributes, meshBuilder, &partNames);
+	std::chrono::duration<double, std::milli> importTime = std::chrono::steady_clock::now() - importStart;
+	bool partsFound = firstPart >= 0 && partNames.size() == static_cast<size_t>(scenePartCount);
+	for (int i = 0; partsFound && i < scenePartCount; ++i)
 	{
-		// Our texture is 2D, so we bind our texture to the GL_TEXTURE_2D target
-		glBindTexture(GL_TEXTURE_2D, tex0);
-
-		// Set the filtering methods for magnification and minification
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-		// Set the wrapping method for the s-axis (x-axis) and t-axis (y-axis)
-		// Try experimenting with different wrapping methods introduced in the textures slide set
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-		// Upload the image data to GPU memory
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, imageWidth, imageHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
-
-		// If we set minification to use mipmaps, we can tell OpenGL to generate the mipmaps for us
-		//glGenerateMipmap(GL_TEXTURE_2D);
-
-		// Once we have copied the data over to the GPU, we can delete
-		// the data on the CPU side, since we won't be using it anymore
-		stbi_image_free(imageData);
-		imageData = nullptr;
+		partsFound = partNames[i] == scenePartNames[i];
 	}
-	else
+	if (!partsFound)
 	{
-		std::cerr << "Failed to load pepe.jpg" << std::endl;
+		std::cerr << "scene.obj does not have the groups of the scene" << std::endl;
+		return 1;
 	}
 
-	// Create our other texture (bioshock.jpg)
-	GLuint tex1;
-	glGenTextures(2, &tex1);
+	int cubeBack = firstPart;
+	int cubeFront = firstPart + 1;
+	int cube = meshBuilder.CombineSubMeshes(cubeBack, 3);
+	int cubeAllButBack = meshBuilder.CombineSubMeshes(cubeFront, 2);
+	int quad = firstPart + 3;
+	int hat = firstPart + 4;
+
+	// Reorder the triangles of each submesh so that they reuse the vertices the GPU has just transformed,
+	// and the vertices in the order the triangles use them
+	MeshOptimizeStats optimizeStats;
+	if (options.meshOptimization)
+	{
+		optimizeStats = OptimizeMesh(meshBuilder, vertexLayout);
+	}
 
-	// Read the image data of our bioshock.jpg image
-	imageData = stbi_load("bioshock.jpg", &imageWidth, &imageHeight, &numChannels, 0);
+	// Create a vertex buffer object (VBO) and an index buffer object (EBO), and upload the mesh data to them
+	Mesh mesh = CreateMesh(meshBuilder, vertexLayout, GL_STATIC_DRAW);
+	if (options.headless)
+	{
+		std::cout << "Mesh: imported in " << importTime.count() << " ms" << std::endl;
+		if (options.meshOptimization)
+		{
+			std::cout << "Mesh: ACMR " << optimizeStats.acmrBefore << " -> " << optimizeStats.acmrAfter << " (" << ACMR_CACHE_SIZE
+				<< "-vertex FIFO cache) for " << optimizeStats.triangleCount << " triangles in " << optimizeStats.clusterCount
+				<< " overdraw clusters" << std::endl;
+		}
+		std::cout << "Mesh: " << meshBuilder.GetSourceVertexCount() << " vertices merged into " << mesh.vertexCount
+			<< " unique vertices (" << vertexLayout.stride << " bytes each, " << vertexLayout.streamStrides[POSITION_STREAM]
+			<< " in the position stream) and " << mesh.indexCount << " indices" << std::endl;
+	}
 
-	// Make sure that we actually loaded the image before uploading the data to the GPU
-	if (imageData != nullptr)
+	// Create a vertex array object that contains data on how to map vertex attributes
+	// (e.g., position, color) to vertex shader properties.
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	BindVertexArray(vao);
+	SetMeshVertexArray(mesh, vertexLayout);
+	BindVertexArray(0);
+
+	// The animated grid is a separate mesh whose vertices are moved on the CPU every frame, and only the rows
+	// that moved are sent to the GPU (see --dynamic-upload for the other ways to send them)
+	DynamicMesh dynamicGrid;
+	int dynamicGridSubMesh = -1;
+	BoundingBox dynamicGridBounds;
+	GLuint dynamicGridVao = 0;
+	GLuint depthDynamicGridVao = 0;
+	if (options.dynamicGridSize >= 2)
 	{
-		// Our texture is 2D, so we bind our texture to the GL_TEXTURE_2D target
-		glBindTexture(GL_TEXTURE_2D, tex1);
+		MeshBuilder gridBuilder(vertexLayout.stride);
+		dynamicGridSubMesh = BuildDynamicGrid(gridBuilder, vertexLayout, options.dynamicGridSize);
+		if (dynamicGridSubMesh >= 0 && dynamicGrid.Create(gridBuilder, vertexLayout))
+		{
+			// The waves never leave this box, so the grid is culled with it instead of the bounds of its vertices
+			float halfSize = 0.5f * (options.dynamicGridSize - 1);
+			float waveHeight = DYNAMIC_GRID_WAVE_HEIGHT * (options.dynamicGridSize - 1);
+			dynamicGridBounds.min = glm::vec3(-halfSize, -waveHeight, -halfSize);
+			dynamicGridBounds.max = glm::vec3(halfSize, waveHeight, halfSize);
+
+			glGenVertexArrays(1, &dynamicGridVao);
+			BindVertexArray(dynamicGridVao);
+			dynamicGrid.SetVertexArray();
+			glGenVertexArrays(1, &depthDynamicGridVao);
+			BindVertexArray(depthDynamicGridVao);
+			dynamicGrid.SetVertexArray(1u << POSITION_STREAM);
+			BindVertexArray(0);
+		}
+		else
+		{
+			dynamicGridSubMesh = -1;
+		}
+	}
 
-		// Set the filtering methods for magnification and minification
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	// A model from a file (--model) is a mesh of its own, drawn as one object on the floor, 1.5 units tall or wide.
+	// It has simplified levels of detail that share its vertices, and each frame it is drawn with the simplest one
+	// whose error is too small to see at its distance from the camera. Each level is split into meshlets,
+	// and with --meshlet-culling only the meshlets that may be visible are drawn.
+	// Its positions are full floats: half floats keep only 11 bits and end at 65504, which would merge the nearby
+	// vertices of a large or detailed model (e.g. one in millimetres) before it is simplified and split into meshlets.
+	VertexLayout modelLayout;
+	AddVertexAttribute(modelLayout, 0, VertexAttributeFormat::Float3, POSITION_STREAM);		// Position
+	AddVertexAttribute(modelLayout, 1, VertexAttributeFormat::Unorm8x4, ATTRIBUTE_STREAM);	// Color
+	AddVertexAttribute(modelLayout, 2, VertexAttributeFormat::Half2, ATTRIBUTE_STREAM);		// UV-coordinates
+	AddVertexAttribute(modelLayout, 3, VertexAttributeFormat::Snorm10x3, ATTRIBUTE_STREAM);	// Normal
+	Mesh modelMesh;
+	int modelSubMesh = -1;
+	std::vector<MeshLod> modelLods;
+	int modelLod = 0;
+	std::vector<Meshlet> modelMeshlets;
+	std::vector<unsigned char> modelMeshletVisible;
+	MeshletDrawList modelMeshletDraws;
+	bool modelMeshletsCulled = false;
+	float modelScale = 1.0f;
+	glm::mat4 modelPlacement(1.0f);
+	GLuint modelVao = 0;
+	GLuint depthModelVao = 0;
+	if (!options.modelPath.empty())
+	{
+		// A model that was imported before is loaded from its mesh cache, which is only used if it was made from
+		// the same file with the same settings. Its blobs go straight into the buffers, without parsing anything.
+		std::chrono::steady_clock::time_point modelLoadStart = std::chrono::steady_clock::now();
+		uint32_t modelCacheFlags = (options.meshOptimization ? MESH_CACHE_OPTIMIZED : 0)
+			| static_cast<uint32_t>(options.lodCount) << MESH_CACHE_LOD_SHIFT;
+		std::string modelCachePath = GetMeshCachePath(options.modelPath);
+		uint64_t modelSourceHash = 0;
+		bool modelHashed = options.meshCache && HashMeshSource(options.modelPath, modelSourceHash);
+		bool modelCached = modelHashed
+			&& LoadMeshCache(modelCachePath, modelSourceHash, modelCacheFlags, modelLayout, GL_STATIC_DRAW, modelMesh, modelLods, modelMeshlets);
+		bool modelLoaded = modelCached;
+		MeshOptimizeStats modelOptimizeStats;
+		if (!modelCached)
+		{
+			MeshBuilder modelBuilder(modelLayout.stride);
+			int firstModelPart = ImportMesh(options.modelPath, modelLayout, importAttributes, modelBuilder);
+			if (firstModelPart >= 0)
+			{
+				int fullModel = modelBuilder.CombineSubMeshes(firstModelPart, static_cast<int>(modelBuilder.GetSubMeshes().size()) - firstModelPart);
+				modelLods = GenerateMeshLods(modelBuilder, modelLayout, fullModel, options.lodCount);
+				if (options.meshOptimization)
+				{
+					modelOptimizeStats = OptimizeMesh(modelBuilder, modelLayout);
+				}
+
+				// The meshlets are made after the triangles are reordered, since they are ranges of the index buffer
+				for (MeshLod& lod : modelLods)
+				{
+					lod.firstMeshlet = static_cast<int>(modelMeshlets.size());
+					lod.meshletCount = static_cast<int>(BuildMeshlets(modelBuilder, modelLayout, lod.subMesh, modelMeshlets));
+				}
+				modelMesh = CreateMesh(modelBuilder, modelLayout, GL_STATIC_DRAW);
+				modelLoaded = true;
+				if (modelHashed)
+				{
+					WriteMeshCache(modelCachePath, modelSourceHash, modelCacheFlags, modelBuilder, modelLayout, modelMesh.subMeshes, modelLods,
+						modelMeshlets);
+				}
+			}
+		}
+		std::chrono::duration<double, std::milli> modelLoadTime = std::chrono::steady_clock::now() - modelLoadStart;
 
-		// Set the wrapping method for the s-axis (x-axis) and t-axis (y-axis)
-		// Try experimenting with different wrapping methods introduced in the textures slide set
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		if (modelLoaded && !modelLods.empty())
+		{
+			// The first level of detail is the submesh that covers the whole model
+			modelSubMesh = modelLods[0].subMesh;
+			const BoundingBox& bounds = modelMesh.subMeshes[modelSubMesh].bounds;
+			glm::vec3 size = bounds.max - bounds.min;
+			modelScale = 1.5f / std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+			modelPlacement = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, -0.9f, -3.0f));
+			modelPlacement = glm::scale(modelPlacement, glm::vec3(modelScale));
+			modelPlacement = glm::translate(modelPlacement, -glm::vec3(0.5f * (bounds.min.x + bounds.max.x), bounds.min.y, 0.5f * (bounds.min.z + bounds.max.z)));
+
+			glGenVertexArrays(1, &modelVao);
+			BindVertexArray(modelVao);
+			SetMeshVertexArray(modelMesh, modelLayout);
+			glGenVertexArrays(1, &depthModelVao);
+			BindVertexArray(depthModelVao);
+			SetMeshVertexArray(modelMesh, modelLayout, 1u << POSITION_STREAM);
+			BindVertexArray(0);
+
+			if (options.headless)
+			{
+				std::cout << "Model: " << modelMesh.subMeshes[modelSubMesh].indexCount / 3 << " triangles and " << modelMesh.vertexCount << " vertices, "
+					<< (modelCached ? "loaded from " + modelCachePath : "imported") << " in " << modelLoadTime.count() << " ms" << std::endl;
+				if (options.meshOptimization && !modelCached)
+				{
+					std::cout << "Model: ACMR " << modelOptimizeStats.acmrBefore << " -> " << modelOptimizeStats.acmrAfter
+						<< " in " << modelOptimizeStats.clusterCount << " overdraw clusters" << std::endl;
+				}
+				if (modelLods.size() > 1)
+				{
+					std::cout << "Model: " << modelLods.size() << " levels of detail (triangles, error):";
+					for (const MeshLod& lod : modelLods)
+					{
+						std::cout << " " << modelMesh.subMeshes[lod.subMesh].indexCount / 3 << " " << lod.error;
+					}
+					std::cout << std::endl;
+				}
+				std::cout << "Model: " << modelLods[0].meshletCount << " meshlets" << std::endl;
+			}
+		}
+	}
 
-		// Upload the image data to GPU memory
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, imageWidth, imageHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
+	// The stress scene draws many copies of the cube. With instancing, their model matrices and materials
+	// are stored once in an instance buffer, and all of them are drawn with a single draw call.
+	std::vector<InstanceData> stressCubes = CreateStressCubes(options.stressCubeCount, MATERIAL_COUNT);
+	InstanceBuffer stressInstanceBuffer;
+	GLuint instancedVao = 0;
 
-		// If we set minification to use mipmaps, we can tell OpenGL to generate the mipmaps for us
-		//glGenerateMipmap(GL_TEXTURE_2D);
+	// The instanced draw is culled as a whole, with a box around all of the cubes
+	std::vector<BoundingBox> stressCubeBounds(stressCubes.size());
+	BoundingBox stressBounds;
+	for (size_t i = 0; i < stressCubes.size(); ++i)
+	{
+		stressCubeBounds[i] = TransformBoundingBox(mesh.subMeshes[cube].bounds, stressCubes[i].modelMatrix);
+		ExpandBoundingBox(stressBounds, stressCubeBounds[i]);
+	}
 
-		// Once we have copied the data over to the GPU, we can delete
-		// the data on the CPU side, since we won't be using it anymore
-		stbi_image_free(imageData);
-		imageData = nullptr;
+	// Without instancing, every cube is culled on its own. The cubes never move, so the hierarchy over their boxes
+	// is built once, and culling only visits the parts of the grid that are near the edges of the frustum.
+	// It is also used to find the cube under the mouse cursor, which needs the triangles of the cube.
+	Bvh stressBvh;
+	if (!stressCubes.empty())
+	{
+		stressBvh.Build(stressCubeBounds.data(), stressCubeBounds.size());
 	}
-	else
+	std::vector<glm::vec3> cubeTriangles;
+	const SubMesh& cubeSubMesh = mesh.subMeshes[cube];
+	for (GLsizei i = 0; i < cubeSubMesh.indexCount; ++i)
 	{
-		std::cerr << "Failed to load bioshock.jpg" << std::endl;
+		GLuint index = meshBuilder.GetIndices()[cubeSubMesh.firstIndex + i];
+		cubeTriangles.push_back(glm::vec3(UnpackVertexAttribute(vertexLayout, 0, meshBuilder.GetVertexData() + index * vertexLayout.stride)));
 	}
 
-	// Create our other texture (bioshock.jpg)
-	GLuint tex2;
-	glGenTextures(3, &tex2);
+	// The data that changes every frame (the camera and light uniforms, and the instances of the stress cubes
+	// that are inside the frustum) is written into a new part of a stream buffer each frame, so writing it never
+	// waits for the GPU to finish drawing the previous frames. The frame uniforms take less than 1 KB with padding.
+	bool streamStressInstances = !stressCubes.empty() && options.instancing && options.culling && options.bvhCulling;
+	bool streamDynamicGrid = dynamicGridSubMesh >= 0 && options.dynamicUpload == DynamicMeshUpload::Stream;
+	StreamBuffer streamBuffer = CreateStreamBuffer(1024 + (streamStressInstances ? stressCubes.size() * sizeof(InstanceData) : 0)
+		+ (streamDynamicGrid ? dynamicGrid.GetVertexCount() * vertexLayout.stride + 64 : 0));
+	GLsizei stressInstanceCount = static_cast<GLsizei>(stressCubes.size());
 
-	// Read the image data of our bioshock.jpg image
-	imageData = stbi_load("color.jpg", &imageWidth, &imageHeight, &numChannels, 0);
+	if (!stressCubes.empty() && options.instancing)
+	{
+		// Same vertex attributes as 'vao', plus the per-instance attributes.
+		// Without the hierarchy, the cubes are drawn (or culled) all together, so the instances are uploaded once.
+		glGenVertexArrays(1, &instancedVao);
+		BindVertexArray(instancedVao);
+		SetMeshVertexArray(mesh, vertexLayout);
+		if (streamStressInstances)
+		{
+			SetInstanceAttributes(streamBuffer.id, 0);
+		}
+		else
+		{
+			stressInstanceBuffer = CreateInstanceBuffer(stressInstanceCount, GL_STATIC_DRAW);
+			UpdateInstanceBuffer(stressInstanceBuffer, stressCubes.data(), stressInstanceCount);
+			SetInstanceAttributes(stressInstanceBuffer);
+		}
+		BindVertexArray(0);
+	}
 
-	// Make sure that we actually loaded the image before uploading the data to the GPU
-	if (imageData != nullptr)
+	// The depth pre-pass only reads the position stream of the mesh
+	GLuint depthVao;
+	glGenVertexArrays(1, &depthVao);
+	BindVertexArray(depthVao);
+	SetMeshVertexArray(mesh, vertexLayout, 1u << POSITION_STREAM);
+	BindVertexArray(0);
+
+	GLuint depthInstancedVao = 0;
+	if (instancedVao != 0)
 	{
-		// Our texture is 2D, so we bind our texture to the GL_TEXTURE_2D target
-		glBindTexture(GL_TEXTURE_2D, tex2);
+		glGenVertexArrays(1, &depthInstancedVao);
+		BindVertexArray(depthInstancedVao);
+		SetMeshVertexArray(mesh, vertexLayout, 1u << POSITION_STREAM);
+		if (streamStressInstances)
+		{
+			SetInstanceAttributes(streamBuffer.id, 0);
+		}
+		else
+		{
+			SetInstanceAttributes(stressInstanceBuffer);
+		}
+		BindVertexArray(0);
+	}
 
-		// Set the filtering methods for magnification and minification
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	// Create a shader program
+	ShaderProgram program = CreateShaderProgram("main.vsh", "main.fsh");
 
-		// Set the wrapping method for the s-axis (x-axis) and t-axis (y-axis)
-		// Try experimenting with different wrapping methods introduced in the textures slide set
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// The camera and light data live in the stream buffer, and the binding is moved to the part of each frame
+	program.BindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
 
-		// Upload the image data to GPU memory
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, imageWidth, imageHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
+	// The materials never change, so they are uploaded once, and each object only binds its own material
+	program.BindUniformBlock("MaterialUniforms", MATERIAL_UNIFORMS_BINDING);
+	UniformBuffer materialUniformBuffer = CreateUniformBuffer(MATERIAL_UNIFORMS_BINDING, sizeof(MaterialUniforms), MATERIAL_COUNT, GL_STATIC_DRAW);
 
-		// If we set minification to use mipmaps, we can tell OpenGL to generate the mipmaps for us
-		//glGenerateMipmap(GL_TEXTURE_2D);
+	MaterialUniforms materials[MATERIAL_COUNT];
+	materials[QUAD_MATERIAL] = CreateMaterial(0.1f, 0.1f, 1.0f, 0.5f);
+	materials[ROOM_MATERIAL] = CreateMaterial(0.1f, 5.0f, 1.0f, 1.0f);
+	materials[BODY_MATERIAL] = CreateMaterial(0.1f, 0.1f, 1.0f, 1.0f);
+	materials[HEAD_MATERIAL] = CreateMaterial(0.1f, 0.1f, 1.0f, 0.5f);
+	for (int i = 0; i < MATERIAL_COUNT; ++i)
+	{
+		UpdateUniformBuffer(materialUniformBuffer, i, &materials[i]);
+	}
 
-		// Once we have copied the data over to the GPU, we can delete
-		// the data on the CPU side, since we won't be using it anymore
-		stbi_image_free(imageData);
-		imageData = nullptr;
+	// The instanced shader reads the same materials as an array, indexed by the material of each instance
+	ShaderProgram instancedProgram;
+	UniformBuffer materialArrayUniformBuffer;
+	if (instancedVao != 0)
+	{
+		instancedProgram = CreateShaderProgram("instanced.vsh", "instanced.fsh");
+		instancedProgram.BindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+		instancedProgram.BindUniformBlock("MaterialArrayUniforms", MATERIAL_ARRAY_UNIFORMS_BINDING);
+
+		static_assert(MATERIAL_COUNT <= MAX_MATERIALS, "The material array of instanced.fsh is too small");
+		materialArrayUniformBuffer = CreateUniformBuffer(MATERIAL_ARRAY_UNIFORMS_BINDING, sizeof(MaterialUniforms) * MAX_MATERIALS, 1, GL_STATIC_DRAW);
+		MaterialUniforms materialArray[MAX_MATERIALS] = {};
+		std::copy(materials, materials + MATERIAL_COUNT, materialArray);
+		UpdateUniformBuffer(materialArrayUniformBuffer, 0, materialArray);
+
+		UseProgram(instancedProgram.id);
+		instancedProgram.SetUniform("tex", 0);
 	}
-	else
+
+	// Shaders of the depth pre-pass, which compute the same positions as main.vsh and instanced.vsh
+	ShaderProgram depthProgram = CreateShaderProgram("depth.vsh", "depth.fsh");
+	depthProgram.BindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+	ShaderProgram depthInstancedProgram;
+	if (instancedVao != 0)
 	{
-		std::cerr << "Failed to load color.jpg" << std::endl;
+		depthInstancedProgram = CreateShaderProgram("depthInstanced.vsh", "depth.fsh");
+		depthInstancedProgram.BindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
 	}
+	depthPrepassMode = options.depthPrepass;
 
-	// Create a shader program
-	GLuint program = CreateShaderProgram("main.vsh", "main.fsh");
+	// The camera starts at the origin, so the target point is also the direction it looks in
+	float cameraYaw = glm::radians(options.cameraYaw);
+	target = glm::vec3(std::cos(cameraYaw), 0.0f, std::sin(cameraYaw));
+	if (options.headless)
+	{
+		std::cout << "Depth pre-pass mode: " << GetDepthPrepassModeName(depthPrepassMode) << std::endl;
+	}
+
+	// Make sure that all textures are uploaded before we start drawing
+	textureLoader.WaitAll();
+	if (options.headless)
+	{
+		std::chrono::duration<double, std::milli> textureLoadTime = std::chrono::steady_clock::now() - textureLoadStart;
+		std::cout << "Textures: loaded in " << textureLoadTime.count() << " ms using "
+			<< textureLoader.GetThreadCount() << " threads" << std::endl;
+	}
 
 	// Tell OpenGL the dimensions of the region where stuff will be drawn.
 	// For now, tell OpenGL to use the whole screen
@@ -789,16 +706,45 @@ int main()
 	bool hasToggledHead = false;
 	float timer = 0.0f;
 	float offsetTime = 0.0f;
+
+	// Draws of the current frame, and the queue that sorts them.
+	// Both keep their memory from frame to frame, so filling them does not allocate after the first frame.
+	size_t maxSceneDrawCount = 16 + stressCubes.size();
+	std::vector<SceneDraw> sceneDraws;
+	sceneDraws.reserve(maxSceneDrawCount);
+	std::vector<BoundingBox> sceneBounds;
+	sceneBounds.reserve(maxSceneDrawCount);
+	std::vector<unsigned char> sceneVisible;
+	sceneVisible.reserve(maxSceneDrawCount);
+	std::vector<int> visibleStressCubes;
+	visibleStressCubes.reserve(stressCubes.size());
+	std::vector<size_t> occludedDraws;
+	occludedDraws.reserve(maxSceneDrawCount);
+
+	// Visibility of the objects from earlier frames, and the occlusion queries that update it
+	OcclusionCuller occlusionCuller;
+	RenderQueue renderQueue(maxSceneDrawCount * static_cast<size_t>(RenderPass::Count));
+
+	// Frame times and draw calls; in headless mode we render a fixed number of frames and report them at the end
+	FrameStats frameStats(options.warmupFrameCount);
+	int frameIndex = 0;
+	int totalFrameCount = options.warmupFrameCount + options.frameCount;
+
 	// Render loop
-	while (!glfwWindowShouldClose(window))
+	while (options.headless ? frameIndex < totalFrameCount : !glfwWindowShouldClose(window))
 	{
+		frameStats.BeginFrame();
+
+		// Headless runs use a fixed 60 Hz time step so that every run renders the same frames
+		float currentTime = options.headless ? frameIndex / 60.0f : static_cast<float>(glfwGetTime());
+
 		if (timer > 1.5f)
 		{
 			offsetTime += timer;
 			timer = 0;
 		}
 
-		timer = roundOff(glfwGetTime()) - offsetTime;
+		timer = roundOff(currentTime) - offsetTime;
 
 		if (timer == 0.25f)
 		{
@@ -840,22 +786,22 @@ int main()
 
 		// per-frame time logic
 		// --------------------
-		float currentFrame = static_cast<float>(glfwGetTime());
+		float currentFrame = currentTime;
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
-		// input
+		// input (there is no window to read input from in headless mode)
 		// -----
-		processInput(window);
-
-		// Clear the colors and depth values (since we enabled depth testing) in our off-screen framebuffer
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (!options.headless)
+		{
+			processInput(window);
+		}
 
-		// Use the shader program that we created
-		glUseProgram(program);
+		// Clear the colors, depth values (since we enabled depth testing) and overdraw counts in our off-screen framebuffer
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-		// Use the vertex array object that we created
-		glBindVertexArray(vao);
+		// The objects of the scene are collected first, and then drawn by each pass
+		sceneDraws.clear();
 
 		// Construct our view matrix (for the "camera")
 		// Let's say we want to position our camera to be at (2, 1, 4) and looking down at the origin (0, 0, 0).
@@ -868,34 +814,6 @@ int main()
 		glm::mat4 lookAtMatrix = glm::lookAt(eye, target, up);
 
 		viewMatrix = viewMatrix * lookAtMatrix;
-		GLint viewMatrixUniform = glGetUniformLocation(program, "viewMatrix");
-		glUniformMatrix4fv(viewMatrixUniform, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-
-		//uniform for camera/eye position
-		GLint cameraPositionUniform = glGetUniformLocation(program, "cameraPosition");
-		glUniform3fv(cameraPositionUniform, 1, glm::value_ptr(cameraPosition));
-
-		//Phong Lighting Model uniforms
-		GLint ambientComponentUniform = glGetUniformLocation(program, "ambientComponent");
-		GLint ambientIntensityUniform = glGetUniformLocation(program, "ambientIntensity");
-		GLint diffuseComponentUniform = glGetUniformLocation(program, "diffuseComponent");
-		GLint diffuseIntensityUniform = glGetUniformLocation(program, "diffuseIntensity");
-		GLint specularComponentUniform = glGetUniformLocation(program, "specularComponent");
-		GLint specularIntensityUniform = glGetUniformLocation(program, "specularIntensity");
-		GLint shineUniform = glGetUniformLocation(program, "shine");
-
-		// Passing the light uniforms
-		glUniform1f(ambientComponentUniform, ambientComponent);
-		glUniform3fv(ambientIntensityUniform, 1, glm::value_ptr(ambientIntensity));
-		glUniform1f(diffuseComponentUniform, diffuseComponent);
-		glUniform3fv(diffuseIntensityUniform, 1, glm::value_ptr(diffuseIntensity));
-		glUniform1f(specularComponentUniform, specularComponent);
-		glUniform3fv(specularIntensityUniform, 1, glm::value_ptr(specularIntensity));
-		glUniform1f(shineUniform, shine);
-
-		//uniform for light position
-		GLint lightPosUniform = glGetUniformLocation(program, "lightPos");
-		glUniform3fv(lightPosUniform, 1, glm::value_ptr(lightPos));
 
 		// Construct our view frustrum (projection matrix) using the following parameters
 		float fieldOfViewY = glm::radians(45.0f); // Field of view
@@ -903,12 +821,60 @@ int main()
 		float nearPlane = 0.1f; // Near plane, minimum distance from the camera where things will be rendered
 		float farPlane = 30.0f; // Far plane, maximum distance from the camera where things will be rendered
 		glm::mat4 projectionMatrix = glm::perspective(fieldOfViewY, aspectRatio, nearPlane, farPlane);
+		Frustum frustum = ExtractFrustum(projectionMatrix * viewMatrix);
 
-		GLint projectionMatrixUniform = glGetUniformLocation(program, "projectionMatrix");
-		glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+		// Pick the stress cube under the cursor when the left mouse button is pressed
+		if (!options.headless && !stressCubes.empty())
+		{
+			bool pressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+			if (pressed && !pickButtonDown)
+			{
+				double cursorX, cursorY;
+				int windowSizeX, windowSizeY;
+				glfwGetCursorPos(window, &cursorX, &cursorY);
+				glfwGetWindowSize(window, &windowSizeX, &windowSizeY);
+				glm::vec2 screenPoint(2.0f * static_cast<float>(cursorX) / windowSizeX - 1.0f, 1.0f - 2.0f * static_cast<float>(cursorY) / windowSizeY);
+
+				int pickedCube = PickStressCube(stressBvh, stressCubes, cubeTriangles, projectionMatrix * viewMatrix, screenPoint);
+				if (pickedCube >= 0)
+				{
+					std::cout << "Picked stress cube " << pickedCube << " at " << stressCubes[pickedCube].modelMatrix[3].x << ", "
+						<< stressCubes[pickedCube].modelMatrix[3].y << ", " << stressCubes[pickedCube].modelMatrix[3].z << std::endl;
+				}
+			}
+			pickButtonDown = pressed;
+		}
 
-		// We retrieve our 'modelMatrix' uniform variable from the vertex shader,
-		GLint modelMatrixUniform = glGetUniformLocation(program, "modelMatrix");
+		// Write the camera matrices, camera/eye position and light position into the stream buffer
+		FrameUniforms frameUniforms = {};
+		frameUniforms.viewMatrix = viewMatrix;
+		frameUniforms.projectionMatrix = projectionMatrix;
+		frameUniforms.cameraPosition = cameraPosition;
+		frameUniforms.lightPos = lightPos;
+		GLintptr frameUniformsOffset = WriteStreamBuffer(streamBuffer, &frameUniforms, sizeof(FrameUniforms), streamBuffer.uniformAlignment);
+		if (frameUniformsOffset >= 0)
+		{
+			glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, streamBuffer.id, frameUniformsOffset, sizeof(FrameUniforms));
+		}
+
+		// Move a band of rows of the animated grid (all of them by default), and send the rows that moved.
+		// The band moves on every frame, so every row catches up with the wave every few frames.
+		if (dynamicGridSubMesh >= 0)
+		{
+			int rowCount = std::max(1, static_cast<int>(options.dynamicFraction * options.dynamicGridSize + 0.5f));
+			int firstRow = static_cast<int>((static_cast<long long>(frameIndex) * rowCount) % options.dynamicGridSize);
+			AnimateDynamicGrid(dynamicGrid, options.dynamicGridSize, firstRow, rowCount, currentTime);
+			dynamicGrid.Upload(options.dynamicUpload, &streamBuffer);
+
+			// Streamed vertices are in a different part of the stream buffer every frame
+			if (streamDynamicGrid)
+			{
+				BindVertexArray(dynamicGridVao);
+				dynamicGrid.SetVertexArray();
+				BindVertexArray(depthDynamicGridVao);
+				dynamicGrid.SetVertexArray(1u << POSITION_STREAM);
+			}
+		}
 
 		// Create a 4x4 matrix that will be our model matrix,
 		// and initialize it to be the identity matrix.
@@ -934,37 +900,9 @@ int main()
 		modelMatrix = glm::scale(modelMatrix, scaleVector);
 		// At this point, we now have: Identity * Translation * Rotate * Scale
 
-		// Set the value of our transformationMatrix uniform variable in the vertex shader to our matrix here
-		// The first parameter is the uniform location of the uniform we want to set the value of.
-		// The second parameter is the number of matrices to set the uniform with (we only have 1 matrix, so we give it a value of 1)
-		// The third parameter is a boolean flag to indicate whether to transpose the matrix or not. In our case, we do not need to since glm makes matrix that are column-major (same with OpenGL)
-		// The fourth parameter is a pointer to the matrices that we will set the uniform (actual data)
-		glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-		ambientComponent = 0.1f;
-		diffuseComponent = 0.1f;
-		specularComponent = 1.0f;
-		shine = 0.5f;
-
-		// Passing the light uniforms
-		glUniform1f(ambientComponentUniform, ambientComponent);
-		glUniform3fv(ambientIntensityUniform, 1, glm::value_ptr(ambientIntensity));
-		glUniform1f(diffuseComponentUniform, diffuseComponent);
-		glUniform3fv(diffuseIntensityUniform, 1, glm::value_ptr(diffuseIntensity));
-		glUniform1f(specularComponentUniform, specularComponent);
-		glUniform3fv(specularIntensityUniform, 1, glm::value_ptr(specularIntensity));
-		glUniform1f(shineUniform, shine);
-
-		// Draw a quad (4 vertices) using a triangle-fan
-		// Draw the cube (36 vertices) using a triangle
-		//glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		// Bind our bioshock.jpg texture to texture unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, 4);
-
+		// Add the object to the draws of this frame, with its material and texture
 		//Drawing the QUAD
-		glDrawArrays(GL_TRIANGLES, 36, 6);
+		sceneDraws.push_back(CreateSceneDraw(modelMatrix, QUAD_MATERIAL, tex2, quad));
 
 		// Now for the second quad (wall.jpg), let's scale it by 1.5, rotate it by 45 degrees along the z-axis,
 		// and then move it to the right and up.
@@ -980,29 +918,8 @@ int main()
 		scaleVector = glm::vec3(10.0f, 10.0f, 10.0f);
 		modelMatrix = glm::scale(modelMatrix, scaleVector);
 
-		// We now update our moelMatrix uniform to have the new model matrix
-		glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-		ambientComponent = 0.1f;
-		diffuseComponent = 5.0f;
-		specularComponent = 1.0f;
-		shine = 1.0f;
-
-		// Passing the light uniforms
-		glUniform1f(ambientComponentUniform, ambientComponent);
-		glUniform3fv(ambientIntensityUniform, 1, glm::value_ptr(ambientIntensity));
-		glUniform1f(diffuseComponentUniform, diffuseComponent);
-		glUniform3fv(diffuseIntensityUniform, 1, glm::value_ptr(diffuseIntensity));
-		glUniform1f(specularComponentUniform, specularComponent);
-		glUniform3fv(specularIntensityUniform, 1, glm::value_ptr(specularIntensity));
-		glUniform1f(shineUniform, shine);
-
-		// Bind our bioshock.jpg texture to texture unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, 1);
-
 		// Drawing the ROOM
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		sceneDraws.push_back(CreateSceneDraw(modelMatrix, ROOM_MATERIAL, tex0, cube));
 		
 		// Create a 4x4 matrix that will be our model matrix,
 		// and initialize it to be the identity matrix.
@@ -1039,33 +956,8 @@ int main()
 		modelMatrix = glm::scale(modelMatrix, scaleVector);
 		// At this point, we now have: Identity * Translation * Scale
 
-		// Set the value of our transformationMatrix uniform variable in the vertex shader to our matrix here
-		// The first parameter is the uniform location of the uniform we want to set the value of.
-		// The second parameter is the number of matrices to set the uniform with (we only have 1 matrix, so we give it a value of 1)
-		// The third parameter is a boolean flag to indicate whether to transpose the matrix or not. In our case, we do not need to since glm makes matrix that are column-major (same with OpenGL)
-		// The fourth parameter is a pointer to the matrices that we will set the uniform (actual data)
-		glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-		ambientComponent = 0.1f;
-		diffuseComponent = 0.1f;
-		specularComponent = 1.0f;
-		shine = 1.0f;
-
-		// Passing the light uniforms
-		glUniform1f(ambientComponentUniform, ambientComponent);
-		glUniform3fv(ambientIntensityUniform, 1, glm::value_ptr(ambientIntensity));
-		glUniform1f(diffuseComponentUniform, diffuseComponent);
-		glUniform3fv(diffuseIntensityUniform, 1, glm::value_ptr(diffuseIntensity));
-		glUniform1f(specularComponentUniform, specularComponent);
-		glUniform3fv(specularIntensityUniform, 1, glm::value_ptr(specularIntensity));
-		glUniform1f(shineUniform, shine);
-
-		// Bind our pepe.jpg texture to texture unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex1);
-
 		// Drawing the BODY
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		sceneDraws.push_back(CreateSceneDraw(modelMatrix, BODY_MATERIAL, tex1, cube));
 
 		// Now for the second quad (bioshock.jpg), let's scale it by 1.5, rotate it by 45 degrees along the z-axis,
 		// and then move it to the right and up.
@@ -1096,35 +988,9 @@ int main()
 		scaleVector = glm::vec3(0.5f, 0.5f, 0.5f);
 		modelMatrix = glm::scale(modelMatrix, scaleVector);
 
-		// We now update our moelMatrix uniform to have the new model matrix
-		glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-		ambientComponent = 0.1f;
-		diffuseComponent = 0.1f;
-		specularComponent = 1.0f;
-		shine = 0.5f;
-
-		// Passing the light uniforms
-		glUniform1f(ambientComponentUniform, ambientComponent);
-		glUniform3fv(ambientIntensityUniform, 1, glm::value_ptr(ambientIntensity));
-		glUniform1f(diffuseComponentUniform, diffuseComponent);
-		glUniform3fv(diffuseIntensityUniform, 1, glm::value_ptr(diffuseIntensity));
-		glUniform1f(specularComponentUniform, specularComponent);
-		glUniform3fv(specularIntensityUniform, 1, glm::value_ptr(specularIntensity));
-		glUniform1f(shineUniform, shine);
-
-		// Bind our bioshock.jpg texture to texture unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex2);
-
 		// Drawing the HEAD
-		glDrawArrays(GL_TRIANGLES, 6, 6);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex1);
-
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glDrawArrays(GL_TRIANGLES, 12, 24);
+		sceneDraws.push_back(CreateSceneDraw(modelMatrix, HEAD_MATERIAL, tex2, cubeBack));
+		sceneDraws.push_back(CreateSceneDraw(modelMatrix, HEAD_MATERIAL, tex1, cubeAllButBack));
 
 		// Now for the second quad (bioshock.jpg), let's scale it by 1.5, rotate it by 45 degrees along the z-axis,
 		// and then move it to the right and up.
@@ -1155,43 +1021,430 @@ int main()
 		scaleVector = glm::vec3(1.0f, 1.0f, 1.0f);
 		modelMatrix = glm::scale(modelMatrix, scaleVector);
 
-		// We now update our moelMatrix uniform to have the new model matrix
-		glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+		// Drawing the HAT (with the material of the head)
+		sceneDraws.push_back(CreateSceneDraw(modelMatrix, HEAD_MATERIAL, tex1, hat));
+
+		// Drawing the animated GRID on the floor, 3 units wide
+		if (dynamicGridSubMesh >= 0)
+		{
+			modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(2.5f, -0.9f, -4.0f));
+			modelMatrix = glm::scale(modelMatrix, glm::vec3(3.0f / (options.dynamicGridSize - 1)));
+			SceneDraw gridDraw = CreateSceneDraw(modelMatrix, QUAD_MATERIAL, tex2, dynamicGridSubMesh);
+			gridDraw.program = DYNAMIC_GRID_PROGRAM;
+			sceneDraws.push_back(gridDraw);
+		}
 
-		// Bind our bioshock.jpg texture to texture unit 0
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex1);
+		// Drawing the MODEL from --model on the floor, in front of the body, with the level of detail whose error
+		// covers at most --lod-error pixels. The distance is to the nearest point of the bounding sphere.
+		if (modelSubMesh >= 0)
+		{
+			const BoundingSphere& modelSphere = modelMesh.subMeshes[modelSubMesh].sphere;
+			glm::vec3 modelCenter = glm::vec3(viewMatrix * modelPlacement * glm::vec4(modelSphere.center, 1.0f));
+			float modelDistance = std::max(glm::length(modelCenter) - modelSphere.radius * modelScale, nearPlane);
+			float modelPixelsPerUnit = modelScale * GetLodPixelsPerUnit(fieldOfViewY, windowHeight, modelDistance);
+			modelLod = SelectMeshLod(modelLods, modelPixelsPerUnit, options.lodPixelError, modelLod);
+
+			SceneDraw modelDraw = CreateSceneDraw(modelPlacement, BODY_MATERIAL, tex2, modelLods[modelLod].subMesh);
+			modelDraw.program = MODEL_PROGRAM;
+			sceneDraws.push_back(modelDraw);
+
+			// The meshlets are tested in the space of the model, so their bounds do not have to be transformed
+			// (the model is only scaled uniformly, which keeps the angles of the normal cones)
+			const MeshLod& lod = modelLods[modelLod];
+			modelMeshletsCulled = options.meshletCulling && lod.meshletCount > 0;
+			if (modelMeshletsCulled)
+			{
+				const Meshlet* lodMeshlets = modelMeshlets.data() + lod.firstMeshlet;
+				Frustum modelFrustum = ExtractFrustum(projectionMatrix * viewMatrix * modelPlacement);
+				glm::vec3 modelCameraPosition = glm::vec3(glm::inverse(viewMatrix * modelPlacement)[3]);
+				modelMeshletVisible.resize(lod.meshletCount);
+				size_t visibleCount = CullMeshlets(lodMeshlets, lod.meshletCount, modelFrustum, modelCameraPosition, modelMeshletVisible.data());
+				AddFrameCounter(FrameCounter::MeshletsCulled, lod.meshletCount - visibleCount);
+				CompactMeshletDraws(lodMeshlets, modelMeshletVisible.data(), lod.meshletCount, modelMesh.indexType, modelMeshletDraws);
+			}
+		}
 
-		// Drawing the HAT
-		glDrawArrays(GL_TRIANGLES, 66, 12);
+		// The objects above are added in the same order every frame, so their index identifies them,
+		// and the stress cubes come after them
+		int sceneObjectCount = static_cast<int>(sceneDraws.size());
+		for (int i = 0; i < sceneObjectCount; ++i)
+		{
+			sceneDraws[i].object = i;
+		}
+
+		// Drawing the STRESS SCENE cubes
+		if (!stressCubes.empty())
+		{
+			if (streamStressInstances)
+			{
+				// Only the cubes that the hierarchy finds inside the frustum are written into this frame's instances,
+				// and the instanced vertex arrays are pointed at them
+				size_t visibleCount = stressBvh.CullFrustum(frustum, visibleStressCubes);
+				AddFrameCounter(FrameCounter::ObjectsCulled, stressCubes.size() - visibleCount);
+
+				GLintptr instanceOffset = -1;
+				InstanceData* instances = visibleCount > 0 ? static_cast<InstanceData*>(AllocateStreamBuffer(streamBuffer,
+					visibleCount * sizeof(InstanceData), sizeof(InstanceData), instanceOffset)) : nullptr;
+				stressInstanceCount = instances != nullptr ? static_cast<GLsizei>(visibleCount) : 0;
+				for (GLsizei i = 0; i < stressInstanceCount; ++i)
+				{
+					instances[i] = stressCubes[visibleStressCubes[i]];
+				}
+
+				if (stressInstanceCount > 0)
+				{
+					BindVertexArray(instancedVao);
+					SetInstanceAttributes(streamBuffer.id, instanceOffset);
+					BindVertexArray(depthInstancedVao);
+					SetInstanceAttributes(streamBuffer.id, instanceOffset);
+
+					SceneDraw instancedDraw = CreateSceneDraw(glm::mat4(1.0f), 0, tex1, cube);
+					instancedDraw.program = INSTANCED_PROGRAM;
+					sceneDraws.push_back(instancedDraw);
+				}
+			}
+			else if (instancedVao != 0)
+			{
+				// All cubes with one draw call (the instances have their own matrices and materials)
+				SceneDraw instancedDraw = CreateSceneDraw(glm::mat4(1.0f), 0, tex1, cube);
+				instancedDraw.program = INSTANCED_PROGRAM;
+				sceneDraws.push_back(instancedDraw);
+			}
+			else if (!options.culling || !options.bvhCulling)
+			{
+				// One draw call per cube, like the objects above
+				for (size_t i = 0; i < stressCubes.size(); ++i)
+				{
+					sceneDraws.push_back(CreateStressCubeDraw(stressCubes[i], tex1, cube, sceneObjectCount + static_cast<int>(i)));
+				}
+			}
+		}
+
+		// Frustum culling: test the world-space bounding box of every draw against the view frustum,
+		// so that objects that are off-screen never reach the render queue
+		sceneBounds.resize(sceneDraws.size());
+		sceneVisible.resize(sceneDraws.size());
+		for (size_t i = 0; i < sceneDraws.size(); ++i)
+		{
+			const SceneDraw& sceneDraw = sceneDraws[i];
+			if (sceneDraw.program == INSTANCED_PROGRAM)
+			{
+				sceneBounds[i] = stressBounds;
+			}
+			else
+			{
+				const Mesh& drawMesh = sceneDraw.program == MODEL_PROGRAM ? modelMesh : mesh;
+				const BoundingBox& bounds = sceneDraw.program == DYNAMIC_GRID_PROGRAM ? dynamicGridBounds : drawMesh.subMeshes[sceneDraw.subMesh].bounds;
+				sceneBounds[i] = TransformBoundingBox(bounds, sceneDraw.modelMatrix);
+			}
+		}
+		if (options.culling)
+		{
+			size_t visibleCount = CullBoundingBoxes(frustum, sceneBounds.data(), sceneBounds.size(), sceneVisible.data());
+			AddFrameCounter(FrameCounter::ObjectsCulled, sceneDraws.size() - visibleCount);
+		}
+		else
+		{
+			std::fill(sceneVisible.begin(), sceneVisible.end(), 1);
+		}
+
+		// The stress cubes that were left out above are culled with the hierarchy,
+		// and only the ones that may be visible are added to the draws
+		if (!stressCubes.empty() && instancedVao == 0 && options.culling && options.bvhCulling)
+		{
+			size_t visibleCount = stressBvh.CullFrustum(frustum, visibleStressCubes);
+			AddFrameCounter(FrameCounter::ObjectsCulled, stressCubes.size() - visibleCount);
+			for (int stressCubeIndex : visibleStressCubes)
+			{
+				sceneDraws.push_back(CreateStressCubeDraw(stressCubes[stressCubeIndex], tex1, cube, sceneObjectCount + stressCubeIndex));
+				sceneBounds.push_back(stressCubeBounds[stressCubeIndex]);
+				sceneVisible.push_back(1);
+			}
+		}
+
+		// Read the results of the occlusion queries that the GPU has finished since the last frame
+		occludedDraws.clear();
+		glm::vec3 eyePosition = glm::vec3(glm::inverse(viewMatrix)[3]);
+		if (options.occlusionCulling)
+		{
+			occlusionCuller.BeginFrame();
+		}
+
+		// Submit every visible draw to the render queue with a sort key, and sort them.
+		// The depth pre-pass goes front to back; the shading pass is grouped by program and texture, then front to back.
+		renderQueue.Clear();
+		for (size_t i = 0; i < sceneDraws.size(); ++i)
+		{
+			if (!sceneVisible[i])
+			{
+				continue;
+			}
+
+			const SceneDraw& sceneDraw = sceneDraws[i];
+
+			// Objects that the last occlusion query found hidden are not drawn, only tested again after the passes.
+			// The box of an object that the camera is inside cannot hide it, so those are always drawn.
+			if (options.occlusionCulling && sceneDraw.object >= 0)
+			{
+				bool visible = occlusionCuller.IsVisible(sceneDraw.object);
+				const BoundingBox& box = sceneBounds[i];
+				bool cameraInside = glm::all(glm::greaterThanEqual(eyePosition, box.min - nearPlane))
+					&& glm::all(glm::lessThanEqual(eyePosition, box.max + nearPlane));
+				if (!visible && !cameraInside)
+				{
+					occludedDraws.push_back(i);
+					AddFrameCounter(FrameCounter::ObjectsOccluded);
+					continue;
+				}
+			}
+			float depth = -(viewMatrix * sceneDraw.modelMatrix[3]).z / farPlane;
+			unsigned int payload = static_cast<unsigned int>(i);
+
+			if (depthPrepassMode != DepthPrepassMode::Off)
+			{
+				renderQueue.Submit(MakeSortKey(RenderPass::Depth, sceneDraw.program, 0, depth, sceneDraw.subMesh), payload);
+			}
+			renderQueue.Submit(MakeSortKey(RenderPass::Opaque, sceneDraw.program, sceneDraw.texture, depth, sceneDraw.subMesh), payload);
+		}
+		renderQueue.Sort();
+
+		// Everything that this frame reads from the stream buffer has been written
+		UnmapStreamBuffer(streamBuffer);
+
+		// Draw the queue in order.
+		// Depth pre-pass: the depth of everything is drawn first, with only the positions and an empty fragment shader,
+		// so that the shading pass runs main.fsh once per pixel instead of once per overlapping surface.
+		RenderPass currentPass = RenderPass::Count;
+		for (const RenderQueueItem& item : renderQueue)
+		{
+			const SceneDraw& sceneDraw = sceneDraws[item.payload];
+			RenderPass pass = GetSortKeyPass(item.key);
+			if (pass != currentPass)
+			{
+				if (pass == RenderPass::Depth)
+				{
+					BeginDepthPrepass();
+				}
+				else
+				{
+					BeginShadingPass(depthPrepassMode);
+					if (options.overdraw)
+					{
+						BeginOverdrawCount();
+					}
+				}
+				currentPass = pass;
+			}
+
+			// The state cache skips these when the previous draw used the same program (the queue groups them)
+			bool instanced = sceneDraw.program == INSTANCED_PROGRAM;
+			bool dynamic = sceneDraw.program == DYNAMIC_GRID_PROGRAM;
+			bool model = sceneDraw.program == MODEL_PROGRAM;
+			const Mesh& drawMesh = dynamic ? dynamicGrid.GetMesh() : model ? modelMesh : mesh;
+			if (pass == RenderPass::Depth)
+			{
+				UseProgram(instanced ? depthInstancedProgram.id : depthProgram.id);
+				BindVertexArray(instanced ? depthInstancedVao : dynamic ? depthDynamicGridVao : model ? depthModelVao : depthVao);
+			}
+			else
+			{
+				UseProgram(instanced ? instancedProgram.id : program.id);
+				BindVertexArray(instanced ? instancedVao : dynamic ? dynamicGridVao : model ? modelVao : vao);
+			}
+
+			if (sceneDraw.program == INSTANCED_PROGRAM)
+			{
+				if (pass == RenderPass::Opaque)
+				{
+					BindTexture(0, GL_TEXTURE_2D, sceneDraw.texture);
+				}
+				DrawSubMeshInstanced(mesh, sceneDraw.subMesh, stressInstanceCount);
+			}
+			else if (pass == RenderPass::Depth)
+			{
+				depthProgram.SetUniform("modelMatrix", sceneDraw.modelMatrix);
+				if (model && modelMeshletsCulled)
+				{
+					DrawMeshlets(modelMesh, modelMeshletDraws);
+				}
+				else
+				{
+					DrawSubMesh(drawMesh, sceneDraw.subMesh);
+				}
+			}
+			else
+			{
+				// The program looks up the uniform location once when it is created, and only calls
+				// glUniformMatrix4fv() if the matrix is different from the one it last sent
+				program.SetUniform("modelMatrix", sceneDraw.modelMatrix);
+				program.SetUniform("normalMatrix", sceneDraw.normalMatrix);
+
+				// Use the material of this object
+				BindUniformBuffer(materialUniformBuffer, sceneDraw.material);
+
+				// Bind the texture of this object to texture unit 0
+				BindTexture(0, GL_TEXTURE_2D, sceneDraw.texture);
+
+				// Every few frames, a visible object is tested again with a query around its own draw call
+				bool query = options.occlusionCulling && sceneDraw.object >= 0 && occlusionCuller.IsQueryDue(sceneDraw.object);
+				if (query)
+				{
+					occlusionCuller.BeginQuery(&sceneDraw.object, 1);
+				}
+				if (model && modelMeshletsCulled)
+				{
+					DrawMeshlets(modelMesh, modelMeshletDraws);
+				}
+				else
+				{
+					DrawSubMesh(drawMesh, sceneDraw.subMesh);
+				}
+				if (query)
+				{
+					occlusionCuller.EndQuery();
+				}
+			}
+		}
+
+		if (options.overdraw)
+		{
+			EndOverdrawCount(windowWidth, windowHeight);
+		}
+		EndShadingPass();
+
+		// Test the hidden objects by drawing their bounding boxes into occlusion queries, now that the depth buffer
+		// holds everything that is visible. Objects that have been hidden for a while share a query with the ones
+		// after them (which are close by, since the hierarchy hands them out in tree order).
+		if (!occludedDraws.empty())
+		{
+			BeginOcclusionBoxes();
+			UseProgram(depthProgram.id);
+			BindVertexArray(depthVao);
+
+			int queryObjects[MAX_OCCLUSION_QUERY_OBJECTS];
+			size_t i = 0;
+			while (i < occludedDraws.size())
+			{
+				int object = sceneDraws[occludedDraws[i]].object;
+				if (!occlusionCuller.IsQueryDue(object))
+				{
+					++i;
+					continue;
+				}
+
+				size_t end = i + 1;
+				if (occlusionCuller.CanShareQuery(object))
+				{
+					while (end < occludedDraws.size() && end - i < MAX_OCCLUSION_QUERY_OBJECTS
+						&& occlusionCuller.IsQueryDue(sceneDraws[occludedDraws[end]].object)
+						&& occlusionCuller.CanShareQuery(sceneDraws[occludedDraws[end]].object))
+					{
+						++end;
+					}
+				}
+
+				for (size_t j = i; j < end; ++j)
+				{
+					queryObjects[j - i] = sceneDraws[occludedDraws[j]].object;
+				}
+				occlusionCuller.BeginQuery(queryObjects, static_cast<int>(end - i));
+				for (size_t j = i; j < end; ++j)
+				{
+					depthProgram.SetUniform("modelMatrix", CreateBoundingBoxMatrix(sceneBounds[occludedDraws[j]], mesh.subMeshes[cube].bounds));
+					DrawSubMesh(mesh, cube);
+				}
+				occlusionCuller.EndQuery();
+				i = end;
+			}
+
+			EndOcclusionBoxes();
+		}
 
 		// "Unuse" the vertex array object
-		glBindVertexArray(0);
+		BindVertexArray(0);
+
+		// The part of the stream buffer that this frame wrote is fenced, and the next frame writes the next part
+		EndStreamBufferFrame(streamBuffer);
 
-		// Tell GLFW to swap the screen buffer with the offscreen buffer
-		glfwSwapBuffers(window);
+		frameStats.EndFrame();
+		++frameIndex;
 
-		// Tell GLFW to process window events (e.g., input events, window closed events, etc.)
-		glfwPollEvents();
+		if (!options.headless)
+		{
+			// Tell GLFW to swap the screen buffer with the offscreen buffer
+			glfwSwapBuffers(window);
+
+			// Tell GLFW to process window events (e.g., input events, window closed events, etc.)
+			glfwPollEvents();
+		}
+	}
+
+	frameStats.Finish();
+
+	if (options.headless)
+	{
+		frameStats.Report(std::cout);
+
+		if (!options.capturePath.empty())
+		{
+			SaveHeadlessFramebuffer(headlessContext, options.capturePath);
+		}
 	}
 
 	// --- Cleanup ---
 
 	// Make sure to delete the shader program
-	glDeleteProgram(program);
+	glDeleteProgram(program.id);
+
+	// Delete the uniform buffers and the stream buffer
+	DeleteUniformBuffer(materialUniformBuffer);
+	DeleteStreamBuffer(streamBuffer);
 
-	// Delete the VBO that contains our vertices
-	glDeleteBuffers(1, &vbo);
+	// Delete the VBO and EBO that contain our mesh
+	DeleteMesh(mesh);
 
 	// Delete the vertex array object
 	glDeleteVertexArrays(1, &vao);
 
+	// Delete the stress scene objects (deleting 0 does nothing, so this is fine if they were never created)
+	glDeleteProgram(instancedProgram.id);
+	DeleteUniformBuffer(materialArrayUniformBuffer);
+	DeleteInstanceBuffer(stressInstanceBuffer);
+	glDeleteVertexArrays(1, &instancedVao);
+
+	// Delete the animated grid
+	dynamicGrid.Delete();
+	glDeleteVertexArrays(1, &dynamicGridVao);
+	glDeleteVertexArrays(1, &depthDynamicGridVao);
+
+	// Delete the model
+	DeleteMesh(modelMesh);
+	glDeleteVertexArrays(1, &modelVao);
+	glDeleteVertexArrays(1, &depthModelVao);
+
+	// Delete the occlusion queries
+	occlusionCuller.Delete();
+
+	// Delete the depth pre-pass objects
+	glDeleteProgram(depthProgram.id);
+	glDeleteProgram(depthInstancedProgram.id);
+	glDeleteVertexArrays(1, &depthVao);
+	glDeleteVertexArrays(1, &depthInstancedVao);
+
 	// Delete our textures
 	glDeleteTextures(1, &tex0);
 	glDeleteTextures(1, &tex1);
+	glDeleteTextures(1, &tex2);
 
-	// Remember to tell GLFW to clean itself up before exiting the application
-	glfwTerminate();
+	if (options.headless)
+	{
+		DestroyHeadlessContext(headlessContext);
+	}
+	else
+	{
+		// Remember to tell GLFW to clean itself up before exiting the application
+		glfwTerminate();
+	}
 
 	return 0;
 }
@@ -1216,96 +1469,212 @@ void processInput(GLFWwindow* window)
 		cameraPosition += up * cameraSpeed;
 	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
 		cameraPosition -= up * cameraSpeed;
+
+	// Switch to the next depth pre-pass mode once per key press
+	bool pressed = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+	if (pressed && !depthPrepassKeyDown)
+	{
+		int nextMode = (static_cast<int>(depthPrepassMode) + 1) % static_cast<int>(DepthPrepassMode::Count);
+		depthPrepassMode = static_cast<DepthPrepassMode>(nextMode);
+		std::cout << "Depth pre-pass mode: " << GetDepthPrepassModeName(depthPrepassMode) << std::endl;
+	}
+	depthPrepassKeyDown = pressed;
 }
 
-/**
- * @brief Creates a shader program based on the provided file paths for the vertex and fragment shaders.
- * @param[in] vertexShaderFilePath Vertex shader file path
- * @param[in] fragmentShaderFilePath Fragment shader file path
- * @return OpenGL handle to the created shader program
- */
-GLuint CreateShaderProgram(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
+SceneDraw CreateSceneDraw(const glm::mat4& modelMatrix, int material, GLuint texture, int subMesh)
 {
-	GLuint vertexShader = CreateShaderFromFile(GL_VERTEX_SHADER, vertexShaderFilePath);
-	GLuint fragmentShader = CreateShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFilePath);
-
-	GLuint program = glCreateProgram();
-	glAttachShader(program, vertexShader);
-	glAttachShader(program, fragmentShader);
-
-	glLinkProgram(program);
-
-	glDetachShader(program, vertexShader);
-	glDeleteShader(vertexShader);
-	glDetachShader(program, fragmentShader);
-	glDeleteShader(fragmentShader);
-
-	// Check shader program link status
-	GLint linkStatus;
-	glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
-	if (linkStatus != GL_TRUE) {
-		char infoLog[512];
-		GLsizei infoLogLen = sizeof(infoLog);
-		glGetProgramInfoLog(program, infoLogLen, &infoLogLen, infoLog);
-		std::cerr << "program link error: " << infoLog << std::endl;
-	}
+	SceneDraw sceneDraw;
+	sceneDraw.modelMatrix = modelMatrix;
+	sceneDraw.normalMatrix = ComputeNormalMatrix(modelMatrix);
+	sceneDraw.material = material;
+	sceneDraw.texture = texture;
+	sceneDraw.subMesh = subMesh;
+	sceneDraw.program = MAIN_PROGRAM;
+	sceneDraw.object = -1;
+	return sceneDraw;
+}
 
-	return program;
+SceneDraw CreateStressCubeDraw(const InstanceData& stressCube, GLuint texture, int subMesh, int object)
+{
+	SceneDraw sceneDraw;
+	sceneDraw.modelMatrix = stressCube.modelMatrix;
+	sceneDraw.normalMatrix = stressCube.normalMatrix;
+	sceneDraw.material = stressCube.materialIndex;
+	sceneDraw.texture = texture;
+	sceneDraw.subMesh = subMesh;
+	sceneDraw.program = MAIN_PROGRAM;
+	sceneDraw.object = object;
+	return sceneDraw;
+}
+
+glm::mat4 CreateBoundingBoxMatrix(const BoundingBox& box, const BoundingBox& meshBounds)
+{
+	glm::mat4 matrix = glm::translate(glm::mat4(1.0f), box.GetCenter());
+	matrix = glm::scale(matrix, (box.max - box.min) / (meshBounds.max - meshBounds.min));
+	return glm::translate(matrix, -meshBounds.GetCenter());
+}
+
+int PickStressCube(const Bvh& stressBvh, const std::vector<InstanceData>& stressCubes, const std::vector<glm::vec3>& cubeTriangles,
+	const glm::mat4& viewProjectionMatrix, const glm::vec2& screenPoint)
+{
+	// The ray goes from the point on the near plane to the point on the far plane, so the distances along it go from 0 to 1
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjectionMatrix);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(screenPoint, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(screenPoint, 1.0f, 1.0f);
+	glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+	float distance = 1.0f;
+	return stressBvh.Raycast(origin, direction, distance, [&](int stressCubeIndex, float& closestDistance)
+	{
+		// Test the triangles in the local space of the cube (the distances along the ray stay the same)
+		glm::mat4 worldToLocal = glm::inverse(stressCubes[stressCubeIndex].modelMatrix);
+		glm::vec3 localOrigin = glm::vec3(worldToLocal * glm::vec4(origin, 1.0f));
+		glm::vec3 localDirection = glm::vec3(worldToLocal * glm::vec4(direction, 0.0f));
+
+		bool hit = false;
+		for (size_t i = 0; i + 2 < cubeTriangles.size(); i += 3)
+		{
+			glm::vec2 barycentric;
+			float triangleDistance;
+			if (glm::intersectRayTriangle(localOrigin, localDirection, cubeTriangles[i], cubeTriangles[i + 1], cubeTriangles[i + 2],
+				barycentric, triangleDistance) && triangleDistance >= 0.0f && triangleDistance < closestDistance)
+			{
+				closestDistance = triangleDistance;
+				hit = true;
+			}
+		}
+		return hit;
+	});
 }
 
 /**
- * @brief Creates a shader based on the provided shader type and the path to the file containing the shader source.
- * @param[in] shaderType Shader type
- * @param[in] shaderFilePath Path to the file containing the shader source
- * @return OpenGL handle to the created shader
+ * @brief Places cubes on a 3D grid in front of the camera for the stress scene.
+ * @param[in] cubeCount Number of cubes
+ * @param[in] materialCount Number of materials to cycle through
+ * @return Model matrix and material of each cube
  */
-GLuint CreateShaderFromFile(const GLuint& shaderType, const std::string& shaderFilePath)
+std::vector<InstanceData> CreateStressCubes(int cubeCount, int materialCount)
 {
-	std::ifstream shaderFile(shaderFilePath);
-	if (shaderFile.fail())
+	std::vector<InstanceData> cubes;
+	if (cubeCount <= 0)
 	{
-		std::cerr << "Unable to open shader file: " << shaderFilePath << std::endl;
-		return 0;
+		return cubes;
 	}
+	cubes.reserve(cubeCount);
+
+	// The grid fills a 4x4x4 box at the back of the room, and each cube takes up 70% of its grid cell
+	int cubesPerSide = static_cast<int>(std::ceil(std::cbrt(static_cast<double>(cubeCount))));
+	float spacing = 4.0f / cubesPerSide;
+	glm::vec3 gridOrigin(-2.0f, -1.0f, -9.5f);
+	glm::vec3 cubeScale(0.35f * spacing);
 
-	std::string shaderSource;
-	std::string temp;
-	while (std::getline(shaderFile, temp))
+	for (int i = 0; i < cubeCount; ++i)
 	{
-		shaderSource += temp + "\n";
+		int x = i % cubesPerSide;
+		int y = (i / cubesPerSide) % cubesPerSide;
+		int z = i / (cubesPerSide * cubesPerSide);
+		glm::vec3 position = gridOrigin + (glm::vec3(x, y, z) + 0.5f) * spacing;
+
+		InstanceData cube;
+		cube.modelMatrix = glm::scale(glm::translate(glm::mat4(1.0f), position), cubeScale);
+		cube.materialIndex = i % materialCount;
+		cube.normalMatrix = ComputeNormalMatrix(cube.modelMatrix);
+		cubes.push_back(cube);
 	}
-	shaderFile.close();
 
-	return CreateShaderFromSource(shaderType, shaderSource);
+	return cubes;
 }
 
-/**
- * @brief Creates a shader based on the provided shader type and the string containing the shader source.
- * @param[in] shaderType Shader type
- * @param[in] shaderSource Shader source string
- * @return OpenGL handle to the created shader
- */
-GLuint CreateShaderFromSource(const GLuint& shaderType, const std::string& shaderSource)
+int BuildDynamicGrid(MeshBuilder& builder, const VertexLayout& layout, int gridSize)
 {
-	GLuint shader = glCreateShader(shaderType);
+	std::vector<unsigned char> vertex(layout.stride);
+	float halfSize = 0.5f * (gridSize - 1);
+	for (int row = 0; row < gridSize; ++row)
+	{
+		for (int column = 0; column < gridSize; ++column)
+		{
+			glm::vec2 uv(static_cast<float>(column) / (gridSize - 1), static_cast<float>(row) / (gridSize - 1));
+			PackVertexAttribute(layout, 0, glm::vec4(column - halfSize, 0.0f, row - halfSize, 1.0f), vertex.data());
+			PackVertexAttribute(layout, 1, glm::vec4(1.0f), vertex.data());
+			PackVertexAttribute(layout, 2, glm::vec4(uv, 0.0f, 0.0f), vertex.data());
+			PackVertexAttribute(layout, 3, glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), vertex.data());
+			builder.AddVertex(vertex.data());
+		}
+	}
 
-	const char* shaderSourceCStr = shaderSource.c_str();
-	GLint shaderSourceLen = static_cast<GLint>(shaderSource.length());
-	glShaderSource(shader, 1, &shaderSourceCStr, &shaderSourceLen);
-	glCompileShader(shader);
+	// The rows are written by index, so no vertex can have been merged with another one
+	if (builder.GetVertexCount() != static_cast<size_t>(gridSize) * gridSize)
+	{
+		std::cerr << "The animated grid is too large for its vertex format" << std::endl;
+		return -1;
+	}
 
-	// Check compilation status
-	GLint compileStatus;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
-	if (compileStatus == GL_FALSE)
+	std::vector<GLuint> indices;
+	indices.reserve(static_cast<size_t>(gridSize - 1) * (gridSize - 1) * 6);
+	for (int row = 0; row + 1 < gridSize; ++row)
 	{
-		char infoLog[512];
-		GLsizei infoLogLen = sizeof(infoLog);
-		glGetShaderInfoLog(shader, infoLogLen, &infoLogLen, infoLog);
-		std::cerr << "shader compilation error: " << infoLog << std::endl;
+		for (int column = 0; column + 1 < gridSize; ++column)
+		{
+			GLuint corner = row * gridSize + column;
+			indices.insert(indices.end(), { corner, corner + gridSize, corner + 1, corner + 1, corner + gridSize, corner + gridSize + 1 });
+		}
 	}
+	return builder.AddIndexedSubMesh(GL_TRIANGLES, indices.data(), indices.size());
+}
 
-	return shader;
+void AnimateDynamicGrid(DynamicMesh& grid, int gridSize, int firstRow, int rowCount, float time)
+{
+	const VertexLayout& layout = grid.GetLayout();
+	float halfSize = 0.5f * (gridSize - 1);
+	float waveHeight = DYNAMIC_GRID_WAVE_HEIGHT * (gridSize - 1);
+	float twoPi = glm::two_pi<float>();
+
+	for (int i = 0; i < rowCount && i < gridSize; ++i)
+	{
+		int row = (firstRow + i) % gridSize;
+		unsigned char* vertices = grid.EditVertices(static_cast<size_t>(row) * gridSize, gridSize);
+
+		// Two waves across the grid, one along each side: height = waveHeight * sin(a) * cos(b)
+		float v = static_cast<float>(row) / (gridSize - 1);
+		float b = twoPi * (1.5f * v - 0.3f * time);
+		for (int column = 0; column < gridSize; ++column)
+		{
+			float u = static_cast<float>(column) / (gridSize - 1);
+			float a = twoPi * (2.0f * u + 0.5f * time);
+			float height = waveHeight * std::sin(a) * std::cos(b);
+
+			// The slopes along the sides give the normal; positions are in grid cells, so d/du becomes d/dx
+			float slopeX = waveHeight * twoPi * 2.0f * std::cos(a) * std::cos(b) / (gridSize - 1);
+			float slopeZ = -waveHeight * twoPi * 1.5f * std::sin(a) * std::sin(b) / (gridSize - 1);
+			glm::vec3 normal = glm::normalize(glm::vec3(-slopeX, 1.0f, -slopeZ));
+
+			unsigned char* vertex = vertices + column * layout.stride;
+			PackVertexAttribute(layout, 0, glm::vec4(column - halfSize, height, row - halfSize, 1.0f), vertex);
+			PackVertexAttribute(layout, 3, glm::vec4(normal, 0.0f), vertex);
+		}
+	}
+}
+
+/**
+ * @brief Creates the uniform block data of a Phong material that uses the global light intensities.
+ * @param[in] ambientComponent Ambient reflection of the material
+ * @param[in] diffuseComponent Diffuse reflection of the material
+ * @param[in] specularComponent Specular reflection of the material
+ * @param[in] shine Shininess of the material
+ * @return Material data to upload to the material uniform buffer
+ */
+MaterialUniforms CreateMaterial(float ambientComponent, float diffuseComponent, float specularComponent, float shine)
+{
+	MaterialUniforms material = {};
+	material.ambientIntensity = ambientIntensity;
+	material.ambientComponent = ambientComponent;
+	material.diffuseIntensity = diffuseIntensity;
+	material.diffuseComponent = diffuseComponent;
+	material.specularIntensity = specularIntensity;
+	material.specularComponent = specularComponent;
+	material.shine = shine;
+	return material;
 }
 
 /**
@@ -0,0 +1,275 @@
+#include <gdev/Benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+// Counters of the frame currently being rendered
+static unsigned long long frameCounters[static_cast<int>(FrameCounter::Count)];
+// Whether anything added to each counter in the current frame (even 0), i.e. whether the scene uses it
+static bool frameCountersUsed[static_cast<int>(FrameCounter::Count)];
+
+// Names of the counters, in the same order as the FrameCounter enum
+static const char* frameCounterNames[] =
+{
+	"Draw calls",
+	"Instances",
+	"Uniform updates",
+	"Uniform updates skipped",
+	"Uniform buffer updates",
+	"Shaded fragments",
+	"Covered pixels",
+	"Objects culled",
+	"BVH nodes tested",
+	"Occlusion queries",
+	"Objects occluded",
+	"Occlusion query stall time (us)",
+	"Stream buffer bytes written",
+	"Stream buffer stall time (us)",
+	"Dynamic vertex bytes uploaded",
+	"Dynamic vertex uploads",
+	"Dynamic vertex upload time (us)",
+	"State changes",
+	"State changes skipped",
+	"Triangles",
+	"Meshlets culled",
+};
+
+static_assert(sizeof(frameCounterNames) / sizeof(frameCounterNames[0]) == static_cast<int>(FrameCounter::Count),
+	"Every frame counter needs a name");
+
+// Counters that are reported together: if a scene uses one of them, a 0 in the other one means something too
+// (e.g. no uniform updates were skipped, or no object was found hidden)
+static const FrameCounter frameCounterPairs[][2] =
+{
+	{ FrameCounter::UniformUpdates, FrameCounter::UniformUpdatesSkipped },
+	{ FrameCounter::ShadedFragments, FrameCounter::CoveredPixels },
+	{ FrameCounter::OcclusionQueries, FrameCounter::ObjectsOccluded },
+	{ FrameCounter::OcclusionQueries, FrameCounter::OcclusionStallMicroseconds },
+	{ FrameCounter::StreamBufferBytes, FrameCounter::StreamBufferStallMicroseconds },
+	{ FrameCounter::DynamicVertexBytes, FrameCounter::DynamicVertexUploads },
+	{ FrameCounter::DynamicVertexBytes, FrameCounter::DynamicUploadMicroseconds },
+	{ FrameCounter::StateChanges, FrameCounter::StateChangesSkipped },
+};
+
+/**
+ * @brief Returns the value at the given percentile of the samples.
+ * @param[in] samples Samples to look at (copied, since they need to be sorted)
+ * @param[in] percentile Percentile between 0 and 1
+ * @return Value at the percentile, or 0 if there are no samples
+ */
+static double Percentile(std::vector<double> samples, double percentile)
+{
+	if (samples.empty())
+	{
+		return 0.0;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	size_t index = static_cast<size_t>(std::ceil(percentile * samples.size()));
+	index = std::min(std::max(index, static_cast<size_t>(1)), samples.size()) - 1;
+	return samples[index];
+}
+
+void AddFrameCounter(FrameCounter counter, unsigned long long amount)
+{
+	frameCounters[static_cast<int>(counter)] += amount;
+	frameCountersUsed[static_cast<int>(counter)] = true;
+}
+
+/**
+ * @brief Counts the triangles that a draw call makes.
+ * @param[in] mode Primitive type
+ * @param[in] count Number of vertices or indices
+ * @return Number of triangles (0 for points and lines)
+ */
+static unsigned long long CountTriangles(GLenum mode, GLsizei count)
+{
+	if (mode == GL_TRIANGLES)
+	{
+		return count / 3;
+	}
+	if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+	{
+		return count >= 3 ? count - 2 : 0;
+	}
+	return 0;
+}
+
+void DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	glDrawArrays(mode, first, count);
+	AddFrameCounter(FrameCounter::DrawCalls);
+	AddFrameCounter(FrameCounter::Instances);
+	AddFrameCounter(FrameCounter::Triangles, CountTriangles(mode, count));
+}
+
+void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	glDrawElements(mode, count, type, indices);
+	AddFrameCounter(FrameCounter::DrawCalls);
+	AddFrameCounter(FrameCounter::Instances);
+	AddFrameCounter(FrameCounter::Triangles, CountTriangles(mode, count));
+}
+
+void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount)
+{
+	glDrawElementsInstanced(mode, count, type, indices, instanceCount);
+	AddFrameCounter(FrameCounter::DrawCalls);
+	AddFrameCounter(FrameCounter::Instances, instanceCount);
+	AddFrameCounter(FrameCounter::Triangles, CountTriangles(mode, count) * instanceCount);
+}
+
+void MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum type, const void* const* indices, GLsizei drawCount)
+{
+	glMultiDrawElements(mode, counts, type, indices, drawCount);
+	AddFrameCounter(FrameCounter::DrawCalls);
+	AddFrameCounter(FrameCounter::Instances);
+	for (GLsizei i = 0; i < drawCount; ++i)
+	{
+		AddFrameCounter(FrameCounter::Triangles, CountTriangles(mode, counts[i]));
+	}
+}
+
+FrameStats::FrameStats(int warmupFrameCount)
+	: warmupFrameCount(warmupFrameCount)
+	, counterTotals(static_cast<int>(FrameCounter::Count), 0)
+	, countersUsed(static_cast<int>(FrameCounter::Count), false)
+{
+	glGenQueries(QUERY_COUNT, queries);
+	for (int i = 0; i < QUERY_COUNT; ++i)
+	{
+		queryFrame[i] = -1;
+	}
+}
+
+void FrameStats::BeginFrame()
+{
+	std::fill(std::begin(frameCounters), std::end(frameCounters), 0);
+	std::fill(std::begin(frameCountersUsed), std::end(frameCountersUsed), false);
+
+	// Reuse the oldest query; its result is a few frames old by now, so it should already be available
+	int queryIndex = frameIndex % QUERY_COUNT;
+	CollectQuery(queryIndex);
+
+	frameStart = std::chrono::steady_clock::now();
+	if (frameIndex == warmupFrameCount)
+	{
+		measureStart = frameStart;
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, queries[queryIndex]);
+	queryFrame[queryIndex] = frameIndex;
+	queryStart[queryIndex] = frameStart;
+}
+
+void FrameStats::EndFrame()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+
+	if (frameIndex >= warmupFrameCount)
+	{
+		std::chrono::duration<double, std::milli> cpuTime = std::chrono::steady_clock::now() - frameStart;
+		cpuFrameTimes.push_back(cpuTime.count());
+
+		for (int i = 0; i < static_cast<int>(FrameCounter::Count); ++i)
+		{
+			counterTotals[i] += frameCounters[i];
+			countersUsed[i] = countersUsed[i] || frameCountersUsed[i];
+		}
+	}
+
+	++frameIndex;
+}
+
+void FrameStats::Finish()
+{
+	glFinish();
+	measureEnd = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < QUERY_COUNT; ++i)
+	{
+		CollectQuery(i);
+	}
+	glDeleteQueries(QUERY_COUNT, queries);
+}
+
+void FrameStats::CollectQuery(int queryIndex)
+{
+	if (queryFrame[queryIndex] < 0)
+	{
+		return;
+	}
+
+	GLuint64 elapsedNanoseconds = 0;
+	glGetQueryObjectui64v(queries[queryIndex], GL_QUERY_RESULT, &elapsedNanoseconds);
+
+	// The query of the very first frame is never recorded: some drivers (e.g. llvmpipe) return garbage for it
+	// even with no warm-up frames. The GPU work of a frame also has to fit between the start of the frame and now,
+	// so a longer result is broken and would wreck the min/median/p99 of the few frames of a short run.
+	if (queryFrame[queryIndex] >= warmupFrameCount && queryFrame[queryIndex] > 0)
+	{
+		double gpuTime = elapsedNanoseconds / 1.0e6;
+		std::chrono::duration<double, std::milli> wallTime = std::chrono::steady_clock::now() - queryStart[queryIndex];
+		if (gpuTime <= wallTime.count())
+		{
+			gpuFrameTimes.push_back(gpuTime);
+		}
+		else
+		{
+			++rejectedGpuFrameTimes;
+		}
+	}
+	queryFrame[queryIndex] = -1;
+}
+
+void FrameStats::Report(std::ostream& out) const
+{
+	size_t measuredFrames = cpuFrameTimes.size();
+	std::chrono::duration<double> totalTime = measureEnd - measureStart;
+
+	out << std::fixed << std::setprecision(3);
+	out << "Frames measured: " << measuredFrames << " (after " << warmupFrameCount << " warm-up frames)" << std::endl;
+	out << "CPU frame time (ms): min " << Percentile(cpuFrameTimes, 0.0)
+		<< "  median " << Percentile(cpuFrameTimes, 0.5)
+		<< "  p99 " << Percentile(cpuFrameTimes, 0.99) << std::endl;
+	out << "GPU frame time (ms): min " << Percentile(gpuFrameTimes, 0.0)
+		<< "  median " << Percentile(gpuFrameTimes, 0.5)
+		<< "  p99 " << Percentile(gpuFrameTimes, 0.99) << std::endl;
+	if (rejectedGpuFrameTimes > 0)
+	{
+		out << "GPU frame times rejected (longer than the frame): " << rejectedGpuFrameTimes << std::endl;
+	}
+
+	if (measuredFrames > 0 && totalTime.count() > 0.0)
+	{
+		out << "Frames per second: " << measuredFrames / totalTime.count() << std::endl;
+	}
+
+	// Counters that the scene never added to (e.g. the occlusion queries of a scene without occlusion culling)
+	// are left out, rather than reported as 0
+	std::vector<bool> reported = countersUsed;
+	for (const FrameCounter* pair : frameCounterPairs)
+	{
+		bool used = countersUsed[static_cast<int>(pair[0])] || countersUsed[static_cast<int>(pair[1])];
+		reported[static_cast<int>(pair[0])] = used || reported[static_cast<int>(pair[0])];
+		reported[static_cast<int>(pair[1])] = used || reported[static_cast<int>(pair[1])];
+	}
+	for (int i = 0; i < static_cast<int>(FrameCounter::Count); ++i)
+	{
+		if (!reported[i])
+		{
+			continue;
+		}
+		double perFrame = measuredFrames > 0 ? counterTotals[i] / static_cast<double>(measuredFrames) : 0.0;
+		out << frameCounterNames[i] << " per frame: " << perFrame << std::endl;
+	}
+
+	unsigned long long coveredPixels = counterTotals[static_cast<int>(FrameCounter::CoveredPixels)];
+	if (coveredPixels > 0)
+	{
+		unsigned long long shadedFragments = counterTotals[static_cast<int>(FrameCounter::ShadedFragments)];
+		out << "Overdraw (shaded fragments per covered pixel): " << shadedFragments / static_cast<double>(coveredPixels) << std::endl;
+	}
+}
@@ -0,0 +1,145 @@
+#include <gdev/BenchmarkOptions.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+BenchmarkOptions ParseBenchmarkOptions(int argc, char** argv)
+{
+	BenchmarkOptions options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		// Options that take a value read it from the next argument
+		bool hasValue = i + 1 < argc;
+
+		if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			options.headless = true;
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+		{
+			options.frameCount = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue)
+		{
+			options.warmupFrameCount = std::max(0, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--width") == 0 && hasValue)
+		{
+			options.width = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--height") == 0 && hasValue)
+		{
+			options.height = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--capture") == 0 && hasValue)
+		{
+			options.capturePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--stress") == 0 && hasValue)
+		{
+			options.stressCubeCount = std::max(0, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--no-instancing") == 0)
+		{
+			options.instancing = false;
+		}
+		else if (std::strcmp(argv[i], "--texture-threads") == 0 && hasValue)
+		{
+			options.textureThreadCount = std::max(0, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--no-mipmaps") == 0)
+		{
+			options.mipmaps = false;
+		}
+		else if (std::strcmp(argv[i], "--cooked-textures") == 0)
+		{
+			options.cookedTextures = true;
+		}
+		else if (std::strcmp(argv[i], "--depth-prepass") == 0)
+		{
+			options.depthPrepass = DepthPrepassMode::LessEqual;
+		}
+		else if (std::strcmp(argv[i], "--depth-prepass-equal") == 0)
+		{
+			options.depthPrepass = DepthPrepassMode::Equal;
+		}
+		else if (std::strcmp(argv[i], "--overdraw") == 0)
+		{
+			options.overdraw = true;
+		}
+		else if (std::strcmp(argv[i], "--no-culling") == 0)
+		{
+			options.culling = false;
+		}
+		else if (std::strcmp(argv[i], "--flat-culling") == 0)
+		{
+			options.bvhCulling = false;
+		}
+		else if (std::strcmp(argv[i], "--occlusion-culling") == 0)
+		{
+			options.occlusionCulling = true;
+		}
+		else if (std::strcmp(argv[i], "--dynamic-grid") == 0 && hasValue)
+		{
+			options.dynamicGridSize = std::max(0, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--dynamic-upload") == 0 && hasValue)
+		{
+			const char* name = argv[++i];
+			int mode = 0;
+			while (mode < static_cast<int>(DynamicMeshUpload::Count) && std::strcmp(name, GetDynamicMeshUploadName(static_cast<DynamicMeshUpload>(mode))) != 0)
+			{
+				++mode;
+			}
+			if (mode < static_cast<int>(DynamicMeshUpload::Count))
+			{
+				options.dynamicUpload = static_cast<DynamicMeshUpload>(mode);
+			}
+			else
+			{
+				std::cerr << "Unknown upload mode: " << name << std::endl;
+			}
+		}
+		else if (std::strcmp(argv[i], "--dynamic-fraction") == 0 && hasValue)
+		{
+			options.dynamicFraction = std::min(std::max(static_cast<float>(std::atof(argv[++i])), 0.0f), 1.0f);
+		}
+		else if (std::strcmp(argv[i], "--model") == 0 && hasValue)
+		{
+			options.modelPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--no-mesh-optimization") == 0)
+		{
+			options.meshOptimization = false;
+		}
+		else if (std::strcmp(argv[i], "--no-mesh-cache") == 0)
+		{
+			options.meshCache = false;
+		}
+		else if (std::strcmp(argv[i], "--lods") == 0 && hasValue)
+		{
+			options.lodCount = std::min(std::max(std::atoi(argv[++i]), 0), 8);
+		}
+		else if (std::strcmp(argv[i], "--lod-error") == 0 && hasValue)
+		{
+			options.lodPixelError = std::max(static_cast<float>(std::atof(argv[++i])), 0.0f);
+		}
+		else if (std::strcmp(argv[i], "--meshlet-culling") == 0)
+		{
+			options.meshletCulling = true;
+		}
+		else if (std::strcmp(argv[i], "--camera-yaw") == 0 && hasValue)
+		{
+			options.cameraYaw = static_cast<float>(std::atof(argv[++i]));
+		}
+		else
+		{
+			std::cerr << "Ignoring unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	return options;
+}
@@ -0,0 +1,53 @@
+#include <gdev/Bounds.h>
+
+#include <cmath>
+
+void ExpandBoundingBox(BoundingBox& box, const glm::vec3& point)
+{
+	box.min = glm::min(box.min, point);
+	box.max = glm::max(box.max, point);
+}
+
+void ExpandBoundingBox(BoundingBox& box, const BoundingBox& other)
+{
+	box.min = glm::min(box.min, other.min);
+	box.max = glm::max(box.max, other.max);
+}
+
+BoundingBox TransformBoundingBox(const BoundingBox& box, const glm::mat4& matrix)
+{
+	if (box.IsEmpty())
+	{
+		return box;
+	}
+
+	// The center is transformed like a point, and each world axis gets the projection of all three local extents
+	glm::vec3 center = glm::vec3(matrix * glm::vec4(box.GetCenter(), 1.0f));
+	glm::vec3 extents = box.GetExtents();
+	glm::mat3 linear(matrix);
+	glm::vec3 transformedExtents = glm::abs(linear[0]) * extents.x + glm::abs(linear[1]) * extents.y + glm::abs(linear[2]) * extents.z;
+
+	BoundingBox transformed;
+	transformed.min = center - transformedExtents;
+	transformed.max = center + transformedExtents;
+	return transformed;
+}
+
+BoundingSphere ComputeBoundingSphere(const BoundingBox& box, const glm::vec3* points, size_t pointCount)
+{
+	BoundingSphere sphere;
+	if (box.IsEmpty())
+	{
+		return sphere;
+	}
+
+	sphere.center = box.GetCenter();
+	float radiusSquared = 0.0f;
+	for (size_t i = 0; i < pointCount; ++i)
+	{
+		glm::vec3 offset = points[i] - sphere.center;
+		radiusSquared = std::fmax(radiusSquared, glm::dot(offset, offset));
+	}
+	sphere.radius = std::sqrt(radiusSquared);
+	return sphere;
+}
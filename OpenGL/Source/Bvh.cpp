@@ -0,0 +1,516 @@
+#include <gdev/Bvh.h>
+
+#include <gdev/Benchmark.h>
+
+#include <algorithm>
+
+// Leaves hold at most this many objects
+static const int MAX_LEAF_OBJECTS = 4;
+// Number of buckets that the centers are sorted into along each axis when looking for the best split
+static const int SAH_BIN_COUNT = 12;
+// Cost of visiting a node, relative to testing the box of one object
+static const float TRAVERSAL_COST = 1.0f;
+// Below this depth, nodes are split at the median to keep the traversal stacks from overflowing
+static const int MAX_SAH_DEPTH = 32;
+// Size of the traversal stacks (the tree is at most MAX_SAH_DEPTH + log2(object count) levels deep)
+static const int STACK_SIZE = 64;
+
+/**
+ * @brief Computes half of the surface area of a box, which is proportional to the chance that a ray hits it.
+ * @param[in] box Box (must not be empty)
+ * @return Half of the surface area
+ */
+static float GetHalfArea(const BoundingBox& box)
+{
+	glm::vec3 size = box.max - box.min;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+/**
+ * @brief Tests a box against the planes of a frustum that have not been passed yet.
+ * @param[in] frustum Frustum to test against
+ * @param[in] box Box to test
+ * @param[in,out] planeMask One bit per plane left to test; the planes that the box is completely inside are cleared
+ * @return false if the box is outside the frustum
+ */
+static bool TestFrustumPlanes(const Frustum& frustum, const BoundingBox& box, unsigned int& planeMask)
+{
+	glm::vec3 center = box.GetCenter();
+	glm::vec3 extents = box.GetExtents();
+	for (int i = 0; i < 6; ++i)
+	{
+		if ((planeMask & (1u << i)) == 0)
+		{
+			continue;
+		}
+
+		const glm::vec4& plane = frustum.planes[i];
+		glm::vec3 normal(plane);
+		float distance = glm::dot(normal, center) + plane.w;
+		float radius = glm::dot(glm::abs(normal), extents);
+		if (distance + radius < 0.0f)
+		{
+			return false;
+		}
+		if (distance - radius >= 0.0f)
+		{
+			planeMask &= ~(1u << i);
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Intersects a ray with a box (slab test).
+ * @param[in] origin Start of the ray
+ * @param[in] inverseDirection 1 / direction of the ray, per axis
+ * @param[in] box Box to intersect
+ * @param[in] maxDistance Hits further away than this are ignored
+ * @param[out] distance Distance at which the ray enters the box (0 if it starts inside)
+ * @return true if the ray hits the box
+ */
+static bool IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const BoundingBox& box,
+	float maxDistance, float& distance)
+{
+	glm::vec3 t0 = (box.min - origin) * inverseDirection;
+	glm::vec3 t1 = (box.max - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+	float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	distance = enter;
+	return enter <= exit;
+}
+
+void Bvh::Build(const BoundingBox* boxes, size_t boxCount)
+{
+	objectBounds.assign(boxes, boxes + boxCount);
+	objects.resize(boxCount);
+	objectLeaves.assign(boxCount, 0);
+	nodes.clear();
+	if (boxCount == 0)
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> centers(boxCount);
+	for (size_t i = 0; i < boxCount; ++i)
+	{
+		objects[i] = static_cast<int>(i);
+		centers[i] = boxes[i].GetCenter();
+	}
+
+	// A binary tree with at least one object per leaf has fewer than 2 * boxCount nodes
+	nodes.reserve(2 * boxCount);
+	BvhNode root;
+	root.objectCount = static_cast<int>(boxCount);
+	nodes.push_back(root);
+	BuildNode(0, 0, centers);
+}
+
+void Bvh::BuildNode(int nodeIndex, int depth, std::vector<glm::vec3>& centers)
+{
+	int firstObject = nodes[nodeIndex].firstObject;
+	int objectCount = nodes[nodeIndex].objectCount;
+	int* nodeObjects = objects.data() + firstObject;
+
+	BoundingBox bounds;
+	BoundingBox centerBounds;
+	for (int i = 0; i < objectCount; ++i)
+	{
+		ExpandBoundingBox(bounds, objectBounds[nodeObjects[i]]);
+		ExpandBoundingBox(centerBounds, centers[nodeObjects[i]]);
+	}
+	nodes[nodeIndex].bounds = bounds;
+
+	// Binned SAH: sort the centers into buckets along each axis, and try a split between every pair of buckets.
+	// The cost of a split is the number of objects on each side weighted by the area of that side.
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = FLT_MAX;
+	glm::vec3 centerSize = centerBounds.max - centerBounds.min;
+	for (int axis = 0; axis < 3 && objectCount > 1; ++axis)
+	{
+		if (centerSize[axis] <= 0.0f)
+		{
+			continue;
+		}
+
+		BoundingBox binBounds[SAH_BIN_COUNT];
+		int binCounts[SAH_BIN_COUNT] = {};
+		float binScale = SAH_BIN_COUNT / centerSize[axis];
+		for (int i = 0; i < objectCount; ++i)
+		{
+			int bin = std::min(static_cast<int>((centers[nodeObjects[i]][axis] - centerBounds.min[axis]) * binScale), SAH_BIN_COUNT - 1);
+			++binCounts[bin];
+			ExpandBoundingBox(binBounds[bin], objectBounds[nodeObjects[i]]);
+		}
+
+		// Sweep from the right to get the area and count of everything right of each split
+		float rightAreas[SAH_BIN_COUNT];
+		int rightCounts[SAH_BIN_COUNT];
+		BoundingBox right;
+		int rightCount = 0;
+		for (int bin = SAH_BIN_COUNT - 1; bin > 0; --bin)
+		{
+			ExpandBoundingBox(right, binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightAreas[bin] = right.IsEmpty() ? 0.0f : GetHalfArea(right);
+			rightCounts[bin] = rightCount;
+		}
+
+		// ...and from the left to combine it with everything left of it
+		BoundingBox left;
+		int leftCount = 0;
+		for (int split = 1; split < SAH_BIN_COUNT; ++split)
+		{
+			ExpandBoundingBox(left, binBounds[split - 1]);
+			leftCount += binCounts[split - 1];
+			if (leftCount == 0 || rightCounts[split] == 0)
+			{
+				continue;
+			}
+
+			float cost = GetHalfArea(left) * leftCount + rightAreas[split] * rightCounts[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// Keep small nodes as leaves if splitting them would not make queries cheaper
+	float area = GetHalfArea(bounds);
+	bool canSplit = bestAxis >= 0 && area > 0.0f;
+	if (objectCount <= MAX_LEAF_OBJECTS && (!canSplit || TRAVERSAL_COST + bestCost / area >= objectCount))
+	{
+		for (int i = 0; i < objectCount; ++i)
+		{
+			objectLeaves[nodeObjects[i]] = nodeIndex;
+		}
+		return;
+	}
+
+	int leftCount = 0;
+	if (depth >= MAX_SAH_DEPTH)
+	{
+		// Median split along the longest axis, which halves the objects at every level
+		int axis = centerSize.x >= centerSize.y && centerSize.x >= centerSize.z ? 0 : (centerSize.y >= centerSize.z ? 1 : 2);
+		leftCount = objectCount / 2;
+		std::nth_element(nodeObjects, nodeObjects + leftCount, nodeObjects + objectCount, [&](int a, int b)
+		{
+			return centers[a][axis] < centers[b][axis];
+		});
+	}
+	else if (bestAxis >= 0)
+	{
+		float binScale = SAH_BIN_COUNT / centerSize[bestAxis];
+		float splitMin = centerBounds.min[bestAxis];
+		int* middle = std::partition(nodeObjects, nodeObjects + objectCount, [&](int object)
+		{
+			int bin = std::min(static_cast<int>((centers[object][bestAxis] - splitMin) * binScale), SAH_BIN_COUNT - 1);
+			return bin < bestSplit;
+		});
+		leftCount = static_cast<int>(middle - nodeObjects);
+	}
+	if (leftCount == 0 || leftCount == objectCount)
+	{
+		// All centers are in the same place, so any split is as good as another
+		leftCount = objectCount / 2;
+	}
+
+	int leftChild = static_cast<int>(nodes.size());
+	BvhNode child;
+	child.parent = nodeIndex;
+	child.firstObject = firstObject;
+	child.objectCount = leftCount;
+	nodes.push_back(child);
+	child.firstObject = firstObject + leftCount;
+	child.objectCount = objectCount - leftCount;
+	nodes.push_back(child);
+	nodes[nodeIndex].leftChild = leftChild;
+
+	BuildNode(leftChild, depth + 1, centers);
+	BuildNode(leftChild + 1, depth + 1, centers);
+}
+
+void Bvh::RefitNode(int nodeIndex)
+{
+	BvhNode& node = nodes[nodeIndex];
+	if (node.leftChild < 0)
+	{
+		node.bounds = BoundingBox();
+		for (int i = node.firstObject; i < node.firstObject + node.objectCount; ++i)
+		{
+			ExpandBoundingBox(node.bounds, objectBounds[objects[i]]);
+		}
+	}
+	else
+	{
+		node.bounds = nodes[node.leftChild].bounds;
+		ExpandBoundingBox(node.bounds, nodes[node.leftChild + 1].bounds);
+	}
+}
+
+void Bvh::Refit(const BoundingBox* boxes)
+{
+	std::copy(boxes, boxes + objectBounds.size(), objectBounds.begin());
+
+	// Children come after their parents, so going backwards refits the children of a node before the node
+	for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i)
+	{
+		RefitNode(i);
+	}
+}
+
+void Bvh::UpdateObject(int object, const BoundingBox& box)
+{
+	objectBounds[object] = box;
+
+	// Walk up until a node's box stops changing, since nothing above it can change either
+	for (int nodeIndex = objectLeaves[object]; nodeIndex >= 0; nodeIndex = nodes[nodeIndex].parent)
+	{
+		BoundingBox oldBounds = nodes[nodeIndex].bounds;
+		RefitNode(nodeIndex);
+		const BoundingBox& newBounds = nodes[nodeIndex].bounds;
+		if (newBounds.min == oldBounds.min && newBounds.max == oldBounds.max)
+		{
+			break;
+		}
+	}
+}
+
+size_t Bvh::CullFrustum(const Frustum& frustum, std::vector<int>& visibleObjects) const
+{
+	visibleObjects.clear();
+	if (nodes.empty())
+	{
+		return 0;
+	}
+
+	struct StackEntry
+	{
+		int node;
+		unsigned int planeMask;
+	};
+	StackEntry stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = { 0, 0x3fu };
+
+	unsigned long long nodesTested = 0;
+	while (stackSize > 0)
+	{
+		StackEntry entry = stack[--stackSize];
+		const BvhNode& node = nodes[entry.node];
+
+		++nodesTested;
+		unsigned int planeMask = entry.planeMask;
+		if (!TestFrustumPlanes(frustum, node.bounds, planeMask))
+		{
+			continue;
+		}
+
+		// Completely inside: everything below the node is visible
+		if (planeMask == 0)
+		{
+			visibleObjects.insert(visibleObjects.end(), objects.begin() + node.firstObject,
+				objects.begin() + node.firstObject + node.objectCount);
+			continue;
+		}
+
+		if (node.leftChild >= 0)
+		{
+			stack[stackSize++] = { node.leftChild + 1, planeMask };
+			stack[stackSize++] = { node.leftChild, planeMask };
+		}
+		else
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; ++i)
+			{
+				unsigned int objectPlaneMask = planeMask;
+				if (TestFrustumPlanes(frustum, objectBounds[objects[i]], objectPlaneMask))
+				{
+					visibleObjects.push_back(objects[i]);
+				}
+			}
+		}
+	}
+
+	AddFrameCounter(FrameCounter::BvhNodesTested, nodesTested);
+	return visibleObjects.size();
+}
+
+int Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, const BvhRayTest& rayTest) const
+{
+	int hitObject = -1;
+	if (nodes.empty())
+	{
+		return hitObject;
+	}
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+	float nodeDistance;
+	if (!IntersectRayBox(origin, inverseDirection, nodes[0].bounds, distance, nodeDistance))
+	{
+		return hitObject;
+	}
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BvhNode& node = nodes[stack[--stackSize]];
+
+		if (node.leftChild < 0)
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; ++i)
+			{
+				int object = objects[i];
+				float boxDistance;
+				if (!IntersectRayBox(origin, inverseDirection, objectBounds[object], distance, boxDistance))
+				{
+					continue;
+				}
+
+				if (!rayTest)
+				{
+					distance = boxDistance;
+					hitObject = object;
+				}
+				else if (rayTest(object, distance))
+				{
+					hitObject = object;
+				}
+			}
+			continue;
+		}
+
+		// Visit the closer child first, so that its hits can rule out the other one
+		float leftDistance;
+		float rightDistance;
+		bool hitLeft = IntersectRayBox(origin, inverseDirection, nodes[node.leftChild].bounds, distance, leftDistance);
+		bool hitRight = IntersectRayBox(origin, inverseDirection, nodes[node.leftChild + 1].bounds, distance, rightDistance);
+		if (hitLeft && hitRight)
+		{
+			bool leftFirst = leftDistance <= rightDistance;
+			stack[stackSize++] = leftFirst ? node.leftChild + 1 : node.leftChild;
+			stack[stackSize++] = leftFirst ? node.leftChild : node.leftChild + 1;
+		}
+		else if (hitLeft)
+		{
+			stack[stackSize++] = node.leftChild;
+		}
+		else if (hitRight)
+		{
+			stack[stackSize++] = node.leftChild + 1;
+		}
+	}
+
+	return hitObject;
+}
+
+void Bvh::QueryBox(const BoundingBox& box, std::vector<int>& foundObjects) const
+{
+	foundObjects.clear();
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BvhNode& node = nodes[stack[--stackSize]];
+		if (glm::any(glm::lessThan(node.bounds.max, box.min)) || glm::any(glm::greaterThan(node.bounds.min, box.max)))
+		{
+			continue;
+		}
+
+		if (node.leftChild >= 0)
+		{
+			stack[stackSize++] = node.leftChild + 1;
+			stack[stackSize++] = node.leftChild;
+			continue;
+		}
+
+		for (int i = node.firstObject; i < node.firstObject + node.objectCount; ++i)
+		{
+			const BoundingBox& objectBox = objectBounds[objects[i]];
+			if (!glm::any(glm::lessThan(objectBox.max, box.min)) && !glm::any(glm::greaterThan(objectBox.min, box.max)))
+			{
+				foundObjects.push_back(objects[i]);
+			}
+		}
+	}
+}
+
+void Bvh::QuerySphere(const BoundingSphere& sphere, std::vector<int>& foundObjects) const
+{
+	foundObjects.clear();
+	if (nodes.empty() || sphere.radius < 0.0f)
+	{
+		return;
+	}
+
+	// A box overlaps the sphere if the point of the box closest to the center is within the radius
+	float radiusSquared = sphere.radius * sphere.radius;
+	auto overlaps = [&](const BoundingBox& box)
+	{
+		glm::vec3 offset = glm::clamp(sphere.center, box.min, box.max) - sphere.center;
+		return glm::dot(offset, offset) <= radiusSquared;
+	};
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BvhNode& node = nodes[stack[--stackSize]];
+		if (!overlaps(node.bounds))
+		{
+			continue;
+		}
+
+		if (node.leftChild >= 0)
+		{
+			stack[stackSize++] = node.leftChild + 1;
+			stack[stackSize++] = node.leftChild;
+			continue;
+		}
+
+		for (int i = node.firstObject; i < node.firstObject + node.objectCount; ++i)
+		{
+			if (overlaps(objectBounds[objects[i]]))
+			{
+				foundObjects.push_back(objects[i]);
+			}
+		}
+	}
+}
+
+float Bvh::GetCost() const
+{
+	if (nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	float rootArea = GetHalfArea(nodes[0].bounds);
+	if (rootArea <= 0.0f)
+	{
+		return static_cast<float>(objects.size());
+	}
+
+	float cost = 0.0f;
+	for (const BvhNode& node : nodes)
+	{
+		float area = GetHalfArea(node.bounds) / rootArea;
+		cost += node.leftChild >= 0 ? TRAVERSAL_COST * area : node.objectCount * area;
+	}
+	return cost;
+}
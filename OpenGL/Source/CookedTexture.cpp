@@ -0,0 +1,157 @@
+#include <gdev/CookedTexture.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+/**
+ * @brief Returns the number of bytes per pixel of a cooked texture format.
+ * @param[in] format Pixel format
+ * @return Bytes per pixel
+ */
+static size_t GetBytesPerPixel(CookedTextureFormat format)
+{
+	return format == CookedTextureFormat::RGB565 ? 2 : 4;
+}
+
+/**
+ * @brief Rounds a size up to a multiple of an alignment.
+ * @param[in] size Size to round up
+ * @param[in] alignment Alignment (a power of two)
+ * @return The rounded size
+ */
+static size_t AlignSize(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+bool IsCookedTexturePath(const std::string& filePath)
+{
+	size_t extensionLength = sizeof(COOKED_TEXTURE_EXTENSION) - 1;
+	return filePath.size() >= extensionLength
+		&& filePath.compare(filePath.size() - extensionLength, extensionLength, COOKED_TEXTURE_EXTENSION) == 0;
+}
+
+bool WriteCookedTexture(const std::string& filePath, const std::vector<unsigned char>& pixels, const std::vector<MipLevel>& levels,
+	CookedTextureFormat format)
+{
+	CookedTextureHeader header;
+	std::memcpy(header.magic, COOKED_TEXTURE_MAGIC, sizeof(header.magic));
+	header.version = COOKED_TEXTURE_VERSION;
+	header.format = static_cast<uint32_t>(format);
+	header.levelCount = static_cast<uint32_t>(levels.size());
+
+	// Lay out the levels after the header and the level table
+	size_t bytesPerPixel = GetBytesPerPixel(format);
+	std::vector<CookedTextureLevel> cookedLevels(levels.size());
+	size_t offset = sizeof(CookedTextureHeader) + sizeof(CookedTextureLevel) * levels.size();
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		offset = AlignSize(offset, 16);
+		cookedLevels[i].width = static_cast<uint32_t>(levels[i].width);
+		cookedLevels[i].height = static_cast<uint32_t>(levels[i].height);
+		cookedLevels[i].offset = offset;
+		cookedLevels[i].size = AlignSize(levels[i].width * bytesPerPixel, 4) * levels[i].height;
+		offset += static_cast<size_t>(cookedLevels[i].size);
+	}
+
+	std::vector<unsigned char> fileData(offset, 0);
+	std::memcpy(&fileData[0], &header, sizeof(header));
+	std::memcpy(&fileData[sizeof(header)], cookedLevels.data(), sizeof(CookedTextureLevel) * cookedLevels.size());
+
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		const MipLevel& level = levels[i];
+		size_t rowPitch = AlignSize(level.width * bytesPerPixel, 4);
+		for (int y = 0; y < level.height; ++y)
+		{
+			const unsigned char* source = &pixels[level.offset + static_cast<size_t>(y) * level.width * 4];
+			unsigned char* destination = &fileData[static_cast<size_t>(cookedLevels[i].offset) + y * rowPitch];
+			if (format == CookedTextureFormat::RGB565)
+			{
+				// Round each channel to 5/6/5 bits and pack them into a 16-bit value, red in the highest bits
+				for (int x = 0; x < level.width; ++x)
+				{
+					const unsigned char* pixel = source + x * 4;
+					uint16_t r = static_cast<uint16_t>((pixel[0] * 31 + 127) / 255);
+					uint16_t g = static_cast<uint16_t>((pixel[1] * 63 + 127) / 255);
+					uint16_t b = static_cast<uint16_t>((pixel[2] * 31 + 127) / 255);
+					uint16_t packed = static_cast<uint16_t>((r << 11) | (g << 5) | b);
+					std::memcpy(destination + x * 2, &packed, sizeof(packed));
+				}
+			}
+			else
+			{
+				std::memcpy(destination, source, static_cast<size_t>(level.width) * 4);
+			}
+		}
+	}
+
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file.write(reinterpret_cast<const char*>(fileData.data()), fileData.size()))
+	{
+		std::cerr << "Unable to write cooked texture: " << filePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool ReadCookedTexture(const unsigned char* data, size_t size, CookedTextureInfo& info)
+{
+	CookedTextureHeader header;
+	if (data == nullptr || size < sizeof(header))
+	{
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, COOKED_TEXTURE_MAGIC, sizeof(header.magic)) != 0 || header.version != COOKED_TEXTURE_VERSION
+		|| header.format > static_cast<uint32_t>(CookedTextureFormat::RGB565) || header.levelCount == 0
+		|| header.levelCount > (size - sizeof(header)) / sizeof(CookedTextureLevel))
+	{
+		return false;
+	}
+
+	info.format = static_cast<CookedTextureFormat>(header.format);
+	if (info.format == CookedTextureFormat::RGB565)
+	{
+		info.internalFormat = GL_RGB5;	// GL_RGB565 needs OpenGL 4.1; drivers store GL_RGB5 as 5-6-5 or wider
+		info.pixelFormat = GL_RGB;
+		info.pixelType = GL_UNSIGNED_SHORT_5_6_5;
+	}
+	else
+	{
+		info.internalFormat = GL_RGBA8;
+		info.pixelFormat = GL_RGBA;
+		info.pixelType = GL_UNSIGNED_BYTE;
+	}
+
+	// Make sure that every level is inside the file, after the level table and after the level before it,
+	// so that uploading the chain (which copies from the first level to the end of the last) never reads past the end
+	size_t bytesPerPixel = GetBytesPerPixel(info.format);
+	const uint32_t maxSize = static_cast<uint32_t>(std::numeric_limits<GLsizei>::max());
+	uint64_t levelsStart = sizeof(header) + header.levelCount * static_cast<uint64_t>(sizeof(CookedTextureLevel));
+	info.levels.resize(header.levelCount);
+	for (uint32_t i = 0; i < header.levelCount; ++i)
+	{
+		CookedTextureLevel cookedLevel;
+		std::memcpy(&cookedLevel, data + sizeof(header) + i * sizeof(CookedTextureLevel), sizeof(cookedLevel));
+
+		uint64_t expectedSize = AlignSize(cookedLevel.width * bytesPerPixel, 4) * static_cast<uint64_t>(cookedLevel.height);
+		if (cookedLevel.width == 0 || cookedLevel.height == 0 || cookedLevel.width > maxSize || cookedLevel.height > maxSize
+			|| cookedLevel.size != expectedSize || cookedLevel.offset < levelsStart
+			|| cookedLevel.offset > size || cookedLevel.size > size - cookedLevel.offset)
+		{
+			return false;
+		}
+		levelsStart = cookedLevel.offset + cookedLevel.size;
+
+		MipLevel& level = info.levels[i];
+		level.width = static_cast<int>(cookedLevel.width);
+		level.height = static_cast<int>(cookedLevel.height);
+		level.offset = static_cast<size_t>(cookedLevel.offset);
+		level.size = static_cast<size_t>(cookedLevel.size);
+	}
+
+	return true;
+}
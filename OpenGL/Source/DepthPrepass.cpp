@@ -0,0 +1,82 @@
+#include <gdev/DepthPrepass.h>
+
+#include <gdev/Benchmark.h>
+
+#include <vector>
+
+// Whether BeginOverdrawCount() was called since the last EndOverdrawCount()
+static bool overdrawCounting = false;
+
+const char* GetDepthPrepassModeName(DepthPrepassMode mode)
+{
+	switch (mode)
+	{
+	case DepthPrepassMode::LessEqual:
+		return "depth pre-pass, GL_LEQUAL shading";
+	case DepthPrepassMode::Equal:
+		return "depth pre-pass, GL_EQUAL shading";
+	default:
+		return "no depth pre-pass";
+	}
+}
+
+void BeginDepthPrepass()
+{
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
+
+void BeginShadingPass(DepthPrepassMode mode)
+{
+	if (mode == DepthPrepassMode::Off)
+	{
+		return;
+	}
+
+	// The depth buffer already holds the closest surface of every pixel
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(mode == DepthPrepassMode::Equal ? GL_EQUAL : GL_LEQUAL);
+}
+
+void EndShadingPass()
+{
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
+
+void BeginOverdrawCount()
+{
+	glEnable(GL_STENCIL_TEST);
+	glStencilFunc(GL_ALWAYS, 0, 0xFF);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+	overdrawCounting = true;
+}
+
+void EndOverdrawCount(int width, int height)
+{
+	// Nothing was counted (e.g. nothing was shaded this frame), so there is no reason to wait for the GPU
+	if (!overdrawCounting)
+	{
+		return;
+	}
+	overdrawCounting = false;
+
+	glDisable(GL_STENCIL_TEST);
+
+	std::vector<GLubyte> counts(static_cast<size_t>(width) * height);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, counts.data());
+
+	unsigned long long shadedFragments = 0;
+	unsigned long long coveredPixels = 0;
+	for (GLubyte count : counts)
+	{
+		shadedFragments += count;
+		coveredPixels += count != 0 ? 1 : 0;
+	}
+
+	AddFrameCounter(FrameCounter::ShadedFragments, shadedFragments);
+	AddFrameCounter(FrameCounter::CoveredPixels, coveredPixels);
+}
@@ -0,0 +1,264 @@
+#include <gdev/DynamicMesh.h>
+
+#include <gdev/Benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+// Rough cost of one more glBufferSubData() call, in uploaded bytes: gaps smaller than this between
+// dirty ranges are uploaded with them instead of starting another call
+static const size_t UPLOAD_CALL_COST_BYTES = 2048;
+
+// Offsets of vertex streams in a stream buffer are aligned to this (glVertexAttribPointer() needs 4)
+static const GLsizeiptr STREAM_VERTEX_ALIGNMENT = 16;
+
+// Names of the upload modes, in the same order as the DynamicMeshUpload enum
+static const char* dynamicMeshUploadNames[] =
+{
+	"subdata",
+	"orphan",
+	"stream",
+	"auto",
+};
+
+static_assert(sizeof(dynamicMeshUploadNames) / sizeof(dynamicMeshUploadNames[0]) == static_cast<int>(DynamicMeshUpload::Count),
+	"Every upload mode needs a name");
+
+const char* GetDynamicMeshUploadName(DynamicMeshUpload mode)
+{
+	return dynamicMeshUploadNames[static_cast<int>(mode)];
+}
+
+bool DynamicMesh::Create(const MeshBuilder& builder, const VertexLayout& vertexLayout)
+{
+	mesh = CreateMesh(builder, vertexLayout, GL_DYNAMIC_DRAW);
+	if (mesh.indexBuffer == 0)
+	{
+		return false;
+	}
+
+	layout = vertexLayout;
+	vertexData.assign(builder.GetVertexData(), builder.GetVertexData() + builder.GetVertexCount() * builder.GetVertexSize());
+	indices = builder.GetIndices();
+	dirtyRanges.clear();
+	streamBufferId = 0;
+	return true;
+}
+
+void DynamicMesh::MarkDirty(size_t firstVertex, size_t vertexCount)
+{
+	if (vertexCount == 0)
+	{
+		return;
+	}
+
+	// Vertices written one after the other (e.g. row by row) extend the last range instead of adding one
+	if (!dirtyRanges.empty() && dirtyRanges.back().end == firstVertex)
+	{
+		dirtyRanges.back().end += vertexCount;
+	}
+	else
+	{
+		dirtyRanges.push_back({ firstVertex, firstVertex + vertexCount });
+	}
+}
+
+unsigned char* DynamicMesh::EditVertices(size_t firstVertex, size_t vertexCount)
+{
+	MarkDirty(firstVertex, vertexCount);
+	return &vertexData[firstVertex * layout.stride];
+}
+
+void DynamicMesh::WriteVertices(size_t firstVertex, const void* vertices, size_t vertexCount)
+{
+	std::memcpy(EditVertices(firstVertex, vertexCount), vertices, vertexCount * layout.stride);
+}
+
+void DynamicMesh::Upload(DynamicMeshUpload mode, StreamBuffer* streamBuffer)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	UploadDirty(mode, streamBuffer);
+	dirtyRanges.clear();
+	std::chrono::steady_clock::duration uploadTime = std::chrono::steady_clock::now() - start;
+	AddFrameCounter(FrameCounter::DynamicUploadMicroseconds,
+		std::chrono::duration_cast<std::chrono::microseconds>(uploadTime).count());
+}
+
+void DynamicMesh::UploadDirty(DynamicMeshUpload mode, StreamBuffer* streamBuffer)
+{
+	if (mode == DynamicMeshUpload::Stream)
+	{
+		if (streamBuffer != nullptr)
+		{
+			UploadToStreamBuffer(*streamBuffer);
+		}
+		else
+		{
+			std::cerr << "Streaming a dynamic mesh needs a stream buffer" << std::endl;
+		}
+		return;
+	}
+
+	// The buffers of the mesh missed every frame that went to a stream buffer
+	if (streamBufferId != 0)
+	{
+		streamBufferId = 0;
+		mode = DynamicMeshUpload::Orphan;
+	}
+	if (mode == DynamicMeshUpload::Orphan)
+	{
+		UploadAll();
+		return;
+	}
+	if (dirtyRanges.empty())
+	{
+		return;
+	}
+
+	// Sort the ranges, and merge the ones that overlap or are close enough that one call is cheaper than two
+	std::sort(dirtyRanges.begin(), dirtyRanges.end(),
+		[](const VertexRange& a, const VertexRange& b) { return a.first < b.first; });
+	size_t mergeGap = UPLOAD_CALL_COST_BYTES / layout.stride;
+	size_t rangeCount = 1;
+	for (size_t i = 1; i < dirtyRanges.size(); ++i)
+	{
+		VertexRange& last = dirtyRanges[rangeCount - 1];
+		if (dirtyRanges[i].first <= last.end + mergeGap)
+		{
+			last.end = std::max(last.end, dirtyRanges[i].end);
+		}
+		else
+		{
+			dirtyRanges[rangeCount++] = dirtyRanges[i];
+		}
+	}
+	dirtyRanges.resize(rangeCount);
+
+	if (mode == DynamicMeshUpload::Auto)
+	{
+		size_t dirtyVertexCount = 0;
+		for (const VertexRange& range : dirtyRanges)
+		{
+			dirtyVertexCount += range.end - range.first;
+		}
+		size_t rangesCost = dirtyVertexCount * layout.stride + dirtyRanges.size() * UPLOAD_CALL_COST_BYTES;
+		size_t allCost = vertexData.size() + UPLOAD_CALL_COST_BYTES;
+		if (rangesCost >= allCost)
+		{
+			UploadAll();
+			return;
+		}
+	}
+
+	UploadRanges();
+}
+
+void DynamicMesh::UploadRanges()
+{
+	for (int stream = 0; stream < layout.streamCount; ++stream)
+	{
+		size_t streamStride = layout.streamStrides[stream];
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffers[stream]);
+		for (const VertexRange& range : dirtyRanges)
+		{
+			size_t vertexCount = range.end - range.first;
+			const unsigned char* vertices = &vertexData[range.first * layout.stride];
+			if (layout.streamCount > 1)
+			{
+				ExtractVertexStream(layout, vertices, vertexCount, stream, streamData);
+				vertices = streamData.data();
+			}
+
+			glBufferSubData(GL_ARRAY_BUFFER, range.first * streamStride, vertexCount * streamStride, vertices);
+			AddFrameCounter(FrameCounter::DynamicVertexBytes, vertexCount * streamStride);
+			AddFrameCounter(FrameCounter::DynamicVertexUploads);
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DynamicMesh::UploadAll()
+{
+	size_t vertexCount = GetVertexCount();
+	for (int stream = 0; stream < layout.streamCount; ++stream)
+	{
+		size_t streamSize = vertexCount * layout.streamStrides[stream];
+		const unsigned char* vertices = vertexData.data();
+		if (layout.streamCount > 1)
+		{
+			ExtractVertexStream(layout, vertexData.data(), vertexCount, stream, streamData);
+			vertices = streamData.data();
+		}
+
+		// Orphaning: the old storage stays alive for the draws that still read it, and we get new storage
+		// that nothing reads, so writing it does not wait for the GPU
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffers[stream]);
+		glBufferData(GL_ARRAY_BUFFER, streamSize, nullptr, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, streamSize, vertices);
+		AddFrameCounter(FrameCounter::DynamicVertexBytes, streamSize);
+		AddFrameCounter(FrameCounter::DynamicVertexUploads);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DynamicMesh::UploadToStreamBuffer(StreamBuffer& streamBuffer)
+{
+	size_t vertexCount = GetVertexCount();
+	for (int stream = 0; stream < layout.streamCount; ++stream)
+	{
+		size_t streamSize = vertexCount * layout.streamStrides[stream];
+		void* destination = AllocateStreamBuffer(streamBuffer, streamSize, STREAM_VERTEX_ALIGNMENT, streamOffsets[stream]);
+		if (destination == nullptr)
+		{
+			// Keep drawing from the buffers of the mesh
+			streamBufferId = 0;
+			UploadAll();
+			return;
+		}
+
+		// The vertices are split into their streams straight into the mapped memory
+		if (layout.streamCount > 1)
+		{
+			ExtractVertexStream(layout, vertexData.data(), vertexCount, stream, static_cast<unsigned char*>(destination));
+		}
+		else
+		{
+			std::memcpy(destination, vertexData.data(), streamSize);
+		}
+		AddFrameCounter(FrameCounter::DynamicVertexBytes, streamSize);
+		AddFrameCounter(FrameCounter::DynamicVertexUploads);
+	}
+	streamBufferId = streamBuffer.id;
+}
+
+void DynamicMesh::SetVertexArray(GLuint streamMask) const
+{
+	if (streamBufferId != 0)
+	{
+		GLuint streamBuffers[MAX_VERTEX_STREAMS];
+		std::fill(std::begin(streamBuffers), std::end(streamBuffers), streamBufferId);
+		SetVertexLayout(layout, streamBuffers, streamMask, streamOffsets);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	}
+	else
+	{
+		SetMeshVertexArray(mesh, layout, streamMask);
+	}
+}
+
+void DynamicMesh::UpdateBounds()
+{
+	ComputeSubMeshBounds(layout, vertexData.data(), GetVertexCount(), indices.data(), mesh.subMeshes);
+}
+
+void DynamicMesh::Delete()
+{
+	DeleteMesh(mesh);
+	vertexData.clear();
+	indices.clear();
+	dirtyRanges.clear();
+	streamBufferId = 0;
+}
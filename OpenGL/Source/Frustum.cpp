@@ -0,0 +1,114 @@
+#include <gdev/Frustum.h>
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GDEV_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum ExtractFrustum(const glm::mat4& viewProjectionMatrix)
+{
+	// glm matrices are column-major, so the rows of the matrix are gathered from the columns
+	glm::mat4 rows = glm::transpose(viewProjectionMatrix);
+
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0];	// Left
+	frustum.planes[1] = rows[3] - rows[0];	// Right
+	frustum.planes[2] = rows[3] + rows[1];	// Bottom
+	frustum.planes[3] = rows[3] - rows[1];	// Top
+	frustum.planes[4] = rows[3] + rows[2];	// Near
+	frustum.planes[5] = rows[3] - rows[2];	// Far
+
+	for (glm::vec4& plane : frustum.planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return frustum;
+}
+
+bool IsBoxInFrustum(const Frustum& frustum, const BoundingBox& box)
+{
+	glm::vec3 center = box.GetCenter();
+	glm::vec3 extents = box.GetExtents();
+
+	// The box is outside if even its corner that is furthest along the plane normal is behind the plane
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		glm::vec3 normal(plane);
+		if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extents) + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool IsSphereInFrustum(const Frustum& frustum, const BoundingSphere& sphere)
+{
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t CullBoundingBoxes(const Frustum& frustum, const BoundingBox* boxes, size_t boxCount, unsigned char* visible)
+{
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+#if defined(GDEV_FRUSTUM_SSE)
+	// Each register holds one coordinate of four boxes, so each plane is tested against four boxes at once
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= boxCount; i += 4)
+	{
+		const BoundingBox* b = boxes + i;
+		__m128 minX = _mm_set_ps(b[3].min.x, b[2].min.x, b[1].min.x, b[0].min.x);
+		__m128 minY = _mm_set_ps(b[3].min.y, b[2].min.y, b[1].min.y, b[0].min.y);
+		__m128 minZ = _mm_set_ps(b[3].min.z, b[2].min.z, b[1].min.z, b[0].min.z);
+		__m128 maxX = _mm_set_ps(b[3].max.x, b[2].max.x, b[1].max.x, b[0].max.x);
+		__m128 maxY = _mm_set_ps(b[3].max.y, b[2].max.y, b[1].max.y, b[0].max.y);
+		__m128 maxZ = _mm_set_ps(b[3].max.z, b[2].max.z, b[1].max.z, b[0].max.z);
+
+		__m128 centerX = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+		__m128 centerY = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+		__m128 centerZ = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+		__m128 extentX = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+		__m128 extentY = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+		__m128 extentZ = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+		__m128 outside = zero;
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_mul_ps(_mm_set1_ps(plane.y), centerY)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), centerZ), _mm_set1_ps(plane.w)));
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), extentX), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), extentY)),
+				_mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for (int j = 0; j < 4; ++j)
+		{
+			visible[i + j] = (outsideMask & (1 << j)) == 0 ? 1 : 0;
+			visibleCount += visible[i + j];
+		}
+	}
+#endif
+
+	// The boxes that are left over (or all of them without SSE)
+	for (; i < boxCount; ++i)
+	{
+		visible[i] = IsBoxInFrustum(frustum, boxes[i]) ? 1 : 0;
+		visibleCount += visible[i];
+	}
+
+	return visibleCount;
+}
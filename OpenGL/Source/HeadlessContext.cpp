@@ -0,0 +1,155 @@
+#include <gdev/HeadlessContext.h>
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+bool CreateHeadlessContext(HeadlessContext& headlessContext, int width, int height)
+{
+#if defined(__linux__)
+	// Use the surfaceless platform so that we don't need a display server
+	PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT =
+		reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	EGLDisplay display = EGL_NO_DISPLAY;
+	if (eglGetPlatformDisplayEXT != nullptr)
+	{
+		display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint majorVersion, minorVersion;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &majorVersion, &minorVersion))
+	{
+		std::cerr << "Failed to initialize EGL!" << std::endl;
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cerr << "EGL does not support desktop OpenGL!" << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	// Same as the window: OpenGL 3.3, core profile
+	const EGLint contextAttributes[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cerr << "Failed to create EGL context!" << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cerr << "Failed to make the EGL context current!" << std::endl;
+		eglDestroyContext(display, context);
+		eglTerminate(display);
+		return false;
+	}
+
+	headlessContext.display = display;
+	headlessContext.context = context;
+
+	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+	{
+		std::cerr << "Failed to initialize GLAD!" << std::endl;
+		DestroyHeadlessContext(headlessContext);
+		return false;
+	}
+
+	// There is no default framebuffer, so create our own and leave it bound
+	headlessContext.width = width;
+	headlessContext.height = height;
+
+	glGenRenderbuffers(1, &headlessContext.colorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, headlessContext.colorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &headlessContext.depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, headlessContext.depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &headlessContext.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, headlessContext.framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headlessContext.colorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, headlessContext.depthRenderbuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Offscreen framebuffer is incomplete!" << std::endl;
+		DestroyHeadlessContext(headlessContext);
+		return false;
+	}
+
+	return true;
+#else
+	std::cerr << "Headless mode is only supported on Linux (EGL)" << std::endl;
+	return false;
+#endif
+}
+
+void DestroyHeadlessContext(HeadlessContext& headlessContext)
+{
+#if defined(__linux__)
+	if (headlessContext.context == nullptr)
+	{
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &headlessContext.framebuffer);
+	glDeleteRenderbuffers(1, &headlessContext.colorRenderbuffer);
+	glDeleteRenderbuffers(1, &headlessContext.depthRenderbuffer);
+
+	EGLDisplay display = static_cast<EGLDisplay>(headlessContext.display);
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, static_cast<EGLContext>(headlessContext.context));
+	eglTerminate(display);
+
+	headlessContext = HeadlessContext();
+#endif
+}
+
+bool SaveHeadlessFramebuffer(const HeadlessContext& headlessContext, const std::string& filePath)
+{
+	int width = headlessContext.width;
+	int height = headlessContext.height;
+	std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, headlessContext.framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	std::ofstream imageFile(filePath, std::ios::binary);
+	if (imageFile.fail())
+	{
+		std::cerr << "Unable to write image file: " << filePath << std::endl;
+		return false;
+	}
+
+	// OpenGL rows go from bottom to top, PPM rows go from top to bottom
+	imageFile << "P6\n" << width << " " << height << "\n255\n";
+	for (int y = height - 1; y >= 0; --y)
+	{
+		imageFile.write(reinterpret_cast<const char*>(&pixels[static_cast<size_t>(y) * width * 3]), width * 3);
+	}
+
+	return true;
+}
@@ -0,0 +1,70 @@
+#include <gdev/InstanceBuffer.h>
+
+#include <algorithm>
+#include <cstddef>
+
+InstanceBuffer CreateInstanceBuffer(GLsizei capacity, GLenum usage)
+{
+	InstanceBuffer buffer;
+	buffer.capacity = capacity;
+
+	glGenBuffers(1, &buffer.id);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr, usage);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return buffer;
+}
+
+void UpdateInstanceBuffer(InstanceBuffer& buffer, const InstanceData* instances, GLsizei instanceCount)
+{
+	buffer.count = std::min(instanceCount, buffer.capacity);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, buffer.count * sizeof(InstanceData), instances);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SetInstanceAttributes(const InstanceBuffer& buffer)
+{
+	SetInstanceAttributes(buffer.id, 0);
+}
+
+void SetInstanceAttributes(GLuint bufferId, GLintptr offset)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, bufferId);
+
+	// A mat4 attribute is read as 4 vec4 columns in consecutive locations
+	for (GLuint column = 0; column < 4; ++column)
+	{
+		GLuint location = INSTANCE_ATTRIBUTE_LOCATION + column;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			(void*)(offset + offsetof(InstanceData, modelMatrix) + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(location, 1);
+	}
+
+	// The material index stays an integer (glVertexAttribIPointer), so it can index an array in the shader
+	GLuint materialLocation = INSTANCE_ATTRIBUTE_LOCATION + 4;
+	glEnableVertexAttribArray(materialLocation);
+	glVertexAttribIPointer(materialLocation, 1, GL_INT, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, materialIndex)));
+	glVertexAttribDivisor(materialLocation, 1);
+
+	// Same for the mat3 normal matrix, as 3 vec3 columns
+	for (GLuint column = 0; column < 3; ++column)
+	{
+		GLuint location = INSTANCE_ATTRIBUTE_LOCATION + 5 + column;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			(void*)(offset + offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3)));
+		glVertexAttribDivisor(location, 1);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DeleteInstanceBuffer(InstanceBuffer& buffer)
+{
+	glDeleteBuffers(1, &buffer.id);
+	buffer = InstanceBuffer();
+}
@@ -0,0 +1,326 @@
+#include <gdev/Mesh.h>
+
+#include <gdev/Benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const GLuint EMPTY_BUCKET = ~0u;
+
+/**
+ * @brief Hashes the bytes of a vertex (64-bit FNV-1a).
+ * @param[in] data Vertex data
+ * @param[in] size Size of the vertex in bytes
+ * @return Hash of the vertex
+ */
+static size_t HashVertex(const unsigned char* data, size_t size)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+MeshBuilder::MeshBuilder(size_t vertexSize)
+	: vertexSize(vertexSize)
+{
+	buckets.assign(64, EMPTY_BUCKET);
+}
+
+void MeshBuilder::Rehash(size_t bucketCount)
+{
+	buckets.assign(bucketCount, EMPTY_BUCKET);
+
+	size_t mask = bucketCount - 1;
+	GLuint vertexCount = static_cast<GLuint>(GetVertexCount());
+	for (GLuint index = 0; index < vertexCount; ++index)
+	{
+		size_t bucket = HashVertex(&vertexData[index * vertexSize], vertexSize) & mask;
+		while (buckets[bucket] != EMPTY_BUCKET)
+		{
+			bucket = (bucket + 1) & mask;
+		}
+		buckets[bucket] = index;
+	}
+}
+
+GLuint MeshBuilder::AddVertex(const void* vertex)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(vertex);
+	++sourceVertexCount;
+
+	// Linear probing; the table is kept at most half full
+	size_t mask = buckets.size() - 1;
+	size_t bucket = HashVertex(bytes, vertexSize) & mask;
+	while (buckets[bucket] != EMPTY_BUCKET)
+	{
+		GLuint index = buckets[bucket];
+		if (std::memcmp(&vertexData[index * vertexSize], bytes, vertexSize) == 0)
+		{
+			return index;
+		}
+		bucket = (bucket + 1) & mask;
+	}
+
+	GLuint index = static_cast<GLuint>(GetVertexCount());
+	vertexData.insert(vertexData.end(), bytes, bytes + vertexSize);
+	buckets[bucket] = index;
+
+	if ((index + 1) * 2 > buckets.size())
+	{
+		Rehash(buckets.size() * 2);
+	}
+
+	return index;
+}
+
+void MeshBuilder::Reserve(size_t vertexCount)
+{
+	vertexData.reserve(vertexCount * vertexSize);
+
+	// Same load factor as AddVertex(): at most half full
+	size_t bucketCount = buckets.size();
+	while (bucketCount < vertexCount * 2)
+	{
+		bucketCount *= 2;
+	}
+	if (bucketCount != buckets.size())
+	{
+		Rehash(bucketCount);
+	}
+}
+
+int MeshBuilder::AddSubMesh(GLenum mode, const void* vertices, size_t vertexCount)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+	std::vector<GLuint> vertexIndices(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		vertexIndices[i] = AddVertex(bytes + i * vertexSize);
+	}
+
+	if (mode == GL_TRIANGLE_FAN && vertexCount >= 3)
+	{
+		// Fan (v0, v1, v2, v3, ...) -> triangles (v0, v1, v2), (v0, v2, v3), ...
+		std::vector<GLuint> triangles;
+		for (size_t i = 1; i + 1 < vertexCount; ++i)
+		{
+			triangles.push_back(vertexIndices[0]);
+			triangles.push_back(vertexIndices[i]);
+			triangles.push_back(vertexIndices[i + 1]);
+		}
+		return AddIndexedSubMesh(GL_TRIANGLES, triangles.data(), triangles.size());
+	}
+	else if (mode == GL_TRIANGLE_STRIP && vertexCount >= 3)
+	{
+		// Every other triangle of a strip is flipped to keep the same winding order
+		std::vector<GLuint> triangles;
+		for (size_t i = 0; i + 2 < vertexCount; ++i)
+		{
+			bool odd = (i % 2) != 0;
+			triangles.push_back(vertexIndices[odd ? i + 1 : i]);
+			triangles.push_back(vertexIndices[odd ? i : i + 1]);
+			triangles.push_back(vertexIndices[i + 2]);
+		}
+		return AddIndexedSubMesh(GL_TRIANGLES, triangles.data(), triangles.size());
+	}
+
+	return AddIndexedSubMesh(mode, vertexIndices.data(), vertexIndices.size());
+}
+
+int MeshBuilder::AddIndexedSubMesh(GLenum mode, const GLuint* subMeshIndices, size_t indexCount)
+{
+	SubMesh subMesh;
+	subMesh.mode = mode;
+	subMesh.firstIndex = static_cast<GLuint>(indices.size());
+	subMesh.indexCount = static_cast<GLsizei>(indexCount);
+
+	indices.insert(indices.end(), subMeshIndices, subMeshIndices + indexCount);
+
+	subMeshes.push_back(subMesh);
+	return static_cast<int>(subMeshes.size()) - 1;
+}
+
+int MeshBuilder::CombineSubMeshes(int firstSubMesh, int subMeshCount)
+{
+	SubMesh combined = subMeshes[firstSubMesh];
+	for (int i = firstSubMesh + 1; i < firstSubMesh + subMeshCount; ++i)
+	{
+		const SubMesh& subMesh = subMeshes[i];
+		if (subMesh.mode != combined.mode || subMesh.firstIndex != combined.firstIndex + combined.indexCount)
+		{
+			std::cerr << "Only consecutive submeshes with the same primitive type can be combined" << std::endl;
+			break;
+		}
+		combined.indexCount += subMesh.indexCount;
+	}
+
+	subMeshes.push_back(combined);
+	return static_cast<int>(subMeshes.size()) - 1;
+}
+
+void MeshBuilder::ReplaceIndices(size_t firstIndex, const GLuint* newIndices, size_t indexCount)
+{
+	std::copy(newIndices, newIndices + indexCount, indices.begin() + firstIndex);
+}
+
+void MeshBuilder::RemapVertices(const std::vector<GLuint>& newVertexIndices)
+{
+	std::vector<unsigned char> remappedData(vertexData.size());
+	for (size_t i = 0; i < newVertexIndices.size(); ++i)
+	{
+		std::memcpy(&remappedData[newVertexIndices[i] * vertexSize], &vertexData[i * vertexSize], vertexSize);
+	}
+	vertexData.swap(remappedData);
+
+	for (GLuint& index : indices)
+	{
+		index = newVertexIndices[index];
+	}
+
+	// The hash table refers to vertices by index
+	Rehash(buckets.size());
+}
+
+/**
+ * @brief Creates the index buffer of a mesh and fills in everything but the vertex buffers.
+ * @param[in] builder Builder with the mesh data
+ * @param[in] usage Buffer usage hint
+ * @return The mesh without vertex buffers
+ */
+static Mesh CreateMeshIndices(const MeshBuilder& builder, GLenum usage)
+{
+	Mesh mesh;
+	mesh.vertexCount = static_cast<GLsizei>(builder.GetVertexCount());
+	mesh.indexCount = static_cast<GLsizei>(builder.GetIndices().size());
+	mesh.subMeshes = builder.GetSubMeshes();
+
+	// Use 16-bit indices whenever they are enough, which halves the size of the index buffer
+	const std::vector<GLuint>& indices = builder.GetIndices();
+	glGenBuffers(1, &mesh.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	if (builder.GetVertexCount() <= 0x10000)
+	{
+		std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+		mesh.indexType = GL_UNSIGNED_SHORT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(), usage);
+	}
+	else
+	{
+		mesh.indexType = GL_UNSIGNED_INT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), usage);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	return mesh;
+}
+
+Mesh CreateMesh(const MeshBuilder& builder, GLenum usage)
+{
+	Mesh mesh = CreateMeshIndices(builder, usage);
+
+	mesh.vertexStreamCount = 1;
+	glGenBuffers(1, &mesh.vertexBuffers[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, builder.GetVertexCount() * builder.GetVertexSize(), builder.GetVertexData(), usage);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return mesh;
+}
+
+void ComputeSubMeshBounds(const VertexLayout& layout, const unsigned char* vertices, size_t vertexCount, const GLuint* indices,
+	std::vector<SubMesh>& subMeshes)
+{
+	int positionAttribute = FindVertexAttribute(layout, 0);
+	if (positionAttribute < 0)
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> positions(vertexCount);
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = glm::vec3(UnpackVertexAttribute(layout, positionAttribute, vertices + i * layout.stride));
+	}
+
+	std::vector<glm::vec3> subMeshPositions;
+	for (SubMesh& subMesh : subMeshes)
+	{
+		subMesh.bounds = BoundingBox();
+		subMeshPositions.clear();
+		for (GLsizei i = 0; i < subMesh.indexCount; ++i)
+		{
+			const glm::vec3& position = positions[indices[subMesh.firstIndex + i]];
+			ExpandBoundingBox(subMesh.bounds, position);
+			subMeshPositions.push_back(position);
+		}
+		subMesh.sphere = ComputeBoundingSphere(subMesh.bounds, subMeshPositions.data(), subMeshPositions.size());
+	}
+}
+
+Mesh CreateMesh(const MeshBuilder& builder, const VertexLayout& layout, GLenum usage)
+{
+	if (builder.GetVertexSize() != static_cast<size_t>(layout.stride))
+	{
+		std::cerr << "The vertex size of the mesh does not match its vertex layout" << std::endl;
+		return Mesh();
+	}
+
+	// A layout with a single stream is uploaded as is
+	if (layout.streamCount == 1)
+	{
+		Mesh mesh = CreateMesh(builder, usage);
+		ComputeSubMeshBounds(layout, builder.GetVertexData(), builder.GetVertexCount(), builder.GetIndices().data(), mesh.subMeshes);
+		return mesh;
+	}
+
+	Mesh mesh = CreateMeshIndices(builder, usage);
+	ComputeSubMeshBounds(layout, builder.GetVertexData(), builder.GetVertexCount(), builder.GetIndices().data(), mesh.subMeshes);
+
+	mesh.vertexStreamCount = layout.streamCount;
+	glGenBuffers(layout.streamCount, mesh.vertexBuffers);
+	std::vector<unsigned char> streamData;
+	for (int stream = 0; stream < layout.streamCount; ++stream)
+	{
+		ExtractVertexStream(layout, builder.GetVertexData(), builder.GetVertexCount(), stream, streamData);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffers[stream]);
+		glBufferData(GL_ARRAY_BUFFER, streamData.size(), streamData.data(), usage);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return mesh;
+}
+
+void SetMeshVertexArray(const Mesh& mesh, const VertexLayout& layout, GLuint streamMask)
+{
+	SetVertexLayout(layout, mesh.vertexBuffers, streamMask);
+
+	// The index buffer binding is part of the vertex array object's state
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+}
+
+void DrawSubMesh(const Mesh& mesh, int subMeshIndex)
+{
+	const SubMesh& subMesh = mesh.subMeshes[subMeshIndex];
+	size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	DrawElements(subMesh.mode, subMesh.indexCount, mesh.indexType, reinterpret_cast<const void*>(subMesh.firstIndex * indexSize));
+}
+
+void DrawSubMeshInstanced(const Mesh& mesh, int subMeshIndex, GLsizei instanceCount)
+{
+	const SubMesh& subMesh = mesh.subMeshes[subMeshIndex];
+	size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	DrawElementsInstanced(subMesh.mode, subMesh.indexCount, mesh.indexType,
+		reinterpret_cast<const void*>(subMesh.firstIndex * indexSize), instanceCount);
+}
+
+void DeleteMesh(Mesh& mesh)
+{
+	glDeleteBuffers(mesh.vertexStreamCount, mesh.vertexBuffers);
+	glDeleteBuffers(1, &mesh.indexBuffer);
+	mesh = Mesh();
+}
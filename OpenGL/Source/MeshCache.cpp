@@ -0,0 +1,430 @@
+#include <gdev/MeshCache.h>
+
+#include <gdev/MappedFile.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+/**
+ * @brief Rounds a size up to a multiple of an alignment.
+ * @param[in] size Size to round up
+ * @param[in] alignment Alignment (a power of two)
+ * @return The rounded size
+ */
+static size_t AlignSize(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Checks whether a blob of a mesh cache is inside the file.
+ * @param[in] offset Byte offset of the blob
+ * @param[in] size Size of the blob in bytes
+ * @param[in] fileSize Size of the file
+ * @return true if the blob is inside the file
+ */
+static bool IsBlobInFile(uint64_t offset, uint64_t size, size_t fileSize)
+{
+	return offset <= fileSize && size <= fileSize - offset;
+}
+
+/**
+ * @brief Checks whether two vertex layouts store the same attributes in the same places.
+ * @param[in] a First layout
+ * @param[in] b Second layout
+ * @return true if the layouts are the same
+ */
+static bool IsSameLayout(const VertexLayout& a, const VertexLayout& b)
+{
+	if (a.attributes.size() != b.attributes.size() || a.stride != b.stride || a.streamCount != b.streamCount)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.attributes.size(); ++i)
+	{
+		const VertexAttribute& attributeA = a.attributes[i];
+		const VertexAttribute& attributeB = b.attributes[i];
+		if (attributeA.location != attributeB.location || attributeA.format != attributeB.format
+			|| attributeA.offset != attributeB.offset || attributeA.stream != attributeB.stream
+			|| attributeA.streamOffset != attributeB.streamOffset)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool HashMeshSource(const std::string& filePath, uint64_t& hash)
+{
+	MappedFile file;
+	if (!OpenMappedFile(file, filePath))
+	{
+		return false;
+	}
+
+	// FNV-1a over 64-bit words instead of bytes, in four lanes so that the multiplications do not wait for each other
+	const uint64_t prime = 1099511628211ull;
+	uint64_t lanes[4] = { 14695981039346656037ull, 14695981039346656037ull ^ 1, 14695981039346656037ull ^ 2, 14695981039346656037ull ^ 3 };
+	size_t blockCount = file.size / 32;
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		uint64_t words[4];
+		std::memcpy(words, file.data + block * 32, sizeof(words));
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			lanes[lane] = (lanes[lane] ^ words[lane]) * prime;
+		}
+	}
+
+	uint64_t result = 14695981039346656037ull;
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		result = (result ^ lanes[lane]) * prime;
+	}
+	for (size_t i = blockCount * 32; i < file.size; ++i)
+	{
+		result = (result ^ file.data[i]) * prime;
+	}
+	hash = (result ^ static_cast<uint64_t>(file.size)) * prime;
+
+	CloseMappedFile(file);
+	return true;
+}
+
+std::string GetMeshCachePath(const std::string& sourcePath)
+{
+	return sourcePath + MESH_CACHE_EXTENSION;
+}
+
+bool WriteMeshCache(const std::string& filePath, uint64_t sourceHash, uint32_t flags, const MeshBuilder& builder,
+	const VertexLayout& layout, const std::vector<SubMesh>& subMeshes, const std::vector<MeshLod>& lods,
+	const std::vector<Meshlet>& meshlets)
+{
+	if (builder.GetVertexSize() != static_cast<size_t>(layout.stride))
+	{
+		std::cerr << "The vertex size of the mesh does not match its vertex layout" << std::endl;
+		return false;
+	}
+
+	size_t vertexCount = builder.GetVertexCount();
+	const std::vector<GLuint>& indices = builder.GetIndices();
+
+	MeshCacheHeader header;
+	std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.flags = flags;
+	header.attributeCount = static_cast<uint32_t>(layout.attributes.size());
+	header.streamCount = static_cast<uint32_t>(layout.streamCount);
+	header.subMeshCount = static_cast<uint32_t>(subMeshes.size());
+	header.vertexCount = static_cast<uint32_t>(vertexCount);
+	header.indexCount = static_cast<uint32_t>(indices.size());
+	header.indexType = vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	header.stride = static_cast<uint32_t>(layout.stride);
+	header.lodCount = static_cast<uint32_t>(lods.size());
+	header.meshletCount = static_cast<uint32_t>(meshlets.size());
+
+	BoundingBox bounds;
+	for (const SubMesh& subMesh : subMeshes)
+	{
+		ExpandBoundingBox(bounds, subMesh.bounds);
+	}
+	std::memcpy(header.boundsMin, &bounds.min, sizeof(header.boundsMin));
+	std::memcpy(header.boundsMax, &bounds.max, sizeof(header.boundsMax));
+
+	std::vector<MeshCacheAttribute> cacheAttributes(layout.attributes.size());
+	for (size_t i = 0; i < layout.attributes.size(); ++i)
+	{
+		const VertexAttribute& attribute = layout.attributes[i];
+		cacheAttributes[i].location = attribute.location;
+		cacheAttributes[i].format = static_cast<uint32_t>(attribute.format);
+		cacheAttributes[i].offset = attribute.offset;
+		cacheAttributes[i].stream = attribute.stream;
+		cacheAttributes[i].streamOffset = attribute.streamOffset;
+	}
+
+	std::vector<MeshCacheSubMesh> cacheSubMeshes(subMeshes.size());
+	for (size_t i = 0; i < subMeshes.size(); ++i)
+	{
+		const SubMesh& subMesh = subMeshes[i];
+		cacheSubMeshes[i].mode = subMesh.mode;
+		cacheSubMeshes[i].firstIndex = subMesh.firstIndex;
+		cacheSubMeshes[i].indexCount = static_cast<uint32_t>(subMesh.indexCount);
+		std::memcpy(cacheSubMeshes[i].boundsMin, &subMesh.bounds.min, sizeof(cacheSubMeshes[i].boundsMin));
+		std::memcpy(cacheSubMeshes[i].boundsMax, &subMesh.bounds.max, sizeof(cacheSubMeshes[i].boundsMax));
+		std::memcpy(cacheSubMeshes[i].sphereCenter, &subMesh.sphere.center, sizeof(cacheSubMeshes[i].sphereCenter));
+		cacheSubMeshes[i].sphereRadius = subMesh.sphere.radius;
+	}
+
+	std::vector<MeshCacheLod> cacheLods(lods.size());
+	for (size_t i = 0; i < lods.size(); ++i)
+	{
+		cacheLods[i].subMesh = static_cast<uint32_t>(lods[i].subMesh);
+		cacheLods[i].error = lods[i].error;
+		cacheLods[i].firstMeshlet = static_cast<uint32_t>(lods[i].firstMeshlet);
+		cacheLods[i].meshletCount = static_cast<uint32_t>(lods[i].meshletCount);
+	}
+
+	std::vector<MeshCacheMeshlet> cacheMeshlets(meshlets.size());
+	for (size_t i = 0; i < meshlets.size(); ++i)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		cacheMeshlets[i].firstIndex = meshlet.firstIndex;
+		cacheMeshlets[i].indexCount = static_cast<uint32_t>(meshlet.indexCount);
+		std::memcpy(cacheMeshlets[i].sphereCenter, &meshlet.sphere.center, sizeof(cacheMeshlets[i].sphereCenter));
+		cacheMeshlets[i].sphereRadius = meshlet.sphere.radius;
+		std::memcpy(cacheMeshlets[i].coneApex, &meshlet.coneApex, sizeof(cacheMeshlets[i].coneApex));
+		std::memcpy(cacheMeshlets[i].coneAxis, &meshlet.coneAxis, sizeof(cacheMeshlets[i].coneAxis));
+		cacheMeshlets[i].coneCutoff = meshlet.coneCutoff;
+	}
+
+	// Lay out the blobs after the header and the tables
+	size_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	size_t offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheAttribute) * cacheAttributes.size()
+		+ sizeof(MeshCacheStream) * layout.streamCount + sizeof(MeshCacheSubMesh) * cacheSubMeshes.size()
+		+ sizeof(MeshCacheLod) * cacheLods.size() + sizeof(MeshCacheMeshlet) * cacheMeshlets.size();
+	offset = AlignSize(offset, 16);
+	header.indexOffset = offset;
+	header.indexSize = indices.size() * indexSize;
+	offset += static_cast<size_t>(header.indexSize);
+
+	std::vector<MeshCacheStream> cacheStreams(layout.streamCount);
+	for (int stream = 0; stream < layout.streamCount; ++stream)
+	{
+		offset = AlignSize(offset, 16);
+		cacheStreams[stream].stride = static_cast<uint32_t>(layout.streamStrides[stream]);
+		cacheStreams[stream].unused = 0;
+		cacheStreams[stream].offset = offset;
+		cacheStreams[stream].size = vertexCount * layout.streamStrides[stream];
+		offset += static_cast<size_t>(cacheStreams[stream].size);
+	}
+
+	std::vector<unsigned char> fileData(offset, 0);
+	unsigned char* tables = &fileData[0];
+	std::memcpy(tables, &header, sizeof(header));
+	tables += sizeof(header);
+	std::memcpy(tables, cacheAttributes.data(), sizeof(MeshCacheAttribute) * cacheAttributes.size());
+	tables += sizeof(MeshCacheAttribute) * cacheAttributes.size();
+	std::memcpy(tables, cacheStreams.data(), sizeof(MeshCacheStream) * cacheStreams.size());
+	tables += sizeof(MeshCacheStream) * cacheStreams.size();
+	std::memcpy(tables, cacheSubMeshes.data(), sizeof(MeshCacheSubMesh) * cacheSubMeshes.size());
+	tables += sizeof(MeshCacheSubMesh) * cacheSubMeshes.size();
+	std::memcpy(tables, cacheLods.data(), sizeof(MeshCacheLod) * cacheLods.size());
+	tables += sizeof(MeshCacheLod) * cacheLods.size();
+	std::memcpy(tables, cacheMeshlets.data(), sizeof(MeshCacheMeshlet) * cacheMeshlets.size());
+
+	unsigned char* indexData = &fileData[static_cast<size_t>(header.indexOffset)];
+	if (header.indexType == GL_UNSIGNED_SHORT)
+	{
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			GLushort index = static_cast<GLushort>(indices[i]);
+			std::memcpy(indexData + i * sizeof(GLushort), &index, sizeof(index));
+		}
+	}
+	else if (!indices.empty())
+	{
+		std::memcpy(indexData, indices.data(), static_cast<size_t>(header.indexSize));
+	}
+
+	for (int stream = 0; stream < layout.streamCount; ++stream)
+	{
+		ExtractVertexStream(layout, builder.GetVertexData(), vertexCount, stream, &fileData[static_cast<size_t>(cacheStreams[stream].offset)]);
+	}
+
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file.write(reinterpret_cast<const char*>(fileData.data()), fileData.size()))
+	{
+		std::cerr << "Unable to write mesh cache: " << filePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool ReadMeshCache(const unsigned char* data, size_t size, MeshCacheInfo& info)
+{
+	MeshCacheHeader header;
+	if (data == nullptr || size < sizeof(header))
+	{
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION
+		|| header.streamCount == 0 || header.streamCount > static_cast<uint32_t>(MAX_VERTEX_STREAMS)
+		|| (header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT))
+	{
+		return false;
+	}
+	uint64_t tableSize = sizeof(MeshCacheAttribute) * static_cast<uint64_t>(header.attributeCount)
+		+ sizeof(MeshCacheStream) * static_cast<uint64_t>(header.streamCount)
+		+ sizeof(MeshCacheSubMesh) * static_cast<uint64_t>(header.subMeshCount)
+		+ sizeof(MeshCacheLod) * static_cast<uint64_t>(header.lodCount)
+		+ sizeof(MeshCacheMeshlet) * static_cast<uint64_t>(header.meshletCount);
+	if (!IsBlobInFile(sizeof(header), tableSize, size))
+	{
+		return false;
+	}
+
+	info.sourceHash = header.sourceHash;
+	info.flags = header.flags;
+	info.indexType = header.indexType;
+	info.vertexCount = header.vertexCount;
+	info.indexCount = header.indexCount;
+	std::memcpy(&info.bounds.min, header.boundsMin, sizeof(header.boundsMin));
+	std::memcpy(&info.bounds.max, header.boundsMax, sizeof(header.boundsMax));
+
+	// Rebuild the layout from the attributes, and make sure that it puts them where the file says they are
+	const unsigned char* table = data + sizeof(header);
+	info.layout = VertexLayout();
+	for (uint32_t i = 0; i < header.attributeCount; ++i)
+	{
+		MeshCacheAttribute cacheAttribute;
+		std::memcpy(&cacheAttribute, table, sizeof(cacheAttribute));
+		table += sizeof(cacheAttribute);
+		if (cacheAttribute.format > static_cast<uint32_t>(VertexAttributeFormat::Snorm10x3)
+			|| AddVertexAttribute(info.layout, cacheAttribute.location, static_cast<VertexAttributeFormat>(cacheAttribute.format), cacheAttribute.stream) < 0)
+		{
+			return false;
+		}
+		const VertexAttribute& attribute = info.layout.attributes.back();
+		if (attribute.offset != cacheAttribute.offset || attribute.streamOffset != cacheAttribute.streamOffset)
+		{
+			return false;
+		}
+	}
+	if (info.layout.stride != static_cast<GLsizei>(header.stride) || info.layout.streamCount != static_cast<int>(header.streamCount))
+	{
+		return false;
+	}
+
+	// Make sure that every blob is inside the file and has the size that the counts give it,
+	// so that uploading it never reads past the end
+	for (uint32_t stream = 0; stream < header.streamCount; ++stream)
+	{
+		MeshCacheStream cacheStream;
+		std::memcpy(&cacheStream, table, sizeof(cacheStream));
+		table += sizeof(cacheStream);
+		if (cacheStream.stride != static_cast<uint32_t>(info.layout.streamStrides[stream])
+			|| cacheStream.size != static_cast<uint64_t>(cacheStream.stride) * header.vertexCount
+			|| !IsBlobInFile(cacheStream.offset, cacheStream.size, size))
+		{
+			return false;
+		}
+		info.streamOffsets[stream] = static_cast<size_t>(cacheStream.offset);
+		info.streamSizes[stream] = static_cast<size_t>(cacheStream.size);
+	}
+
+	size_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	if (header.indexSize != static_cast<uint64_t>(indexSize) * header.indexCount || !IsBlobInFile(header.indexOffset, header.indexSize, size))
+	{
+		return false;
+	}
+	info.indexOffset = static_cast<size_t>(header.indexOffset);
+	info.indexSize = static_cast<size_t>(header.indexSize);
+
+	info.subMeshes.resize(header.subMeshCount);
+	for (uint32_t i = 0; i < header.subMeshCount; ++i)
+	{
+		MeshCacheSubMesh cacheSubMesh;
+		std::memcpy(&cacheSubMesh, table, sizeof(cacheSubMesh));
+		table += sizeof(cacheSubMesh);
+		if (static_cast<uint64_t>(cacheSubMesh.firstIndex) + cacheSubMesh.indexCount > header.indexCount)
+		{
+			return false;
+		}
+
+		SubMesh& subMesh = info.subMeshes[i];
+		subMesh.mode = cacheSubMesh.mode;
+		subMesh.firstIndex = cacheSubMesh.firstIndex;
+		subMesh.indexCount = static_cast<GLsizei>(cacheSubMesh.indexCount);
+		std::memcpy(&subMesh.bounds.min, cacheSubMesh.boundsMin, sizeof(cacheSubMesh.boundsMin));
+		std::memcpy(&subMesh.bounds.max, cacheSubMesh.boundsMax, sizeof(cacheSubMesh.boundsMax));
+		std::memcpy(&subMesh.sphere.center, cacheSubMesh.sphereCenter, sizeof(cacheSubMesh.sphereCenter));
+		subMesh.sphere.radius = cacheSubMesh.sphereRadius;
+	}
+
+	info.lods.resize(header.lodCount);
+	for (uint32_t i = 0; i < header.lodCount; ++i)
+	{
+		MeshCacheLod cacheLod;
+		std::memcpy(&cacheLod, table, sizeof(cacheLod));
+		table += sizeof(cacheLod);
+		if (cacheLod.subMesh >= header.subMeshCount
+			|| static_cast<uint64_t>(cacheLod.firstMeshlet) + cacheLod.meshletCount > header.meshletCount)
+		{
+			return false;
+		}
+		info.lods[i].subMesh = static_cast<int>(cacheLod.subMesh);
+		info.lods[i].error = cacheLod.error;
+		info.lods[i].firstMeshlet = static_cast<int>(cacheLod.firstMeshlet);
+		info.lods[i].meshletCount = static_cast<int>(cacheLod.meshletCount);
+	}
+
+	info.meshlets.resize(header.meshletCount);
+	for (uint32_t i = 0; i < header.meshletCount; ++i)
+	{
+		MeshCacheMeshlet cacheMeshlet;
+		std::memcpy(&cacheMeshlet, table, sizeof(cacheMeshlet));
+		table += sizeof(cacheMeshlet);
+		if (static_cast<uint64_t>(cacheMeshlet.firstIndex) + cacheMeshlet.indexCount > header.indexCount)
+		{
+			return false;
+		}
+
+		Meshlet& meshlet = info.meshlets[i];
+		meshlet.firstIndex = cacheMeshlet.firstIndex;
+		meshlet.indexCount = static_cast<GLsizei>(cacheMeshlet.indexCount);
+		std::memcpy(&meshlet.sphere.center, cacheMeshlet.sphereCenter, sizeof(cacheMeshlet.sphereCenter));
+		meshlet.sphere.radius = cacheMeshlet.sphereRadius;
+		std::memcpy(&meshlet.coneApex, cacheMeshlet.coneApex, sizeof(cacheMeshlet.coneApex));
+		std::memcpy(&meshlet.coneAxis, cacheMeshlet.coneAxis, sizeof(cacheMeshlet.coneAxis));
+		meshlet.coneCutoff = cacheMeshlet.coneCutoff;
+	}
+
+	return true;
+}
+
+bool LoadMeshCache(const std::string& filePath, uint64_t sourceHash, uint32_t flags, const VertexLayout& layout, GLenum usage,
+	Mesh& mesh, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets)
+{
+	MappedFile file;
+	if (!OpenMappedFile(file, filePath))
+	{
+		return false;
+	}
+
+	MeshCacheInfo info;
+	if (!ReadMeshCache(file.data, file.size, info) || info.sourceHash != sourceHash || info.flags != flags
+		|| !IsSameLayout(info.layout, layout))
+	{
+		CloseMappedFile(file);
+		return false;
+	}
+
+	mesh = Mesh();
+	mesh.vertexCount = static_cast<GLsizei>(info.vertexCount);
+	mesh.indexCount = static_cast<GLsizei>(info.indexCount);
+	mesh.indexType = info.indexType;
+	mesh.subMeshes = info.subMeshes;
+	lods = info.lods;
+	meshlets = info.meshlets;
+
+	// The blobs are already in the format of the buffers, so they are uploaded straight from the mapping
+	glGenBuffers(1, &mesh.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, info.indexSize, file.data + info.indexOffset, usage);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	mesh.vertexStreamCount = info.layout.streamCount;
+	glGenBuffers(mesh.vertexStreamCount, mesh.vertexBuffers);
+	for (int stream = 0; stream < mesh.vertexStreamCount; ++stream)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffers[stream]);
+		glBufferData(GL_ARRAY_BUFFER, info.streamSizes[stream], file.data + info.streamOffsets[stream], usage);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	CloseMappedFile(file);
+	return true;
+}
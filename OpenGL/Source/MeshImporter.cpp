@@ -0,0 +1,1150 @@
+#include <gdev/MeshImporter.h>
+
+#include <gdev/MappedFile.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static const GLuint MISSING_INDEX = ~0u;
+
+/**
+ * Struct containing the vertices of one part of a file (an OBJ group or a glTF primitive) before they are packed
+ */
+struct ImportedPrimitive
+{
+	std::string name;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;		// Empty if the file has none
+	std::vector<glm::vec2> uvs;			// Empty if the file has none
+	std::vector<glm::vec4> colors;		// Empty if the file has none
+	std::vector<glm::vec4> tangents;	// Empty if the file has none
+	std::vector<GLuint> positionIds;	// Vertices with the same id share their generated normal (empty = not shared)
+	std::vector<GLuint> indices;		// Triangle list
+};
+
+// --- Generating the missing attributes ---
+
+/**
+ * @brief Computes smooth normals, with each triangle weighted by its area.
+ * Vertices with the same position id (e.g. OBJ vertices with the same position but different UV-coordinates)
+ * get the same normal.
+ * @param[in,out] primitive Primitive to compute the normals of
+ */
+static void GenerateNormals(ImportedPrimitive& primitive)
+{
+	size_t vertexCount = primitive.positions.size();
+	std::vector<GLuint> ids = primitive.positionIds;
+	if (ids.empty())
+	{
+		ids.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			ids[i] = static_cast<GLuint>(i);
+		}
+	}
+
+	// Compact the ids to 0..n-1, so that the sums fit in an array as large as the primitive
+	GLuint maxId = vertexCount > 0 ? *std::max_element(ids.begin(), ids.end()) : 0;
+	std::vector<GLuint> idSlots(static_cast<size_t>(maxId) + 1, MISSING_INDEX);
+	std::vector<GLuint> slots(vertexCount);
+	GLuint slotCount = 0;
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		if (idSlots[ids[i]] == MISSING_INDEX)
+		{
+			idSlots[ids[i]] = slotCount++;
+		}
+		slots[i] = idSlots[ids[i]];
+	}
+
+	// The cross product is twice the area of the triangle, so adding it weighs the triangle by its area
+	std::vector<glm::vec3> sums(slotCount, glm::vec3(0.0f));
+	for (size_t i = 0; i + 2 < primitive.indices.size(); i += 3)
+	{
+		GLuint a = primitive.indices[i], b = primitive.indices[i + 1], c = primitive.indices[i + 2];
+		glm::vec3 faceNormal = glm::cross(primitive.positions[b] - primitive.positions[a], primitive.positions[c] - primitive.positions[a]);
+		sums[slots[a]] += faceNormal;
+		sums[slots[b]] += faceNormal;
+		sums[slots[c]] += faceNormal;
+	}
+
+	primitive.normals.resize(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		float length = glm::length(sums[slots[i]]);
+		primitive.normals[i] = length > 0.0f ? sums[slots[i]] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
+
+/**
+ * @brief Computes tangents from the UV-coordinates, orthogonal to the normals (which have to exist).
+ * @param[in,out] primitive Primitive to compute the tangents of
+ */
+static void GenerateTangents(ImportedPrimitive& primitive)
+{
+	size_t vertexCount = primitive.positions.size();
+	std::vector<glm::vec3> uDirections(vertexCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> vDirections(vertexCount, glm::vec3(0.0f));
+
+	if (!primitive.uvs.empty())
+	{
+		// Solve edge = du * uDirection + dv * vDirection for both edges of each triangle
+		for (size_t i = 0; i + 2 < primitive.indices.size(); i += 3)
+		{
+			GLuint a = primitive.indices[i], b = primitive.indices[i + 1], c = primitive.indices[i + 2];
+			glm::vec3 edge1 = primitive.positions[b] - primitive.positions[a];
+			glm::vec3 edge2 = primitive.positions[c] - primitive.positions[a];
+			glm::vec2 uvEdge1 = primitive.uvs[b] - primitive.uvs[a];
+			glm::vec2 uvEdge2 = primitive.uvs[c] - primitive.uvs[a];
+			float determinant = uvEdge1.x * uvEdge2.y - uvEdge2.x * uvEdge1.y;
+			if (std::fabs(determinant) < 1e-12f)
+			{
+				continue;
+			}
+
+			glm::vec3 uDirection = (edge1 * uvEdge2.y - edge2 * uvEdge1.y) / determinant;
+			glm::vec3 vDirection = (edge2 * uvEdge1.x - edge1 * uvEdge2.x) / determinant;
+			for (GLuint vertex : { a, b, c })
+			{
+				uDirections[vertex] += uDirection;
+				vDirections[vertex] += vDirection;
+			}
+		}
+	}
+
+	primitive.tangents.resize(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const glm::vec3& normal = primitive.normals[i];
+		glm::vec3 tangent = uDirections[i] - normal * glm::dot(normal, uDirections[i]);
+		if (glm::dot(tangent, tangent) < 1e-20f)
+		{
+			// No UV-coordinates (or a degenerate mapping): any direction along the surface will do
+			tangent = glm::cross(normal, std::fabs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+		tangent = glm::normalize(tangent);
+		float handedness = glm::dot(glm::cross(normal, tangent), vDirections[i]) < 0.0f ? -1.0f : 1.0f;
+		primitive.tangents[i] = glm::vec4(tangent, handedness);
+	}
+}
+
+/**
+ * @brief Generates what the layout needs and the primitive does not have, packs its vertices and adds it as a submesh.
+ * @param[in,out] primitive Primitive to add
+ * @param[in] layout Layout of the vertices
+ * @param[in] attributes Attributes of the layout to fill in
+ * @param[in,out] builder Builder to add the primitive to
+ * @param[out] subMeshNames If not nullptr, gets the name of the primitive
+ * @return Index of the new submesh
+ */
+static int AddPrimitive(ImportedPrimitive& primitive, const VertexLayout& layout, const MeshImportAttributes& attributes,
+	MeshBuilder& builder, std::vector<std::string>* subMeshNames)
+{
+	if ((attributes.normal >= 0 || attributes.tangent >= 0) && primitive.normals.empty())
+	{
+		GenerateNormals(primitive);
+	}
+	if (attributes.tangent >= 0 && primitive.tangents.empty())
+	{
+		GenerateTangents(primitive);
+	}
+
+	builder.Reserve(builder.GetVertexCount() + primitive.positions.size());
+	std::vector<unsigned char> vertex(layout.stride, 0);
+	std::vector<GLuint> builderIndices(primitive.positions.size());
+	for (size_t i = 0; i < primitive.positions.size(); ++i)
+	{
+		if (attributes.position >= 0)
+		{
+			PackVertexAttribute(layout, attributes.position, glm::vec4(primitive.positions[i], 1.0f), vertex.data());
+		}
+		if (attributes.normal >= 0)
+		{
+			PackVertexAttribute(layout, attributes.normal, glm::vec4(primitive.normals[i], 0.0f), vertex.data());
+		}
+		if (attributes.uv >= 0)
+		{
+			glm::vec2 uv = primitive.uvs.empty() ? glm::vec2(0.0f) : primitive.uvs[i];
+			PackVertexAttribute(layout, attributes.uv, glm::vec4(uv, 0.0f, 0.0f), vertex.data());
+		}
+		if (attributes.color >= 0)
+		{
+			PackVertexAttribute(layout, attributes.color, primitive.colors.empty() ? glm::vec4(1.0f) : primitive.colors[i], vertex.data());
+		}
+		if (attributes.tangent >= 0)
+		{
+			PackVertexAttribute(layout, attributes.tangent, primitive.tangents[i], vertex.data());
+		}
+		builderIndices[i] = builder.AddVertex(vertex.data());
+	}
+
+	for (GLuint& index : primitive.indices)
+	{
+		index = builderIndices[index];
+	}
+	if (subMeshNames != nullptr)
+	{
+		subMeshNames->push_back(primitive.name);
+	}
+	return builder.AddIndexedSubMesh(GL_TRIANGLES, primitive.indices.data(), primitive.indices.size());
+}
+
+// --- Wavefront OBJ ---
+
+/**
+ * @brief Skips spaces and tabs (but not line breaks).
+ */
+static void SkipSpaces(const char*& p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+	{
+		++p;
+	}
+}
+
+/**
+ * @brief Moves to the start of the next line.
+ */
+static void SkipLine(const char*& p, const char* end)
+{
+	while (p < end && *p != '\n')
+	{
+		++p;
+	}
+	if (p < end)
+	{
+		++p;
+	}
+}
+
+/**
+ * @brief Reads a decimal number like strtof(), but without locales or copying, and only as precise as a float.
+ * @param[in,out] p Start of the number; moved past it
+ * @param[in] end End of the text
+ * @param[out] value The number
+ * @return false if there is no number at p
+ */
+static bool ParseFloat(const char*& p, const char* end, float& value)
+{
+	static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+		1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+	SkipSpaces(p, end);
+	const char* start = p;
+	bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		++p;
+	}
+
+	// Up to 18 digits fit in the 64-bit integer; later ones only move the decimal point
+	unsigned long long mantissa = 0;
+	int digitCount = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p, anyDigits = true)
+	{
+		if (digitCount < 18)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digitCount += mantissa != 0;
+		}
+		else
+		{
+			++exponent;
+		}
+	}
+	if (p < end && *p == '.')
+	{
+		for (++p; p < end && *p >= '0' && *p <= '9'; ++p, anyDigits = true)
+		{
+			if (digitCount < 18)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digitCount += mantissa != 0;
+				--exponent;
+			}
+		}
+	}
+	if (!anyDigits)
+	{
+		p = start;
+		return false;
+	}
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* exponentStart = p++;
+		bool negativeExponent = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			++p;
+		}
+		if (p < end && *p >= '0' && *p <= '9')
+		{
+			int writtenExponent = 0;
+			for (; p < end && *p >= '0' && *p <= '9'; ++p)
+			{
+				writtenExponent = std::min(writtenExponent * 10 + (*p - '0'), 1000);
+			}
+			exponent += negativeExponent ? -writtenExponent : writtenExponent;
+		}
+		else
+		{
+			p = exponentStart;
+		}
+	}
+
+	double result = static_cast<double>(mantissa);
+	if (exponent != 0)
+	{
+		int absExponent = std::abs(exponent);
+		double scale = absExponent <= 18 ? powersOf10[absExponent] : std::pow(10.0, absExponent);
+		result = exponent < 0 ? result / scale : result * scale;
+	}
+	value = static_cast<float>(negative ? -result : result);
+	return true;
+}
+
+/**
+ * @brief Reads a whole number with an optional sign.
+ * @param[in,out] p Start of the number; moved past it
+ * @param[in] end End of the text
+ * @param[out] value The number
+ * @return false if there is no number at p
+ */
+static bool ParseInt(const char*& p, const char* end, long long& value)
+{
+	bool negative = p < end && *p == '-';
+	const char* digits = (p < end && (*p == '-' || *p == '+')) ? p + 1 : p;
+	if (digits >= end || *digits < '0' || *digits > '9')
+	{
+		return false;
+	}
+
+	value = 0;
+	for (p = digits; p < end && *p >= '0' && *p <= '9'; ++p)
+	{
+		value = value * 10 + (*p - '0');
+	}
+	if (negative)
+	{
+		value = -value;
+	}
+	return true;
+}
+
+/**
+ * @brief Turns a 1-based (or negative, relative to the end) OBJ index into a 0-based one.
+ * @return The index, or MISSING_INDEX if it is out of range
+ */
+static GLuint ResolveObjIndex(long long index, size_t count)
+{
+	long long resolved = index > 0 ? index - 1 : static_cast<long long>(count) + index;
+	return resolved >= 0 && resolved < static_cast<long long>(count) ? static_cast<GLuint>(resolved) : MISSING_INDEX;
+}
+
+/**
+ * Struct containing the corners of the faces of one OBJ group, merged by their (position, uv, normal) indices.
+ * The corners of each OBJ position are in a short list (usually one corner, or a few at UV seams and hard edges),
+ * which is faster to look up than a hash table, since nearby faces use nearby positions.
+ */
+struct ObjCornerTable
+{
+	struct Corner
+	{
+		GLuint position, uv, normal;
+		GLuint next;	// Next corner with the same position (MISSING_INDEX = none)
+	};
+
+	std::vector<Corner> corners;		// Corner of each vertex of the primitive
+	std::vector<GLuint> firstCorners;	// First corner of each OBJ position (MISSING_INDEX = none)
+
+	void Clear()
+	{
+		// Only the lists that were used need to be emptied
+		for (const Corner& corner : corners)
+		{
+			firstCorners[corner.position] = MISSING_INDEX;
+		}
+		corners.clear();
+	}
+
+	/**
+	 * @brief Finds the vertex of a corner, or adds it.
+	 * @param[in] position Position index of the corner (less than positionCount)
+	 * @param[in] uv UV-coordinates index of the corner, or MISSING_INDEX
+	 * @param[in] normal Normal index of the corner, or MISSING_INDEX
+	 * @param[in] positionCount Number of positions read so far
+	 * @param[out] added true if the corner is new
+	 * @return Index of the vertex
+	 */
+	GLuint Insert(GLuint position, GLuint uv, GLuint normal, size_t positionCount, bool& added)
+	{
+		if (firstCorners.size() < positionCount)
+		{
+			firstCorners.resize(std::max(positionCount, firstCorners.size() * 2), MISSING_INDEX);
+		}
+
+		for (GLuint index = firstCorners[position]; index != MISSING_INDEX; index = corners[index].next)
+		{
+			if (corners[index].uv == uv && corners[index].normal == normal)
+			{
+				added = false;
+				return index;
+			}
+		}
+
+		GLuint index = static_cast<GLuint>(corners.size());
+		corners.push_back({ position, uv, normal, firstCorners[position] });
+		firstCorners[position] = index;
+		added = true;
+		return index;
+	}
+};
+
+/**
+ * @brief Adds the faces read so far as a submesh (if there are any), and starts a new primitive with the same name.
+ */
+static void FinishObjPrimitive(ImportedPrimitive& primitive, ObjCornerTable& cornerTable, bool allCornersHaveNormals,
+	const VertexLayout& layout, const MeshImportAttributes& attributes, MeshBuilder& builder,
+	std::vector<std::string>* subMeshNames, int& firstSubMesh)
+{
+	if (!primitive.indices.empty())
+	{
+		// Faces without normals get generated ones, smoothed across the vertices that share an OBJ position
+		if (!allCornersHaveNormals)
+		{
+			primitive.normals.clear();
+		}
+		int subMesh = AddPrimitive(primitive, layout, attributes, builder, subMeshNames);
+		if (firstSubMesh < 0)
+		{
+			firstSubMesh = subMesh;
+		}
+	}
+
+	std::string name = primitive.name;
+	primitive = ImportedPrimitive();
+	primitive.name = name;
+	cornerTable.Clear();
+}
+
+/**
+ * @brief Imports an OBJ file (see ImportMesh()).
+ */
+static int ImportObj(const MappedFile& file, const VertexLayout& layout, const MeshImportAttributes& attributes,
+	MeshBuilder& builder, std::vector<std::string>* subMeshNames)
+{
+	const char* p = reinterpret_cast<const char*>(file.data);
+	const char* end = p + file.size;
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec4> colors;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+
+	ImportedPrimitive primitive;
+	ObjCornerTable cornerTable;
+	bool allCornersHaveNormals = true;
+	bool anyColors = false;
+	int firstSubMesh = -1;
+	std::vector<GLuint> polygon;
+	int lineNumber = 0;
+
+	while (p < end)
+	{
+		++lineNumber;
+		SkipSpaces(p, end);
+		const char* lineStart = p;
+		while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+		{
+			++p;
+		}
+		size_t keywordLength = p - lineStart;
+
+		if (keywordLength == 1 && lineStart[0] == 'v')
+		{
+			glm::vec3 position;
+			if (!ParseFloat(p, end, position.x) || !ParseFloat(p, end, position.y) || !ParseFloat(p, end, position.z))
+			{
+				std::cerr << "Bad vertex position on line " << lineNumber << std::endl;
+				return -1;
+			}
+			positions.push_back(position);
+
+			// Vertex colors are an extension: "v x y z r g b"
+			glm::vec4 color(1.0f);
+			if (ParseFloat(p, end, color.r) && ParseFloat(p, end, color.g) && ParseFloat(p, end, color.b))
+			{
+				anyColors = true;
+			}
+			colors.push_back(color);
+		}
+		else if (keywordLength == 2 && lineStart[0] == 'v' && lineStart[1] == 't')
+		{
+			glm::vec2 uv;
+			if (!ParseFloat(p, end, uv.x) || !ParseFloat(p, end, uv.y))
+			{
+				std::cerr << "Bad UV-coordinates on line " << lineNumber << std::endl;
+				return -1;
+			}
+			uvs.push_back(uv);
+		}
+		else if (keywordLength == 2 && lineStart[0] == 'v' && lineStart[1] == 'n')
+		{
+			glm::vec3 normal;
+			if (!ParseFloat(p, end, normal.x) || !ParseFloat(p, end, normal.y) || !ParseFloat(p, end, normal.z))
+			{
+				std::cerr << "Bad normal on line " << lineNumber << std::endl;
+				return -1;
+			}
+			normals.push_back(normal);
+		}
+		else if (keywordLength == 1 && lineStart[0] == 'f')
+		{
+			// Each corner is v, v/vt, v//vn or v/vt/vn
+			polygon.clear();
+			for (;;)
+			{
+				SkipSpaces(p, end);
+				long long positionIndex;
+				if (!ParseInt(p, end, positionIndex))
+				{
+					break;
+				}
+
+				GLuint position = ResolveObjIndex(positionIndex, positions.size());
+				GLuint uv = MISSING_INDEX;
+				GLuint normal = MISSING_INDEX;
+				long long index;
+				if (p < end && *p == '/')
+				{
+					++p;
+					if (ParseInt(p, end, index))
+					{
+						uv = ResolveObjIndex(index, uvs.size());
+					}
+					if (p < end && *p == '/')
+					{
+						++p;
+						if (ParseInt(p, end, index))
+						{
+							normal = ResolveObjIndex(index, normals.size());
+						}
+					}
+				}
+				if (position == MISSING_INDEX)
+				{
+					std::cerr << "Bad face index on line " << lineNumber << std::endl;
+					return -1;
+				}
+
+				bool added;
+				GLuint vertex = cornerTable.Insert(position, uv, normal, positions.size(), added);
+				if (added)
+				{
+					primitive.positions.push_back(positions[position]);
+					primitive.positionIds.push_back(position);
+					primitive.uvs.push_back(uv != MISSING_INDEX ? uvs[uv] : glm::vec2(0.0f));
+					primitive.normals.push_back(normal != MISSING_INDEX ? normals[normal] : glm::vec3(0.0f));
+					allCornersHaveNormals = allCornersHaveNormals && normal != MISSING_INDEX;
+					if (anyColors)
+					{
+						primitive.colors.resize(primitive.positions.size() - 1, glm::vec4(1.0f));
+						primitive.colors.push_back(colors[position]);
+					}
+				}
+				polygon.push_back(vertex);
+			}
+
+			for (size_t i = 1; i + 1 < polygon.size(); ++i)
+			{
+				primitive.indices.push_back(polygon[0]);
+				primitive.indices.push_back(polygon[i]);
+				primitive.indices.push_back(polygon[i + 1]);
+			}
+		}
+		else if ((keywordLength == 1 && (lineStart[0] == 'o' || lineStart[0] == 'g'))
+			|| (keywordLength == 6 && std::memcmp(lineStart, "usemtl", 6) == 0))
+		{
+			FinishObjPrimitive(primitive, cornerTable, allCornersHaveNormals, layout, attributes, builder, subMeshNames, firstSubMesh);
+			allCornersHaveNormals = true;
+
+			// Materials keep the name of their group
+			if (lineStart[0] != 'u')
+			{
+				SkipSpaces(p, end);
+				const char* nameStart = p;
+				while (p < end && *p != '\n' && *p != '\r')
+				{
+					++p;
+				}
+				while (p > nameStart && (p[-1] == ' ' || p[-1] == '\t'))
+				{
+					--p;
+				}
+				primitive.name.assign(nameStart, p);
+			}
+		}
+
+		SkipLine(p, end);
+	}
+
+	FinishObjPrimitive(primitive, cornerTable, allCornersHaveNormals, layout, attributes, builder, subMeshNames, firstSubMesh);
+	if (firstSubMesh < 0)
+	{
+		std::cerr << "The file has no faces" << std::endl;
+	}
+	return firstSubMesh;
+}
+
+// --- Binary glTF 2.0 ---
+
+/**
+ * Struct containing a JSON document, with every value in one array. Strings point into the text of the file
+ * (escape sequences are left as they are, which is fine for the keys and names that glTF uses).
+ */
+struct JsonDocument
+{
+	enum class Type
+	{
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object
+	};
+
+	struct Value
+	{
+		Type type = Type::Null;
+		double number = 0.0;					// Number, or 1/0 for booleans
+		const char* string = nullptr;
+		size_t stringLength = 0;
+		std::vector<int> children;				// Elements of an array, or values of the members of an object
+		std::vector<std::string> keys;			// Keys of the members of an object
+	};
+
+	std::vector<Value> values;	// values[0] is the root
+
+	const Value& Get(int value) const { return values[value]; }
+
+	/**
+	 * @brief Finds a member of an object.
+	 * @return Index of the value of the member, or -1 if the object does not have it
+	 */
+	int Find(int object, const char* key) const
+	{
+		const Value& value = values[object];
+		for (size_t i = 0; i < value.keys.size(); ++i)
+		{
+			if (value.keys[i] == key)
+			{
+				return value.children[i];
+			}
+		}
+		return -1;
+	}
+
+	double GetNumber(int object, const char* key, double defaultValue) const
+	{
+		int member = object >= 0 ? Find(object, key) : -1;
+		return member >= 0 && values[member].type == Type::Number ? values[member].number : defaultValue;
+	}
+
+	int GetElement(int array, size_t index) const
+	{
+		return array >= 0 && values[array].type == Type::Array && index < values[array].children.size() ? values[array].children[index] : -1;
+	}
+};
+
+/**
+ * @brief Skips JSON whitespace.
+ */
+static void SkipJsonSpaces(const char*& p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+	{
+		++p;
+	}
+}
+
+/**
+ * @brief Reads a JSON string (p is at the opening quote).
+ * @return false if the string does not end
+ */
+static bool ParseJsonString(const char*& p, const char* end, const char*& string, size_t& length)
+{
+	string = ++p;
+	while (p < end && *p != '"')
+	{
+		p += (*p == '\\') ? 2 : 1;
+	}
+	if (p >= end)
+	{
+		return false;
+	}
+	length = p - string;
+	++p;
+	return true;
+}
+
+/**
+ * @brief Reads a JSON value and everything in it into the document.
+ * @return Index of the value, or -1 if the JSON is malformed
+ */
+static int ParseJsonValue(const char*& p, const char* end, JsonDocument& document, int depth)
+{
+	SkipJsonSpaces(p, end);
+	if (p >= end || depth > 64)
+	{
+		return -1;
+	}
+
+	int index = static_cast<int>(document.values.size());
+	document.values.emplace_back();
+
+	if (*p == '{' || *p == '[')
+	{
+		bool isObject = *p == '{';
+		char closing = isObject ? '}' : ']';
+		document.values[index].type = isObject ? JsonDocument::Type::Object : JsonDocument::Type::Array;
+		++p;
+		SkipJsonSpaces(p, end);
+		if (p < end && *p == closing)
+		{
+			++p;
+			return index;
+		}
+
+		for (;;)
+		{
+			std::string key;
+			if (isObject)
+			{
+				SkipJsonSpaces(p, end);
+				const char* keyString;
+				size_t keyLength;
+				if (p >= end || *p != '"' || !ParseJsonString(p, end, keyString, keyLength))
+				{
+					return -1;
+				}
+				key.assign(keyString, keyLength);
+				SkipJsonSpaces(p, end);
+				if (p >= end || *p != ':')
+				{
+					return -1;
+				}
+				++p;
+			}
+
+			int child = ParseJsonValue(p, end, document, depth + 1);
+			if (child < 0)
+			{
+				return -1;
+			}
+			// The vector may have grown, so the value is looked up again
+			document.values[index].children.push_back(child);
+			if (isObject)
+			{
+				document.values[index].keys.push_back(key);
+			}
+
+			SkipJsonSpaces(p, end);
+			if (p < end && *p == ',')
+			{
+				++p;
+			}
+			else if (p < end && *p == closing)
+			{
+				++p;
+				return index;
+			}
+			else
+			{
+				return -1;
+			}
+		}
+	}
+
+	JsonDocument::Value& value = document.values[index];
+	if (*p == '"')
+	{
+		value.type = JsonDocument::Type::String;
+		return ParseJsonString(p, end, value.string, value.stringLength) ? index : -1;
+	}
+	if (end - p >= 4 && std::memcmp(p, "true", 4) == 0)
+	{
+		value.type = JsonDocument::Type::Bool;
+		value.number = 1.0;
+		p += 4;
+		return index;
+	}
+	if (end - p >= 5 && std::memcmp(p, "false", 5) == 0)
+	{
+		value.type = JsonDocument::Type::Bool;
+		p += 5;
+		return index;
+	}
+	if (end - p >= 4 && std::memcmp(p, "null", 4) == 0)
+	{
+		p += 4;
+		return index;
+	}
+
+	float number;
+	if (!ParseFloat(p, end, number))
+	{
+		return -1;
+	}
+	value.type = JsonDocument::Type::Number;
+	value.number = number;
+	return index;
+}
+
+/**
+ * Struct containing where the elements of a glTF accessor are in the binary chunk
+ */
+struct GltfAccessor
+{
+	const unsigned char* data = nullptr;	// First element
+	size_t count = 0;
+	size_t stride = 0;
+	int componentCount = 0;
+	GLenum componentType = GL_FLOAT;		// glTF uses the OpenGL enum values
+	bool normalized = false;
+};
+
+/**
+ * @brief Looks up an accessor and checks that all of its elements are inside the binary chunk.
+ * @return false if the accessor is missing or not supported
+ */
+static bool GetGltfAccessor(const JsonDocument& json, int accessorIndex, const unsigned char* bin, size_t binSize, GltfAccessor& accessor)
+{
+	int accessorValue = json.GetElement(json.Find(0, "accessors"), accessorIndex);
+	if (accessorValue < 0 || json.Find(accessorValue, "sparse") >= 0)
+	{
+		return false;
+	}
+	int bufferView = json.GetElement(json.Find(0, "bufferViews"), static_cast<size_t>(json.GetNumber(accessorValue, "bufferView", -1.0)));
+	if (bufferView < 0 || json.GetNumber(bufferView, "buffer", 0.0) != 0.0)
+	{
+		return false;
+	}
+
+	int typeValue = json.Find(accessorValue, "type");
+	if (typeValue < 0 || json.Get(typeValue).type != JsonDocument::Type::String)
+	{
+		return false;
+	}
+	std::string type(json.Get(typeValue).string, json.Get(typeValue).stringLength);
+	accessor.componentCount = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+
+	accessor.componentType = static_cast<GLenum>(json.GetNumber(accessorValue, "componentType", 0.0));
+	size_t componentSize = accessor.componentType == GL_FLOAT || accessor.componentType == GL_UNSIGNED_INT ? 4
+		: accessor.componentType == GL_UNSIGNED_SHORT || accessor.componentType == GL_SHORT ? 2
+		: accessor.componentType == GL_UNSIGNED_BYTE || accessor.componentType == GL_BYTE ? 1 : 0;
+	if (accessor.componentCount == 0 || componentSize == 0)
+	{
+		return false;
+	}
+
+	accessor.count = static_cast<size_t>(json.GetNumber(accessorValue, "count", 0.0));
+	accessor.normalized = json.Find(accessorValue, "normalized") >= 0 && json.Get(json.Find(accessorValue, "normalized")).number != 0.0;
+	size_t elementSize = componentSize * accessor.componentCount;
+	accessor.stride = static_cast<size_t>(json.GetNumber(bufferView, "byteStride", static_cast<double>(elementSize)));
+	size_t offset = static_cast<size_t>(json.GetNumber(bufferView, "byteOffset", 0.0)) + static_cast<size_t>(json.GetNumber(accessorValue, "byteOffset", 0.0));
+	size_t viewEnd = static_cast<size_t>(json.GetNumber(bufferView, "byteOffset", 0.0)) + static_cast<size_t>(json.GetNumber(bufferView, "byteLength", 0.0));
+	if (accessor.count == 0 || viewEnd > binSize || offset + accessor.stride * (accessor.count - 1) + elementSize > viewEnd)
+	{
+		return false;
+	}
+
+	accessor.data = bin + offset;
+	return true;
+}
+
+/**
+ * @brief Reads one element of an accessor as floats (normalized integers are scaled to [0, 1] or [-1, 1]).
+ * @return The element; components that the accessor does not have are 0 (and w is 1)
+ */
+static glm::vec4 ReadGltfElement(const GltfAccessor& accessor, size_t element)
+{
+	glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+	const unsigned char* data = accessor.data + element * accessor.stride;
+	for (int i = 0; i < accessor.componentCount; ++i)
+	{
+		switch (accessor.componentType)
+		{
+		case GL_FLOAT:
+		{
+			float component;
+			std::memcpy(&component, data + i * 4, 4);
+			value[i] = component;
+			break;
+		}
+		case GL_UNSIGNED_SHORT:
+		{
+			std::uint16_t component;
+			std::memcpy(&component, data + i * 2, 2);
+			value[i] = accessor.normalized ? component / 65535.0f : component;
+			break;
+		}
+		case GL_SHORT:
+		{
+			std::int16_t component;
+			std::memcpy(&component, data + i * 2, 2);
+			value[i] = accessor.normalized ? std::max(component / 32767.0f, -1.0f) : component;
+			break;
+		}
+		case GL_UNSIGNED_BYTE:
+			value[i] = accessor.normalized ? data[i] / 255.0f : data[i];
+			break;
+		case GL_BYTE:
+			value[i] = accessor.normalized ? std::max(static_cast<std::int8_t>(data[i]) / 127.0f, -1.0f) : static_cast<std::int8_t>(data[i]);
+			break;
+		default:
+		{
+			std::uint32_t component;
+			std::memcpy(&component, data + i * 4, 4);
+			value[i] = static_cast<float>(component);
+			break;
+		}
+		}
+	}
+	return value;
+}
+
+/**
+ * @brief Reads one index of an index accessor.
+ */
+static GLuint ReadGltfIndex(const GltfAccessor& accessor, size_t element)
+{
+	const unsigned char* data = accessor.data + element * accessor.stride;
+	if (accessor.componentType == GL_UNSIGNED_BYTE)
+	{
+		return data[0];
+	}
+	if (accessor.componentType == GL_UNSIGNED_SHORT)
+	{
+		std::uint16_t index;
+		std::memcpy(&index, data, 2);
+		return index;
+	}
+	std::uint32_t index;
+	std::memcpy(&index, data, 4);
+	return index;
+}
+
+/**
+ * @brief Imports a binary glTF file (see ImportMesh()).
+ */
+static int ImportGlb(const MappedFile& file, const VertexLayout& layout, const MeshImportAttributes& attributes,
+	MeshBuilder& builder, std::vector<std::string>* subMeshNames)
+{
+	// Header: magic "glTF", version, length; then chunks of (length, type, data), JSON first
+	std::uint32_t header[5];
+	if (file.size < sizeof(header))
+	{
+		std::cerr << "The file is too small to be a binary glTF file" << std::endl;
+		return -1;
+	}
+	std::memcpy(header, file.data, sizeof(header));
+	if (header[0] != 0x46546C67 || header[1] != 2 || header[4] != 0x4E4F534A || 20 + static_cast<size_t>(header[3]) > file.size)
+	{
+		std::cerr << "The file is not a binary glTF 2.0 file" << std::endl;
+		return -1;
+	}
+	const char* jsonStart = reinterpret_cast<const char*>(file.data) + 20;
+	const char* jsonEnd = jsonStart + header[3];
+
+	const unsigned char* bin = nullptr;
+	size_t binSize = 0;
+	size_t binChunk = 20 + ((static_cast<size_t>(header[3]) + 3) & ~static_cast<size_t>(3));
+	if (binChunk + 8 <= file.size)
+	{
+		std::uint32_t chunkHeader[2];
+		std::memcpy(chunkHeader, file.data + binChunk, sizeof(chunkHeader));
+		if (chunkHeader[1] == 0x004E4942 && binChunk + 8 + chunkHeader[0] <= file.size)
+		{
+			bin = file.data + binChunk + 8;
+			binSize = chunkHeader[0];
+		}
+	}
+
+	JsonDocument json;
+	const char* p = jsonStart;
+	if (ParseJsonValue(p, jsonEnd, json, 0) != 0 || json.Get(0).type != JsonDocument::Type::Object)
+	{
+		std::cerr << "The JSON chunk of the file is malformed" << std::endl;
+		return -1;
+	}
+
+	int firstSubMesh = -1;
+	int meshes = json.Find(0, "meshes");
+	for (size_t meshIndex = 0; json.GetElement(meshes, meshIndex) >= 0; ++meshIndex)
+	{
+		int mesh = json.GetElement(meshes, meshIndex);
+		int nameValue = json.Find(mesh, "name");
+		std::string name = nameValue >= 0 && json.Get(nameValue).type == JsonDocument::Type::String
+			? std::string(json.Get(nameValue).string, json.Get(nameValue).stringLength) : "mesh" + std::to_string(meshIndex);
+
+		int primitives = json.Find(mesh, "primitives");
+		for (size_t primitiveIndex = 0; json.GetElement(primitives, primitiveIndex) >= 0; ++primitiveIndex)
+		{
+			int primitiveValue = json.GetElement(primitives, primitiveIndex);
+			if (json.GetNumber(primitiveValue, "mode", GL_TRIANGLES) != GL_TRIANGLES)
+			{
+				std::cerr << "Skipping a primitive of " << name << " that is not made of triangles" << std::endl;
+				continue;
+			}
+
+			int attributeValues = json.Find(primitiveValue, "attributes");
+			GltfAccessor positions;
+			if (attributeValues < 0 || !GetGltfAccessor(json, static_cast<int>(json.GetNumber(attributeValues, "POSITION", -1.0)), bin, binSize, positions))
+			{
+				std::cerr << "A primitive of " << name << " has no positions that can be read" << std::endl;
+				return -1;
+			}
+
+			ImportedPrimitive primitive;
+			primitive.name = name;
+			primitive.positions.resize(positions.count);
+			for (size_t i = 0; i < positions.count; ++i)
+			{
+				primitive.positions[i] = glm::vec3(ReadGltfElement(positions, i));
+			}
+
+			// Optional attributes; ones that cannot be read are generated or left at their defaults
+			GltfAccessor accessor;
+			if (GetGltfAccessor(json, static_cast<int>(json.GetNumber(attributeValues, "NORMAL", -1.0)), bin, binSize, accessor) && accessor.count == positions.count)
+			{
+				primitive.normals.resize(accessor.count);
+				for (size_t i = 0; i < accessor.count; ++i)
+				{
+					primitive.normals[i] = glm::vec3(ReadGltfElement(accessor, i));
+				}
+			}
+			if (GetGltfAccessor(json, static_cast<int>(json.GetNumber(attributeValues, "TEXCOORD_0", -1.0)), bin, binSize, accessor) && accessor.count == positions.count)
+			{
+				// glTF puts (0, 0) at the top-left corner of the texture
+				primitive.uvs.resize(accessor.count);
+				for (size_t i = 0; i < accessor.count; ++i)
+				{
+					glm::vec4 uv = ReadGltfElement(accessor, i);
+					primitive.uvs[i] = glm::vec2(uv.x, 1.0f - uv.y);
+				}
+			}
+			if (GetGltfAccessor(json, static_cast<int>(json.GetNumber(attributeValues, "COLOR_0", -1.0)), bin, binSize, accessor) && accessor.count == positions.count)
+			{
+				primitive.colors.resize(accessor.count);
+				for (size_t i = 0; i < accessor.count; ++i)
+				{
+					primitive.colors[i] = ReadGltfElement(accessor, i);
+				}
+			}
+			if (!primitive.normals.empty()
+				&& GetGltfAccessor(json, static_cast<int>(json.GetNumber(attributeValues, "TANGENT", -1.0)), bin, binSize, accessor) && accessor.count == positions.count)
+			{
+				primitive.tangents.resize(accessor.count);
+				for (size_t i = 0; i < accessor.count; ++i)
+				{
+					primitive.tangents[i] = ReadGltfElement(accessor, i);
+				}
+			}
+
+			int indicesValue = json.Find(primitiveValue, "indices");
+			if (indicesValue >= 0)
+			{
+				if (!GetGltfAccessor(json, static_cast<int>(json.GetNumber(primitiveValue, "indices", -1.0)), bin, binSize, accessor))
+				{
+					std::cerr << "A primitive of " << name << " has indices that cannot be read" << std::endl;
+					return -1;
+				}
+				primitive.indices.resize(accessor.count - accessor.count % 3);
+				for (size_t i = 0; i < primitive.indices.size(); ++i)
+				{
+					primitive.indices[i] = ReadGltfIndex(accessor, i);
+					if (primitive.indices[i] >= positions.count)
+					{
+						std::cerr << "A primitive of " << name << " has an index out of range" << std::endl;
+						return -1;
+					}
+				}
+			}
+			else
+			{
+				primitive.indices.resize(positions.count - positions.count % 3);
+				for (size_t i = 0; i < primitive.indices.size(); ++i)
+				{
+					primitive.indices[i] = static_cast<GLuint>(i);
+				}
+			}
+
+			int subMesh = AddPrimitive(primitive, layout, attributes, builder, subMeshNames);
+			if (firstSubMesh < 0)
+			{
+				firstSubMesh = subMesh;
+			}
+		}
+	}
+
+	if (firstSubMesh < 0)
+	{
+		std::cerr << "The file has no triangle meshes" << std::endl;
+	}
+	return firstSubMesh;
+}
+
+int ImportMesh(const std::string& filePath, const VertexLayout& layout, const MeshImportAttributes& attributes,
+	MeshBuilder& builder, std::vector<std::string>* subMeshNames)
+{
+	if (builder.GetVertexSize() != static_cast<size_t>(layout.stride))
+	{
+		std::cerr << "The vertex size of the mesh builder does not match the vertex layout" << std::endl;
+		return -1;
+	}
+
+	MappedFile file;
+	if (!OpenMappedFile(file, filePath))
+	{
+		std::cerr << "Unable to open " << filePath << std::endl;
+		return -1;
+	}
+
+	size_t extension = filePath.find_last_of('.');
+	std::string extensionName = extension != std::string::npos ? filePath.substr(extension) : "";
+	for (char& c : extensionName)
+	{
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	}
+
+	int firstSubMesh = -1;
+	if (extensionName == ".obj")
+	{
+		firstSubMesh = ImportObj(file, layout, attributes, builder, subMeshNames);
+	}
+	else if (extensionName == ".glb")
+	{
+		firstSubMesh = ImportGlb(file, layout, attributes, builder, subMeshNames);
+	}
+	else
+	{
+		std::cerr << "Unknown mesh file type: " << filePath << std::endl;
+	}
+
+	if (firstSubMesh < 0)
+	{
+		std::cerr << "Unable to import " << filePath << std::endl;
+	}
+	CloseMappedFile(file);
+	return firstSubMesh;
+}
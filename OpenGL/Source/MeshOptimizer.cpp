@@ -0,0 +1,420 @@
+#include <gdev/MeshOptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Tuning of the vertex scores of OptimizeVertexCache(), from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+// The scoring models an LRU cache that is larger than the FIFO cache ACMR is measured with, which is what he suggests.
+static const int SCORE_CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+// Valences up to this have their boost in a table
+static const unsigned MAX_TABLE_VALENCE = 64;
+
+/**
+ * FIFO post-transform cache for counting misses. A vertex is in the cache if fewer than cacheSize vertices
+ * were added after it, so nothing has to be shifted or searched.
+ */
+struct FifoCache
+{
+	std::vector<size_t> addedAt;	// Time each vertex was last added
+	size_t time;
+	size_t cacheSize;
+
+	FifoCache(size_t vertexCount, int size)
+		: addedAt(vertexCount, 0)
+		, time(static_cast<size_t>(size) + 1)
+		, cacheSize(static_cast<size_t>(size))
+	{
+	}
+
+	/**
+	 * @brief Empties the cache (e.g. at the start of a draw).
+	 */
+	void Flush()
+	{
+		time += cacheSize + 1;
+	}
+
+	/**
+	 * @brief Uses a vertex, adding it if it is not in the cache.
+	 * @return 1 if it was a miss, 0 if it was a hit
+	 */
+	unsigned Use(GLuint vertex)
+	{
+		if (time - addedAt[vertex] <= cacheSize)
+		{
+			return 0;
+		}
+		addedAt[vertex] = time++;
+		return 1;
+	}
+};
+
+/**
+ * @brief Counts the cache misses of a triangle list that is drawn with an empty cache.
+ */
+static size_t CountCacheMisses(const GLuint* indices, size_t indexCount, size_t vertexCount, int cacheSize)
+{
+	FifoCache cache(vertexCount, cacheSize);
+	size_t misses = 0;
+	for (size_t i = 0; i < indexCount - indexCount % 3; ++i)
+	{
+		misses += cache.Use(indices[i]);
+	}
+	return misses;
+}
+
+float ComputeAcmr(const GLuint* indices, size_t indexCount, size_t vertexCount, int cacheSize)
+{
+	size_t triangleCount = indexCount / 3;
+	return triangleCount > 0 ? static_cast<float>(CountCacheMisses(indices, indexCount, vertexCount, cacheSize)) / triangleCount : 0.0f;
+}
+
+void OptimizeVertexCache(GLuint* destination, const GLuint* indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+
+	// Triangles of each vertex (the ones that are not emitted yet are at the front of each list)
+	std::vector<unsigned> remainingTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		++remainingTriangles[indices[i]];
+	}
+	std::vector<size_t> firstTriangle(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		firstTriangle[v + 1] = firstTriangle[v] + remainingTriangles[v];
+	}
+	std::vector<GLuint> vertexTriangles(triangleCount * 3);
+	std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		vertexTriangles[fill[indices[i]]++] = static_cast<GLuint>(i / 3);
+	}
+
+	// Score tables; positions 0-2 are the triangle that was just emitted, which gets a fixed score
+	// so that the next triangle does not simply prefer its most recent edge
+	float cacheScores[SCORE_CACHE_SIZE];
+	for (int i = 0; i < SCORE_CACHE_SIZE; ++i)
+	{
+		cacheScores[i] = i < 3 ? LAST_TRIANGLE_SCORE
+			: std::pow(1.0f - static_cast<float>(i - 3) / (SCORE_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+	}
+	float valenceScores[MAX_TABLE_VALENCE + 1];
+	valenceScores[0] = 0.0f;
+	for (unsigned i = 1; i <= MAX_TABLE_VALENCE; ++i)
+	{
+		valenceScores[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+	}
+	auto scoreVertex = [&](int cachePosition, unsigned valence)
+	{
+		if (valence == 0)
+		{
+			return -1.0f;	// Nothing left to draw with it
+		}
+		float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+		return score + (valence <= MAX_TABLE_VALENCE ? valenceScores[valence]
+			: VALENCE_BOOST_SCALE * std::pow(static_cast<float>(valence), -VALENCE_BOOST_POWER));
+	};
+
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		vertexScores[v] = scoreVertex(-1, remainingTriangles[v]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+	}
+	std::vector<bool> emitted(triangleCount, false);
+
+	// The cache holds 3 more vertices while it is being updated, which then fall out
+	GLuint cache[SCORE_CACHE_SIZE + 3];
+	GLuint newCache[SCORE_CACHE_SIZE + 3];
+	int cacheCount = 0;
+
+	size_t bestTriangle = 0;
+	size_t inputCursor = 0;
+	for (size_t output = 0; output < triangleCount; ++output)
+	{
+		// When no triangle in the cache can be drawn, start again from the next triangle of the input
+		if (bestTriangle >= triangleCount)
+		{
+			while (emitted[inputCursor])
+			{
+				++inputCursor;
+			}
+			bestTriangle = inputCursor;
+		}
+
+		emitted[bestTriangle] = true;
+		const GLuint* triangle = &indices[bestTriangle * 3];
+		destination[output * 3] = triangle[0];
+		destination[output * 3 + 1] = triangle[1];
+		destination[output * 3 + 2] = triangle[2];
+
+		// Take the triangle out of the lists of its vertices
+		int newCacheCount = 0;
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			GLuint vertex = triangle[corner];
+			GLuint* triangles = &vertexTriangles[firstTriangle[vertex]];
+			unsigned& remaining = remainingTriangles[vertex];
+			for (unsigned i = 0; i < remaining; ++i)
+			{
+				if (triangles[i] == bestTriangle)
+				{
+					std::swap(triangles[i], triangles[remaining - 1]);
+					--remaining;
+					break;
+				}
+			}
+			newCache[newCacheCount++] = vertex;
+		}
+
+		// The vertices of the triangle move to the front of the cache, and the rest move back
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			GLuint vertex = cache[i];
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+
+		// Rescore the vertices in the cache (and the ones that just fell out), and the triangles they still have
+		for (int i = 0; i < newCacheCount; ++i)
+		{
+			GLuint vertex = newCache[i];
+			float score = scoreVertex(i < SCORE_CACHE_SIZE ? i : -1, remainingTriangles[vertex]);
+			float scoreChange = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			const GLuint* triangles = &vertexTriangles[firstTriangle[vertex]];
+			for (unsigned j = 0; j < remainingTriangles[vertex]; ++j)
+			{
+				triangleScores[triangles[j]] += scoreChange;
+			}
+		}
+
+		// The best of those triangles is drawn next
+		float bestScore = -1.0f;
+		bestTriangle = triangleCount;
+		for (int i = 0; i < std::min(newCacheCount, SCORE_CACHE_SIZE); ++i)
+		{
+			GLuint vertex = newCache[i];
+			const GLuint* triangles = &vertexTriangles[firstTriangle[vertex]];
+			for (unsigned j = 0; j < remainingTriangles[vertex]; ++j)
+			{
+				if (triangleScores[triangles[j]] > bestScore)
+				{
+					bestScore = triangleScores[triangles[j]];
+					bestTriangle = triangles[j];
+				}
+			}
+		}
+
+		cacheCount = std::min(newCacheCount, SCORE_CACHE_SIZE);
+		std::copy(newCache, newCache + cacheCount, cache);
+	}
+}
+
+size_t OptimizeOverdraw(GLuint* destination, const GLuint* indices, size_t indexCount, const glm::vec3* positions,
+	size_t vertexCount, float threshold)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return 0;
+	}
+
+	// Hard boundaries: triangles whose three vertices all miss the cache, where the vertex cache order
+	// started on a new part of the mesh. Moving the clusters between them around costs nothing.
+	std::vector<size_t> hardClusters;
+	std::vector<size_t> hardClusterMisses;
+	FifoCache cache(vertexCount, ACMR_CACHE_SIZE);
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		unsigned misses = cache.Use(indices[t * 3]) + cache.Use(indices[t * 3 + 1]) + cache.Use(indices[t * 3 + 2]);
+		if (t == 0 || misses == 3)
+		{
+			hardClusters.push_back(t);
+			hardClusterMisses.push_back(0);
+		}
+		hardClusterMisses.back() += misses;
+	}
+	hardClusters.push_back(triangleCount);
+
+	// Soft boundaries: split each hard cluster again as soon as the part so far, drawn with a cold cache,
+	// is within the threshold of the ACMR of the whole cluster
+	std::vector<size_t> clusters;
+	for (size_t c = 0; c + 1 < hardClusters.size(); ++c)
+	{
+		size_t start = hardClusters[c];
+		size_t end = hardClusters[c + 1];
+		float clusterAcmr = static_cast<float>(hardClusterMisses[c]) / (end - start);
+
+		cache.Flush();
+		size_t misses = 0;
+		clusters.push_back(start);
+		for (size_t t = start; t < end; ++t)
+		{
+			misses += cache.Use(indices[t * 3]) + cache.Use(indices[t * 3 + 1]) + cache.Use(indices[t * 3 + 2]);
+			size_t clusterTriangles = t + 1 - clusters.back();
+			if (t + 1 < end && static_cast<float>(misses) / clusterTriangles <= clusterAcmr * threshold)
+			{
+				clusters.push_back(t + 1);
+				cache.Flush();
+				misses = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+	size_t clusterCount = clusters.size() - 1;
+
+	// Area-weighted center and normal of each cluster, and the center of the mesh
+	std::vector<glm::vec3> clusterCenters(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		float clusterArea = 0.0f;
+		for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const glm::vec3& a = positions[indices[t * 3]];
+			const glm::vec3& b = positions[indices[t * 3 + 1]];
+			const glm::vec3& p = positions[indices[t * 3 + 2]];
+			glm::vec3 normal = glm::cross(b - a, p - a);
+			float area = glm::length(normal);
+			clusterCenters[c] += (a + b + p) * (area / 3.0f);
+			clusterNormals[c] += normal;
+			clusterArea += area;
+		}
+		meshCenter += clusterCenters[c];
+		meshArea += clusterArea;
+		clusterCenters[c] = clusterArea > 0.0f ? clusterCenters[c] / clusterArea : positions[indices[clusters[c] * 3]];
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCenter /= meshArea;
+	}
+
+	// Clusters that face away from the center are on the outside, so they go first
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<size_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		float normalLength = glm::length(clusterNormals[c]);
+		sortKeys[c] = normalLength > 0.0f ? glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c] / normalLength) : 0.0f;
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	GLuint* out = destination;
+	for (size_t c : order)
+	{
+		out = std::copy(&indices[clusters[c] * 3], &indices[clusters[c + 1] * 3], out);
+	}
+	return clusterCount;
+}
+
+void ComputeVertexFetchRemap(std::vector<GLuint>& remap, const GLuint* indices, size_t indexCount, size_t vertexCount)
+{
+	static const GLuint UNUSED = ~0u;
+	remap.assign(vertexCount, UNUSED);
+
+	GLuint nextIndex = 0;
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		if (remap[indices[i]] == UNUSED)
+		{
+			remap[indices[i]] = nextIndex++;
+		}
+	}
+	for (GLuint& index : remap)
+	{
+		if (index == UNUSED)
+		{
+			index = nextIndex++;
+		}
+	}
+}
+
+MeshOptimizeStats OptimizeMesh(MeshBuilder& builder, const VertexLayout& layout, float overdrawThreshold)
+{
+	MeshOptimizeStats stats;
+	const std::vector<SubMesh>& subMeshes = builder.GetSubMeshes();
+	size_t indexCount = builder.GetIndices().size();
+	size_t vertexCount = builder.GetVertexCount();
+
+	// Cut the indices at the start and end of every submesh. Reordering the triangles within each piece
+	// keeps every submesh drawing the same triangles, including the ones that cover several others.
+	std::vector<size_t> cuts = { 0, indexCount };
+	for (const SubMesh& subMesh : subMeshes)
+	{
+		cuts.push_back(subMesh.firstIndex);
+		cuts.push_back(subMesh.firstIndex + subMesh.indexCount);
+	}
+	std::sort(cuts.begin(), cuts.end());
+	cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+	std::vector<glm::vec3> positions(vertexCount, glm::vec3(0.0f));
+	int positionAttribute = FindVertexAttribute(layout, 0);
+	if (positionAttribute >= 0 && builder.GetVertexSize() == static_cast<size_t>(layout.stride))
+	{
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			positions[i] = glm::vec3(UnpackVertexAttribute(layout, positionAttribute, builder.GetVertexData() + i * layout.stride));
+		}
+	}
+
+	size_t missesBefore = 0;
+	size_t missesAfter = 0;
+	std::vector<GLuint> cacheOrder;
+	std::vector<GLuint> overdrawOrder;
+	for (size_t c = 0; c + 1 < cuts.size(); ++c)
+	{
+		size_t first = cuts[c];
+		size_t count = cuts[c + 1] - first;
+		bool trianglesOnly = count >= 3 && count % 3 == 0;
+		for (const SubMesh& subMesh : subMeshes)
+		{
+			bool covers = subMesh.firstIndex <= first && first + count <= subMesh.firstIndex + subMesh.indexCount;
+			trianglesOnly = trianglesOnly && (!covers || subMesh.mode == GL_TRIANGLES);
+		}
+		if (!trianglesOnly)
+		{
+			continue;
+		}
+
+		const GLuint* pieceIndices = builder.GetIndices().data() + first;
+		missesBefore += CountCacheMisses(pieceIndices, count, vertexCount, ACMR_CACHE_SIZE);
+
+		cacheOrder.resize(count);
+		overdrawOrder.resize(count);
+		OptimizeVertexCache(cacheOrder.data(), pieceIndices, count, vertexCount);
+		stats.clusterCount += OptimizeOverdraw(overdrawOrder.data(), cacheOrder.data(), count, positions.data(), vertexCount, overdrawThreshold);
+		builder.ReplaceIndices(first, overdrawOrder.data(), count);
+
+		missesAfter += CountCacheMisses(overdrawOrder.data(), count, vertexCount, ACMR_CACHE_SIZE);
+		stats.triangleCount += count / 3;
+	}
+
+	// Vertex fetch order last, since it follows the order of the triangles
+	std::vector<GLuint> remap;
+	ComputeVertexFetchRemap(remap, builder.GetIndices().data(), indexCount, vertexCount);
+	builder.RemapVertices(remap);
+
+	if (stats.triangleCount > 0)
+	{
+		stats.acmrBefore = static_cast<float>(missesBefore) / stats.triangleCount;
+		stats.acmrAfter = static_cast<float>(missesAfter) / stats.triangleCount;
+	}
+	return stats;
+}
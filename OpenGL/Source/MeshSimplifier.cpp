@@ -0,0 +1,400 @@
+#include <gdev/MeshSimplifier.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// A level of detail that keeps more than this fraction of the triangles of the level before it is not worth making
+static const float MIN_LOD_REDUCTION = 0.8f;
+
+/**
+ * Symmetric 4x4 matrix that sums the squared distances of a point to a set of planes, weighted by the area
+ * of the triangles the planes come from. Doubles, since the sums of many planes lose too much in floats.
+ */
+struct Quadric
+{
+	double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+	double weight = 0.0;	// Sum of the areas
+
+	/**
+	 * @brief Adds the plane of a triangle.
+	 * @param[in] normal Unit normal of the plane
+	 * @param[in] distance Distance of the plane from the origin along the normal (dot(normal, point) + distance = 0)
+	 * @param[in] area Area of the triangle
+	 */
+	void AddPlane(const glm::dvec3& normal, double distance, double area)
+	{
+		a00 += area * normal.x * normal.x;
+		a01 += area * normal.x * normal.y;
+		a02 += area * normal.x * normal.z;
+		a11 += area * normal.y * normal.y;
+		a12 += area * normal.y * normal.z;
+		a22 += area * normal.z * normal.z;
+		b0 += area * normal.x * distance;
+		b1 += area * normal.y * distance;
+		b2 += area * normal.z * distance;
+		c += area * distance * distance;
+		weight += area;
+	}
+
+	void Add(const Quadric& other)
+	{
+		a00 += other.a00;
+		a01 += other.a01;
+		a02 += other.a02;
+		a11 += other.a11;
+		a12 += other.a12;
+		a22 += other.a22;
+		b0 += other.b0;
+		b1 += other.b1;
+		b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+	}
+
+	/**
+	 * @brief Computes the sum of the weighted squared distances of a point to the planes.
+	 * @param[in] p Point
+	 * @return The sum (0 if there are no planes)
+	 */
+	double Evaluate(const glm::vec3& p) const
+	{
+		double x = p.x;
+		double y = p.y;
+		double z = p.z;
+		double result = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+		return std::max(result, 0.0);
+	}
+};
+
+/**
+ * Struct containing a candidate edge collapse: vertex 'from' moves onto vertex 'to'
+ */
+struct Collapse
+{
+	float error;	// Average distance of the new position to the planes around both vertices
+	GLuint from;
+	GLuint to;
+};
+
+/**
+ * @brief Finds the vertices that must not move: the ones that share their position with other vertices (attribute
+ * seams), and the ones on edges that do not have exactly one triangle on each side (borders and non-manifold edges).
+ * @param[out] locked Whether each vertex is locked
+ * @param[in] indices Indices of the triangles
+ * @param[in] indexCount Number of indices
+ * @param[in] positions Position of each vertex
+ * @param[in] vertexCount Number of vertices
+ */
+static void FindLockedVertices(std::vector<bool>& locked, const GLuint* indices, size_t indexCount, const glm::vec3* positions,
+	size_t vertexCount)
+{
+	locked.assign(vertexCount, false);
+
+	// Vertices with the same position are next to each other once they are sorted by it
+	std::vector<GLuint> byPosition(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		byPosition[i] = static_cast<GLuint>(i);
+	}
+	auto lessPosition = [positions](GLuint a, GLuint b)
+	{
+		const glm::vec3& pa = positions[a];
+		const glm::vec3& pb = positions[b];
+		return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+	};
+	std::sort(byPosition.begin(), byPosition.end(), lessPosition);
+	for (size_t i = 1; i < vertexCount; ++i)
+	{
+		if (positions[byPosition[i]] == positions[byPosition[i - 1]])
+		{
+			locked[byPosition[i]] = true;
+			locked[byPosition[i - 1]] = true;
+		}
+	}
+
+	// Every edge of a closed manifold surface is used by two triangles, once in each direction
+	std::vector<uint64_t> edges;
+	edges.reserve(indexCount);
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		for (int e = 0; e < 3; ++e)
+		{
+			GLuint a = indices[i + e];
+			GLuint b = indices[i + (e + 1) % 3];
+			edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size();)
+	{
+		size_t end = i + 1;
+		while (end < edges.size() && edges[end] == edges[i])
+		{
+			++end;
+		}
+		if (end - i != 2)
+		{
+			locked[static_cast<GLuint>(edges[i] >> 32)] = true;
+			locked[static_cast<GLuint>(edges[i] & 0xFFFFFFFFu)] = true;
+		}
+		i = end;
+	}
+}
+
+/**
+ * @brief Checks whether moving a vertex onto another one would flip any of the triangles around it
+ * that do not also use the other vertex (those disappear with the collapse).
+ * @param[in] collapse Collapse to check
+ * @param[in] triangles Indices of the triangles
+ * @param[in] collapseTo Vertex that each vertex has been collapsed onto so far in this pass (itself if none)
+ * @param[in] vertexTriangles Triangles around each vertex, vertexTriangleOffsets[v] to vertexTriangleOffsets[v + 1]
+ * @param[in] vertexTriangleOffsets Offsets into vertexTriangles
+ * @param[in] positions Position of each vertex
+ * @return true if the collapse keeps the triangles facing the same way
+ */
+static bool IsCollapseValid(const Collapse& collapse, const std::vector<GLuint>& triangles, const std::vector<GLuint>& collapseTo,
+	const std::vector<GLuint>& vertexTriangles, const std::vector<size_t>& vertexTriangleOffsets, const glm::vec3* positions)
+{
+	for (size_t i = vertexTriangleOffsets[collapse.from]; i < vertexTriangleOffsets[collapse.from + 1]; ++i)
+	{
+		const GLuint* indices = &triangles[vertexTriangles[i] * 3];
+		GLuint triangle[3] = { collapseTo[indices[0]], collapseTo[indices[1]], collapseTo[indices[2]] };
+		// Skip the triangles that disappear with this collapse or with one made before it in the pass
+		if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to
+			|| triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+		{
+			continue;
+		}
+
+		glm::vec3 corners[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			corners[c] = positions[triangle[c]];
+		}
+		glm::vec3 normalBefore = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+		for (int c = 0; c < 3; ++c)
+		{
+			if (triangle[c] == collapse.from)
+			{
+				corners[c] = positions[collapse.to];
+			}
+		}
+		glm::vec3 normalAfter = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+		if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t SimplifyMesh(GLuint* destination, const GLuint* indices, size_t indexCount, const glm::vec3* positions, size_t vertexCount,
+	size_t targetIndexCount, float& error)
+{
+	error = 0.0f;
+	std::vector<GLuint> triangles(indices, indices + indexCount - indexCount % 3);
+	if (triangles.size() <= targetIndexCount)
+	{
+		std::copy(triangles.begin(), triangles.end(), destination);
+		return triangles.size();
+	}
+
+	std::vector<bool> locked;
+	FindLockedVertices(locked, triangles.data(), triangles.size(), positions, vertexCount);
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < triangles.size(); i += 3)
+	{
+		glm::dvec3 p0 = positions[triangles[i]];
+		glm::dvec3 p1 = positions[triangles[i + 1]];
+		glm::dvec3 p2 = positions[triangles[i + 2]];
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		double length = glm::length(normal);
+		if (length == 0.0)
+		{
+			continue;
+		}
+		normal /= length;
+		double distance = -glm::dot(normal, p0);
+		for (int c = 0; c < 3; ++c)
+		{
+			quadrics[triangles[i + c]].AddPlane(normal, distance, 0.5 * length);
+		}
+	}
+
+	// Each pass collapses the cheapest edges that share no vertex with another collapse of the pass,
+	// so that no vertex moves twice before the triangles are rewritten
+	std::vector<GLuint> vertexTriangles;
+	std::vector<size_t> vertexTriangleOffsets;
+	std::vector<Collapse> collapses;
+	std::vector<GLuint> collapseTo(vertexCount);
+	std::vector<bool> touched;
+	while (triangles.size() > targetIndexCount)
+	{
+		size_t triangleCount = triangles.size() / 3;
+		vertexTriangleOffsets.assign(vertexCount + 1, 0);
+		for (GLuint index : triangles)
+		{
+			++vertexTriangleOffsets[index + 1];
+		}
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			vertexTriangleOffsets[v + 1] += vertexTriangleOffsets[v];
+		}
+		vertexTriangles.resize(triangles.size());
+		std::vector<size_t> fill(vertexTriangleOffsets.begin(), vertexTriangleOffsets.end() - 1);
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			vertexTriangles[fill[triangles[i]]++] = static_cast<GLuint>(i / 3);
+		}
+
+		// Each edge is shared by two triangles in opposite directions, so it is taken from the one where it goes up,
+		// and collapsed in the cheaper direction that moves an unlocked vertex
+		collapses.clear();
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			for (int e = 0; e < 3; ++e)
+			{
+				GLuint a = triangles[i + e];
+				GLuint b = triangles[i + (e + 1) % 3];
+				if (a > b)
+				{
+					continue;
+				}
+				// The quadric of both vertices is the sum of theirs, and so is its value at a point
+				const Quadric& quadricA = quadrics[a];
+				const Quadric& quadricB = quadrics[b];
+				double weight = std::max(quadricA.weight + quadricB.weight, 1e-30);
+				double errorAToB = locked[a] ? HUGE_VAL : quadricA.Evaluate(positions[b]) + quadricB.Evaluate(positions[b]);
+				double errorBToA = locked[b] ? HUGE_VAL : quadricA.Evaluate(positions[a]) + quadricB.Evaluate(positions[a]);
+				if (errorAToB <= errorBToA && !locked[a])
+				{
+					collapses.push_back({ static_cast<float>(std::sqrt(errorAToB / weight)), a, b });
+				}
+				else if (!locked[b])
+				{
+					collapses.push_back({ static_cast<float>(std::sqrt(errorBToA / weight)), b, a });
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+		// A collapse removes about two triangles
+		size_t collapseLimit = (triangleCount - targetIndexCount / 3) / 2 + 1;
+		size_t collapseCount = 0;
+		touched.assign(vertexCount, false);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			collapseTo[v] = static_cast<GLuint>(v);
+		}
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapseCount >= collapseLimit)
+			{
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to]
+				|| !IsCollapseValid(collapse, triangles, collapseTo, vertexTriangles, vertexTriangleOffsets, positions))
+			{
+				continue;
+			}
+
+			collapseTo[collapse.from] = collapse.to;
+			quadrics[collapse.to].Add(quadrics[collapse.from]);
+			error = std::max(error, collapse.error);
+			++collapseCount;
+			touched[collapse.from] = true;
+			touched[collapse.to] = true;
+		}
+		if (collapseCount == 0)
+		{
+			break;
+		}
+
+		// Move the collapsed vertices, and drop the triangles that lost their area
+		size_t kept = 0;
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			GLuint a = collapseTo[triangles[i]];
+			GLuint b = collapseTo[triangles[i + 1]];
+			GLuint c = collapseTo[triangles[i + 2]];
+			if (a != b && b != c && c != a)
+			{
+				triangles[kept++] = a;
+				triangles[kept++] = b;
+				triangles[kept++] = c;
+			}
+		}
+		triangles.resize(kept);
+	}
+
+	std::copy(triangles.begin(), triangles.end(), destination);
+	return triangles.size();
+}
+
+std::vector<MeshLod> GenerateMeshLods(MeshBuilder& builder, const VertexLayout& layout, int subMesh, int lodCount)
+{
+	std::vector<MeshLod> lods(1);
+	lods[0].subMesh = subMesh;
+
+	const SubMesh& fullMesh = builder.GetSubMeshes()[subMesh];
+	int positionAttribute = FindVertexAttribute(layout, 0);
+	if (fullMesh.mode != GL_TRIANGLES || positionAttribute < 0 || builder.GetVertexSize() != static_cast<size_t>(layout.stride))
+	{
+		return lods;
+	}
+
+	size_t vertexCount = builder.GetVertexCount();
+	std::vector<glm::vec3> positions(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		positions[i] = glm::vec3(UnpackVertexAttribute(layout, positionAttribute, builder.GetVertexData() + i * layout.stride));
+	}
+
+	// Each level is simplified from the one before, which is faster than starting from the full mesh every time.
+	// The errors add up, since each level is measured against the level it was made from.
+	const std::vector<GLuint>& indices = builder.GetIndices();
+	std::vector<GLuint> lodIndices(indices.begin() + fullMesh.firstIndex, indices.begin() + fullMesh.firstIndex + fullMesh.indexCount);
+	std::vector<GLuint> simplified(lodIndices.size());
+	for (int level = 1; level <= lodCount; ++level)
+	{
+		float levelError = 0.0f;
+		size_t targetIndexCount = lodIndices.size() / 6 * 3;
+		size_t simplifiedCount = SimplifyMesh(simplified.data(), lodIndices.data(), lodIndices.size(), positions.data(), vertexCount,
+			targetIndexCount, levelError);
+		if (simplifiedCount == 0 || simplifiedCount > lodIndices.size() * MIN_LOD_REDUCTION)
+		{
+			break;
+		}
+
+		lodIndices.assign(simplified.begin(), simplified.begin() + simplifiedCount);
+		MeshLod lod;
+		lod.subMesh = builder.AddIndexedSubMesh(GL_TRIANGLES, lodIndices.data(), lodIndices.size());
+		lod.error = lods.back().error + levelError;
+		lods.push_back(lod);
+	}
+
+	return lods;
+}
+
+float GetLodPixelsPerUnit(float fieldOfViewY, int viewportHeight, float distance)
+{
+	return viewportHeight / (2.0f * std::tan(0.5f * fieldOfViewY) * std::max(distance, 1e-6f));
+}
+
+int SelectMeshLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxPixelError, int currentLod)
+{
+	for (int level = static_cast<int>(lods.size()) - 1; level > 0; --level)
+	{
+		float allowedError = level > currentLod ? maxPixelError * (1.0f - LOD_HYSTERESIS) : maxPixelError;
+		if (lods[level].error * pixelsPerUnit <= allowedError)
+		{
+			return level;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,266 @@
+#include <gdev/Meshlet.h>
+
+#include <gdev/Benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GDEV_MESHLET_SSE
+#include <xmmintrin.h>
+#endif
+
+// Smallest dot product between the cone axis and a triangle normal that still gives a cone worth testing;
+// below it the triangles face too many ways for the meshlet to ever face away from the camera
+static const float MIN_CONE_SPREAD = 0.1f;
+
+/**
+ * @brief Computes the bounding sphere and normal cone of a meshlet from its triangles.
+ * @param[in,out] meshlet Meshlet with its index range set
+ * @param[in] indices Indices of the mesh
+ * @param[in] positions Position of each vertex
+ */
+static void ComputeMeshletBounds(Meshlet& meshlet, const GLuint* indices, const glm::vec3* positions)
+{
+	const GLuint* triangles = indices + meshlet.firstIndex;
+	size_t triangleCount = meshlet.indexCount / 3;
+
+	std::vector<glm::vec3> corners(meshlet.indexCount);
+	BoundingBox box;
+	for (GLsizei i = 0; i < meshlet.indexCount; ++i)
+	{
+		corners[i] = positions[triangles[i]];
+		ExpandBoundingBox(box, corners[i]);
+	}
+	meshlet.sphere = ComputeBoundingSphere(box, corners.data(), corners.size());
+
+	// The axis is the average of the triangle normals, and the cone is as wide as the normal furthest from it
+	std::vector<glm::vec3> normals(triangleCount);
+	glm::vec3 normalSum(0.0f);
+	for (size_t i = 0; i < triangleCount; ++i)
+	{
+		glm::vec3 normal = glm::cross(corners[i * 3 + 1] - corners[i * 3], corners[i * 3 + 2] - corners[i * 3]);
+		float length = glm::length(normal);
+		normals[i] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+		normalSum += normals[i];
+	}
+
+	float axisLength = glm::length(normalSum);
+	if (axisLength <= 0.0f)
+	{
+		return;
+	}
+	glm::vec3 axis = normalSum / axisLength;
+
+	float minDot = 1.0f;
+	for (const glm::vec3& normal : normals)
+	{
+		if (normal != glm::vec3(0.0f))
+		{
+			minDot = std::min(minDot, glm::dot(axis, normal));
+		}
+	}
+	if (minDot <= MIN_CONE_SPREAD)
+	{
+		return;
+	}
+
+	// Moves the apex back along the axis until it is behind every triangle plane, so that a camera
+	// inside the cone behind the apex is behind every triangle
+	float apexDistance = 0.0f;
+	for (size_t i = 0; i < triangleCount; ++i)
+	{
+		if (normals[i] != glm::vec3(0.0f))
+		{
+			float distance = glm::dot(meshlet.sphere.center - corners[i * 3], normals[i]) / glm::dot(axis, normals[i]);
+			apexDistance = std::max(apexDistance, distance);
+		}
+	}
+
+	meshlet.coneApex = meshlet.sphere.center - axis * apexDistance;
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+size_t BuildMeshlets(const MeshBuilder& builder, const VertexLayout& layout, int subMesh, std::vector<Meshlet>& meshlets)
+{
+	const SubMesh& range = builder.GetSubMeshes()[subMesh];
+	int positionAttribute = FindVertexAttribute(layout, 0);
+	if (range.mode != GL_TRIANGLES || positionAttribute < 0 || builder.GetVertexSize() != static_cast<size_t>(layout.stride))
+	{
+		return 0;
+	}
+
+	size_t vertexCount = builder.GetVertexCount();
+	std::vector<glm::vec3> positions(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		positions[i] = glm::vec3(UnpackVertexAttribute(layout, positionAttribute, builder.GetVertexData() + i * layout.stride));
+	}
+
+	// A vertex is in the current meshlet if it is marked with the number of that meshlet
+	const std::vector<GLuint>& indices = builder.GetIndices();
+	std::vector<size_t> vertexMeshlet(vertexCount, SIZE_MAX);
+	size_t firstMeshlet = meshlets.size();
+	size_t meshletVertexCount = 0;
+
+	Meshlet meshlet;
+	meshlet.firstIndex = range.firstIndex;
+	for (GLuint i = range.firstIndex; i + 3 <= range.firstIndex + range.indexCount; i += 3)
+	{
+		size_t meshletIndex = meshlets.size();
+		size_t newVertexCount = 0;
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			GLuint vertex = indices[i + corner];
+			bool repeated = (corner > 0 && indices[i] == vertex) || (corner > 1 && indices[i + 1] == vertex);
+			newVertexCount += vertexMeshlet[vertex] != meshletIndex && !repeated ? 1 : 0;
+		}
+
+		// The triangle starts a new meshlet if it does not fit into the current one
+		if (meshletVertexCount + newVertexCount > MESHLET_MAX_VERTICES
+			|| static_cast<size_t>(meshlet.indexCount / 3) + 1 > MESHLET_MAX_TRIANGLES)
+		{
+			ComputeMeshletBounds(meshlet, indices.data(), positions.data());
+			meshlets.push_back(meshlet);
+			meshlet = Meshlet();
+			meshlet.firstIndex = i;
+			meshletIndex = meshlets.size();
+			meshletVertexCount = 0;
+		}
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			GLuint vertex = indices[i + corner];
+			if (vertexMeshlet[vertex] != meshletIndex)
+			{
+				vertexMeshlet[vertex] = meshletIndex;
+				++meshletVertexCount;
+			}
+		}
+		meshlet.indexCount += 3;
+	}
+
+	if (meshlet.indexCount > 0)
+	{
+		ComputeMeshletBounds(meshlet, indices.data(), positions.data());
+		meshlets.push_back(meshlet);
+	}
+
+	return meshlets.size() - firstMeshlet;
+}
+
+bool IsMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition)
+{
+	if (!IsSphereInFrustum(frustum, meshlet.sphere))
+	{
+		return false;
+	}
+
+	// Comparing without normalizing the offset keeps a cone with a zero axis (one that cannot be culled) visible,
+	// even for a camera right at its apex
+	glm::vec3 offset = meshlet.coneApex - cameraPosition;
+	return glm::dot(offset, meshlet.coneAxis) <= meshlet.coneCutoff * glm::length(offset);
+}
+
+size_t CullMeshlets(const Meshlet* meshlets, size_t meshletCount, const Frustum& frustum, const glm::vec3& cameraPosition,
+	unsigned char* visible)
+{
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+#if defined(GDEV_MESHLET_SSE)
+	// Each register holds one value of four meshlets, like CullBoundingBoxes()
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 cameraX = _mm_set1_ps(cameraPosition.x);
+	const __m128 cameraY = _mm_set1_ps(cameraPosition.y);
+	const __m128 cameraZ = _mm_set1_ps(cameraPosition.z);
+	for (; i + 4 <= meshletCount; i += 4)
+	{
+		const Meshlet* m = meshlets + i;
+		__m128 centerX = _mm_set_ps(m[3].sphere.center.x, m[2].sphere.center.x, m[1].sphere.center.x, m[0].sphere.center.x);
+		__m128 centerY = _mm_set_ps(m[3].sphere.center.y, m[2].sphere.center.y, m[1].sphere.center.y, m[0].sphere.center.y);
+		__m128 centerZ = _mm_set_ps(m[3].sphere.center.z, m[2].sphere.center.z, m[1].sphere.center.z, m[0].sphere.center.z);
+		__m128 radius = _mm_set_ps(m[3].sphere.radius, m[2].sphere.radius, m[1].sphere.radius, m[0].sphere.radius);
+
+		__m128 outside = zero;
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_mul_ps(_mm_set1_ps(plane.y), centerY)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), centerZ), _mm_set1_ps(plane.w)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		__m128 offsetX = _mm_sub_ps(_mm_set_ps(m[3].coneApex.x, m[2].coneApex.x, m[1].coneApex.x, m[0].coneApex.x), cameraX);
+		__m128 offsetY = _mm_sub_ps(_mm_set_ps(m[3].coneApex.y, m[2].coneApex.y, m[1].coneApex.y, m[0].coneApex.y), cameraY);
+		__m128 offsetZ = _mm_sub_ps(_mm_set_ps(m[3].coneApex.z, m[2].coneApex.z, m[1].coneApex.z, m[0].coneApex.z), cameraZ);
+		__m128 axisX = _mm_set_ps(m[3].coneAxis.x, m[2].coneAxis.x, m[1].coneAxis.x, m[0].coneAxis.x);
+		__m128 axisY = _mm_set_ps(m[3].coneAxis.y, m[2].coneAxis.y, m[1].coneAxis.y, m[0].coneAxis.y);
+		__m128 axisZ = _mm_set_ps(m[3].coneAxis.z, m[2].coneAxis.z, m[1].coneAxis.z, m[0].coneAxis.z);
+		__m128 cutoff = _mm_set_ps(m[3].coneCutoff, m[2].coneCutoff, m[1].coneCutoff, m[0].coneCutoff);
+
+		__m128 axisDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, axisX), _mm_mul_ps(offsetY, axisY)), _mm_mul_ps(offsetZ, axisZ));
+		__m128 offsetLength = _mm_sqrt_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ)));
+		outside = _mm_or_ps(outside, _mm_cmpgt_ps(axisDot, _mm_mul_ps(cutoff, offsetLength)));
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for (int j = 0; j < 4; ++j)
+		{
+			visible[i + j] = (outsideMask & (1 << j)) == 0 ? 1 : 0;
+			visibleCount += visible[i + j];
+		}
+	}
+#endif
+
+	// The meshlets that are left over (or all of them without SSE)
+	for (; i < meshletCount; ++i)
+	{
+		visible[i] = IsMeshletVisible(meshlets[i], frustum, cameraPosition) ? 1 : 0;
+		visibleCount += visible[i];
+	}
+
+	return visibleCount;
+}
+
+size_t CompactMeshletDraws(const Meshlet* meshlets, const unsigned char* visible, size_t meshletCount, GLenum indexType,
+	MeshletDrawList& drawList)
+{
+	drawList.counts.clear();
+	drawList.offsets.clear();
+
+	size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	GLuint rangeEnd = 0;
+	for (size_t i = 0; i < meshletCount; ++i)
+	{
+		if (!visible[i])
+		{
+			continue;
+		}
+
+		if (!drawList.counts.empty() && meshlets[i].firstIndex == rangeEnd)
+		{
+			drawList.counts.back() += meshlets[i].indexCount;
+		}
+		else
+		{
+			drawList.counts.push_back(meshlets[i].indexCount);
+			drawList.offsets.push_back(reinterpret_cast<const void*>(meshlets[i].firstIndex * indexSize));
+		}
+		rangeEnd = meshlets[i].firstIndex + meshlets[i].indexCount;
+	}
+
+	return drawList.counts.size();
+}
+
+void DrawMeshlets(const Mesh& mesh, const MeshletDrawList& drawList)
+{
+	if (drawList.counts.empty())
+	{
+		return;
+	}
+	MultiDrawElements(GL_TRIANGLES, drawList.counts.data(), mesh.indexType, drawList.offsets.data(),
+		static_cast<GLsizei>(drawList.counts.size()));
+}
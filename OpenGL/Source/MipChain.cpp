@@ -0,0 +1,78 @@
+#include <gdev/MipChain.h>
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Averages 2x2 blocks of an RGBA8 image into the next smaller mip level.
+ * For odd sizes the last row/column is reused, so a 1-pixel-wide image just halves its height.
+ * @param[in] source Pixels of the larger level
+ * @param[in] sourceWidth Width of the larger level
+ * @param[in] sourceHeight Height of the larger level
+ * @param[out] destination Pixels of the smaller level
+ * @param[in] width Width of the smaller level
+ * @param[in] height Height of the smaller level
+ */
+static void DownsampleBox(const unsigned char* source, int sourceWidth, int sourceHeight, unsigned char* destination, int width, int height)
+{
+	size_t sourceRowSize = static_cast<size_t>(sourceWidth) * 4;
+	for (int y = 0; y < height; ++y)
+	{
+		const unsigned char* row0 = source + std::min(2 * y, sourceHeight - 1) * sourceRowSize;
+		const unsigned char* row1 = source + std::min(2 * y + 1, sourceHeight - 1) * sourceRowSize;
+		unsigned char* out = destination + static_cast<size_t>(y) * width * 4;
+
+		// Plain byte loop with no branches inside, which the compiler turns into SIMD code
+		for (int x = 0; x < width; ++x)
+		{
+			int x0 = std::min(2 * x, sourceWidth - 1) * 4;
+			int x1 = std::min(2 * x + 1, sourceWidth - 1) * 4;
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				unsigned int sum = row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel];
+				out[x * 4 + channel] = static_cast<unsigned char>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+int GetMipLevelCount(int width, int height)
+{
+	int levelCount = 1;
+	while (width > 1 || height > 1)
+	{
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		++levelCount;
+	}
+	return levelCount;
+}
+
+std::vector<unsigned char> BuildMipChain(const unsigned char* pixels, int width, int height, int levelCount, std::vector<MipLevel>& levels)
+{
+	levelCount = std::max(1, std::min(levelCount, GetMipLevelCount(width, height)));
+
+	// Lay out all levels first, so the pixels only need one allocation
+	levels.resize(levelCount);
+	size_t totalSize = 0;
+	for (int i = 0; i < levelCount; ++i)
+	{
+		MipLevel& level = levels[i];
+		level.width = std::max(width >> i, 1);
+		level.height = std::max(height >> i, 1);
+		level.offset = totalSize;
+		level.size = static_cast<size_t>(level.width) * level.height * 4;
+		totalSize += level.size;
+	}
+
+	std::vector<unsigned char> chain(totalSize);
+	std::memcpy(chain.data(), pixels, levels[0].size);
+	for (int i = 1; i < levelCount; ++i)
+	{
+		const MipLevel& source = levels[i - 1];
+		const MipLevel& level = levels[i];
+		DownsampleBox(&chain[source.offset], source.width, source.height, &chain[level.offset], level.width, level.height);
+	}
+
+	return chain;
+}
@@ -0,0 +1,166 @@
+#include <gdev/OcclusionCulling.h>
+
+#include <gdev/Benchmark.h>
+
+#include <chrono>
+
+// Visible objects are tested again after this many frames (plus a few, so that they are not all tested at once)
+static const int VISIBLE_QUERY_INTERVAL = 4;
+// Hidden objects share queries once this many queries in a row found them hidden
+static const int SHARED_QUERY_HIDDEN_COUNT = 3;
+// Queries this many frames old are waited for, so that the visibility never lags further behind
+static const int MAX_QUERY_LATENCY = 3;
+
+void OcclusionCuller::BeginFrame()
+{
+	++frameIndex;
+
+	size_t remainingCount = 0;
+	for (size_t i = 0; i < pendingQueries.size(); ++i)
+	{
+		const PendingQuery& pendingQuery = pendingQueries[i];
+
+		GLuint anySamplesPassed = 0;
+		if (pendingQuery.frame + MAX_QUERY_LATENCY <= frameIndex)
+		{
+			// Too old to keep using the visibility from before it: wait for the GPU
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			glGetQueryObjectuiv(pendingQuery.query, GL_QUERY_RESULT, &anySamplesPassed);
+			std::chrono::steady_clock::duration stall = std::chrono::steady_clock::now() - start;
+			AddFrameCounter(FrameCounter::OcclusionStallMicroseconds,
+				std::chrono::duration_cast<std::chrono::microseconds>(stall).count());
+		}
+		else
+		{
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(pendingQuery.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				pendingQueries[remainingCount++] = pendingQuery;
+				continue;
+			}
+			glGetQueryObjectuiv(pendingQuery.query, GL_QUERY_RESULT, &anySamplesPassed);
+		}
+
+		ApplyResult(pendingQuery, anySamplesPassed != GL_FALSE);
+		freeQueries.push_back(pendingQuery.query);
+	}
+	pendingQueries.resize(remainingCount);
+}
+
+void OcclusionCuller::ApplyResult(const PendingQuery& pendingQuery, bool anySamplesPassed)
+{
+	for (int i = 0; i < pendingQuery.objectCount; ++i)
+	{
+		int object = pendingQuery.objects[i];
+		ObjectState& state = objectStates[object];
+		state.queryPending = false;
+
+		if (!anySamplesPassed)
+		{
+			state.visible = false;
+			++state.hiddenQueryCount;
+		}
+		else if (pendingQuery.objectCount > 1)
+		{
+			// We only know that one of the objects is visible, so each of them is tested on its own next time
+			state.visible = true;
+			state.hiddenQueryCount = 0;
+			state.nextQueryFrame = frameIndex;
+		}
+		else
+		{
+			state.visible = true;
+			state.hiddenQueryCount = 0;
+			state.nextQueryFrame = frameIndex + VISIBLE_QUERY_INTERVAL + object % VISIBLE_QUERY_INTERVAL;
+		}
+	}
+}
+
+bool OcclusionCuller::IsVisible(int object)
+{
+	if (object >= static_cast<int>(objectStates.size()))
+	{
+		objectStates.resize(object + 1);
+	}
+
+	// What we knew about an object that was not looked at last frame is too old to use
+	ObjectState& state = objectStates[object];
+	if (state.lastLookedAtFrame < frameIndex - 1)
+	{
+		state.visible = true;
+		state.hiddenQueryCount = 0;
+		state.nextQueryFrame = frameIndex;
+	}
+	state.lastLookedAtFrame = frameIndex;
+	return state.visible;
+}
+
+bool OcclusionCuller::IsQueryDue(int object) const
+{
+	const ObjectState& state = objectStates[object];
+	return !state.queryPending && (!state.visible || frameIndex >= state.nextQueryFrame);
+}
+
+bool OcclusionCuller::CanShareQuery(int object) const
+{
+	const ObjectState& state = objectStates[object];
+	return !state.visible && state.hiddenQueryCount >= SHARED_QUERY_HIDDEN_COUNT;
+}
+
+void OcclusionCuller::BeginQuery(const int* objects, int objectCount)
+{
+	PendingQuery pendingQuery;
+	if (freeQueries.empty())
+	{
+		glGenQueries(1, &pendingQuery.query);
+		allQueries.push_back(pendingQuery.query);
+	}
+	else
+	{
+		pendingQuery.query = freeQueries.back();
+		freeQueries.pop_back();
+	}
+	pendingQuery.frame = frameIndex;
+	pendingQuery.objectCount = objectCount < MAX_OCCLUSION_QUERY_OBJECTS ? objectCount : MAX_OCCLUSION_QUERY_OBJECTS;
+	for (int i = 0; i < pendingQuery.objectCount; ++i)
+	{
+		pendingQuery.objects[i] = objects[i];
+		objectStates[objects[i]].queryPending = true;
+	}
+	pendingQueries.push_back(pendingQuery);
+
+	glBeginQuery(GL_ANY_SAMPLES_PASSED, pendingQuery.query);
+	AddFrameCounter(FrameCounter::OcclusionQueries);
+}
+
+void OcclusionCuller::EndQuery()
+{
+	glEndQuery(GL_ANY_SAMPLES_PASSED);
+}
+
+void OcclusionCuller::Delete()
+{
+	if (!allQueries.empty())
+	{
+		glDeleteQueries(static_cast<GLsizei>(allQueries.size()), allQueries.data());
+	}
+	allQueries.clear();
+	freeQueries.clear();
+	pendingQueries.clear();
+	objectStates.clear();
+}
+
+void BeginOcclusionBoxes()
+{
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+}
+
+void EndOcclusionBoxes()
+{
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
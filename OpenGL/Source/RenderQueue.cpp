@@ -0,0 +1,108 @@
+#include <gdev/RenderQueue.h>
+
+#include <algorithm>
+
+static_assert(SORT_KEY_MESH_BITS + SORT_KEY_DEPTH_BITS + SORT_KEY_TEXTURE_BITS + SORT_KEY_PROGRAM_BITS + SORT_KEY_PASS_BITS == 64,
+	"The fields of a sort key have to fill 64 bits");
+static_assert(static_cast<int>(RenderPass::Count) <= (1 << SORT_KEY_PASS_BITS), "Too many render passes for the sort key");
+
+static const int DEPTH_SHIFT = SORT_KEY_MESH_BITS;
+static const int TEXTURE_SHIFT = DEPTH_SHIFT + SORT_KEY_DEPTH_BITS;
+static const int PROGRAM_SHIFT = TEXTURE_SHIFT + SORT_KEY_TEXTURE_BITS;
+static const int PASS_SHIFT = PROGRAM_SHIFT + SORT_KEY_PROGRAM_BITS;
+
+/**
+ * @brief Keeps the lowest bits of a value.
+ * @param[in] value Value
+ * @param[in] bitCount Number of bits to keep
+ * @return The value with only its lowest bits
+ */
+static unsigned long long MaskBits(unsigned long long value, int bitCount)
+{
+	return value & ((1ull << bitCount) - 1);
+}
+
+unsigned long long MakeSortKey(RenderPass pass, unsigned int program, unsigned int texture, float depth, unsigned int mesh)
+{
+	const unsigned long long maxDepth = (1ull << SORT_KEY_DEPTH_BITS) - 1;
+	unsigned long long quantizedDepth = static_cast<unsigned long long>(std::min(std::max(depth, 0.0f), 1.0f) * maxDepth);
+
+	return (MaskBits(static_cast<unsigned long long>(pass), SORT_KEY_PASS_BITS) << PASS_SHIFT)
+		| (MaskBits(program, SORT_KEY_PROGRAM_BITS) << PROGRAM_SHIFT)
+		| (MaskBits(texture, SORT_KEY_TEXTURE_BITS) << TEXTURE_SHIFT)
+		| (quantizedDepth << DEPTH_SHIFT)
+		| MaskBits(mesh, SORT_KEY_MESH_BITS);
+}
+
+RenderPass GetSortKeyPass(unsigned long long key)
+{
+	return static_cast<RenderPass>(key >> PASS_SHIFT);
+}
+
+RenderQueue::RenderQueue(size_t capacity)
+	: items(capacity), sortBuffer(capacity)
+{
+}
+
+void RenderQueue::Submit(unsigned long long key, unsigned int payload)
+{
+	if (count == items.size())
+	{
+		items.resize(std::max<size_t>(64, items.size() * 2));
+		sortBuffer.resize(items.size());
+	}
+
+	items[count].key = key;
+	items[count].payload = payload;
+	++count;
+}
+
+void RenderQueue::Sort()
+{
+	// Count how many keys have each value of each byte, for all 8 bytes at once
+	size_t histograms[8][256] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		unsigned long long key = items[i].key;
+		for (int byte = 0; byte < 8; ++byte)
+		{
+			++histograms[byte][(key >> (byte * 8)) & 0xFF];
+		}
+	}
+
+	// Least significant byte first; each pass is stable, so the order of the previous passes is kept
+	RenderQueueItem* source = items.data();
+	RenderQueueItem* destination = sortBuffer.data();
+	for (int byte = 0; byte < 8; ++byte)
+	{
+		size_t* histogram = histograms[byte];
+		int shift = byte * 8;
+
+		// Nothing to do if all keys have the same value in this byte (e.g. unused depth or program bits)
+		if (count == 0 || histogram[(source[0].key >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		// Turn the counts into the first position of each value
+		size_t offset = 0;
+		for (int value = 0; value < 256; ++value)
+		{
+			size_t valueCount = histogram[value];
+			histogram[value] = offset;
+			offset += valueCount;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+		std::swap(source, destination);
+	}
+
+	// After an odd number of passes the sorted items are in the sort buffer
+	if (source != items.data())
+	{
+		items.swap(sortBuffer);
+	}
+}
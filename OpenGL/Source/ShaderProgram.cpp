@@ -0,0 +1,279 @@
+#include <gdev/ShaderProgram.h>
+
+#include <gdev/Benchmark.h>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+/**
+ * @brief Checks whether a value of the given type can be used to set a uniform.
+ * @param[in] uniformType GLSL type of the uniform
+ * @param[in] valueType Type of the value (GL_INT, GL_FLOAT, GL_FLOAT_VEC3, ...)
+ * @return true if glUniform*() for the value type works on the uniform
+ */
+static bool IsUniformTypeCompatible(GLenum uniformType, GLenum valueType)
+{
+	if (uniformType == valueType)
+	{
+		return true;
+	}
+
+	// Booleans and samplers are set with glUniform1i()
+	if (valueType == GL_INT)
+	{
+		switch (uniformType)
+		{
+		case GL_BOOL:
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_BUFFER:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+unsigned int HashUniformName(const char* name)
+{
+	unsigned int hash = 2166136261u;
+	for (const char* c = name; *c != '\0'; ++c)
+	{
+		hash ^= static_cast<unsigned char>(*c);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+int ShaderProgram::FindUniform(const char* name) const
+{
+	if (uniformSlots.empty())
+	{
+		return -1;
+	}
+
+	unsigned int hash = HashUniformName(name);
+	size_t mask = uniformSlots.size() - 1;
+	for (size_t slot = hash & mask; uniformSlots[slot] >= 0; slot = (slot + 1) & mask)
+	{
+		const ShaderUniform& uniform = uniforms[uniformSlots[slot]];
+		if (uniform.nameHash == hash && uniform.name == name)
+		{
+			return uniformSlots[slot];
+		}
+	}
+	return -1;
+}
+
+GLint ShaderProgram::GetUniformLocation(const char* name) const
+{
+	int index = FindUniform(name);
+	return index >= 0 ? uniforms[index].location : -1;
+}
+
+ShaderUniform* ShaderProgram::PrepareUpdate(const char* name, GLenum type, const void* value, size_t valueSize)
+{
+	int index = FindUniform(name);
+	if (index < 0 || uniforms[index].location < 0)
+	{
+		return nullptr;
+	}
+
+	ShaderUniform& uniform = uniforms[index];
+	if (!IsUniformTypeCompatible(uniform.type, type))
+	{
+		std::cerr << "Uniform " << uniform.name << " has a different type than the value given to it" << std::endl;
+		return nullptr;
+	}
+
+	// Nothing to do if OpenGL already has this value
+	if (uniform.hasValue && std::memcmp(uniform.value, value, valueSize) == 0)
+	{
+		AddFrameCounter(FrameCounter::UniformUpdatesSkipped);
+		return nullptr;
+	}
+
+	std::memcpy(uniform.value, value, valueSize);
+	uniform.hasValue = true;
+	AddFrameCounter(FrameCounter::UniformUpdates);
+	return &uniform;
+}
+
+void ShaderProgram::SetUniform(const char* name, int value)
+{
+	if (ShaderUniform* uniform = PrepareUpdate(name, GL_INT, &value, sizeof(value)))
+	{
+		glUniform1i(uniform->location, value);
+	}
+}
+
+void ShaderProgram::SetUniform(const char* name, float value)
+{
+	if (ShaderUniform* uniform = PrepareUpdate(name, GL_FLOAT, &value, sizeof(value)))
+	{
+		glUniform1f(uniform->location, value);
+	}
+}
+
+void ShaderProgram::SetUniform(const char* name, const glm::vec3& value)
+{
+	if (ShaderUniform* uniform = PrepareUpdate(name, GL_FLOAT_VEC3, glm::value_ptr(value), sizeof(value)))
+	{
+		glUniform3fv(uniform->location, 1, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::SetUniform(const char* name, const glm::vec4& value)
+{
+	if (ShaderUniform* uniform = PrepareUpdate(name, GL_FLOAT_VEC4, glm::value_ptr(value), sizeof(value)))
+	{
+		glUniform4fv(uniform->location, 1, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::SetUniform(const char* name, const glm::mat3& value)
+{
+	if (ShaderUniform* uniform = PrepareUpdate(name, GL_FLOAT_MAT3, glm::value_ptr(value), sizeof(value)))
+	{
+		glUniformMatrix3fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::SetUniform(const char* name, const glm::mat4& value)
+{
+	if (ShaderUniform* uniform = PrepareUpdate(name, GL_FLOAT_MAT4, glm::value_ptr(value), sizeof(value)))
+	{
+		glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::BindUniformBlock(const char* blockName, GLuint bindingPoint)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(id, blockName);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(id, blockIndex, bindingPoint);
+	}
+}
+
+ShaderProgram CreateShaderProgram(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
+{
+	GLuint vertexShader = CreateShaderFromFile(GL_VERTEX_SHADER, vertexShaderFilePath);
+	GLuint fragmentShader = CreateShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFilePath);
+
+	ShaderProgram program;
+	program.id = glCreateProgram();
+	glAttachShader(program.id, vertexShader);
+	glAttachShader(program.id, fragmentShader);
+
+	glLinkProgram(program.id);
+
+	glDetachShader(program.id, vertexShader);
+	glDeleteShader(vertexShader);
+	glDetachShader(program.id, fragmentShader);
+	glDeleteShader(fragmentShader);
+
+	// Check shader program link status
+	GLint linkStatus;
+	glGetProgramiv(program.id, GL_LINK_STATUS, &linkStatus);
+	if (linkStatus != GL_TRUE) {
+		char infoLog[512];
+		GLsizei infoLogLen = sizeof(infoLog);
+		glGetProgramInfoLog(program.id, infoLogLen, &infoLogLen, infoLog);
+		std::cerr << "program link error: " << infoLog << std::endl;
+		return program;
+	}
+
+	// Read the active uniforms once, so that we never have to ask OpenGL for their locations again
+	GLint uniformCount = 0;
+	glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &uniformCount);
+	for (GLint i = 0; i < uniformCount; ++i)
+	{
+		char name[256];
+		GLsizei nameLen = 0;
+		ShaderUniform uniform;
+		glGetActiveUniform(program.id, static_cast<GLuint>(i), sizeof(name), &nameLen, &uniform.size, &uniform.type, name);
+
+		// Arrays are reported as "name[0]"; we look them up by their plain name
+		uniform.name.assign(name, nameLen);
+		if (uniform.name.size() > 3 && uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0)
+		{
+			uniform.name.resize(uniform.name.size() - 3);
+		}
+		uniform.location = glGetUniformLocation(program.id, name);
+		uniform.nameHash = HashUniformName(uniform.name.c_str());
+		program.uniforms.push_back(uniform);
+	}
+
+	// Fill the hash table; the table is never full, so every lookup ends at an empty slot
+	size_t slotCount = 1;
+	while (slotCount < program.uniforms.size() * 2)
+	{
+		slotCount *= 2;
+	}
+	program.uniformSlots.assign(slotCount, -1);
+	size_t mask = slotCount - 1;
+	for (size_t i = 0; i < program.uniforms.size(); ++i)
+	{
+		size_t slot = program.uniforms[i].nameHash & mask;
+		while (program.uniformSlots[slot] >= 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+		program.uniformSlots[slot] = static_cast<int>(i);
+	}
+
+	return program;
+}
+
+GLuint CreateShaderFromFile(const GLuint& shaderType, const std::string& shaderFilePath)
+{
+	std::ifstream shaderFile(shaderFilePath);
+	if (shaderFile.fail())
+	{
+		std::cerr << "Unable to open shader file: " << shaderFilePath << std::endl;
+		return 0;
+	}
+
+	std::string shaderSource;
+	std::string temp;
+	while (std::getline(shaderFile, temp))
+	{
+		shaderSource += temp + "\n";
+	}
+	shaderFile.close();
+
+	return CreateShaderFromSource(shaderType, shaderSource);
+}
+
+GLuint CreateShaderFromSource(const GLuint& shaderType, const std::string& shaderSource)
+{
+	GLuint shader = glCreateShader(shaderType);
+
+	const char* shaderSourceCStr = shaderSource.c_str();
+	GLint shaderSourceLen = static_cast<GLint>(shaderSource.length());
+	glShaderSource(shader, 1, &shaderSourceCStr, &shaderSourceLen);
+	glCompileShader(shader);
+
+	// Check compilation status
+	GLint compileStatus;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+	if (compileStatus == GL_FALSE)
+	{
+		char infoLog[512];
+		GLsizei infoLogLen = sizeof(infoLog);
+		glGetShaderInfoLog(shader, infoLogLen, &infoLogLen, infoLog);
+		std::cerr << "shader compilation error: " << infoLog << std::endl;
+	}
+
+	return shader;
+}
@@ -0,0 +1,106 @@
+#include <gdev/StateCache.h>
+
+#include <gdev/Benchmark.h>
+
+// Binding that the cache does not know (the next call is always issued)
+static const GLuint UNKNOWN_BINDING = ~0u;
+
+static const GLenum cachedTextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP };
+static const int CACHED_TEXTURE_TARGET_COUNT = sizeof(cachedTextureTargets) / sizeof(cachedTextureTargets[0]);
+
+/**
+ * Struct containing the bindings that OpenGL currently has, as far as the cache knows
+ */
+struct CachedState
+{
+	GLuint program = UNKNOWN_BINDING;
+	GLuint vertexArray = UNKNOWN_BINDING;
+	GLuint activeTextureUnit = UNKNOWN_BINDING;
+	GLuint textures[STATE_CACHE_TEXTURE_UNITS][CACHED_TEXTURE_TARGET_COUNT];
+
+	CachedState()
+	{
+		for (GLuint unit = 0; unit < STATE_CACHE_TEXTURE_UNITS; ++unit)
+		{
+			for (int target = 0; target < CACHED_TEXTURE_TARGET_COUNT; ++target)
+			{
+				textures[unit][target] = UNKNOWN_BINDING;
+			}
+		}
+	}
+};
+
+static CachedState cachedState;
+
+/**
+ * @brief Updates a cached binding, and counts whether the OpenGL call is needed.
+ * @param[in,out] binding Cached binding
+ * @param[in] value New binding
+ * @return true if the OpenGL call has to be made
+ */
+static bool ChangeBinding(GLuint& binding, GLuint value)
+{
+	if (binding == value)
+	{
+		AddFrameCounter(FrameCounter::StateChangesSkipped);
+		return false;
+	}
+
+	binding = value;
+	AddFrameCounter(FrameCounter::StateChanges);
+	return true;
+}
+
+void UseProgram(GLuint program)
+{
+	if (ChangeBinding(cachedState.program, program))
+	{
+		glUseProgram(program);
+	}
+}
+
+void BindVertexArray(GLuint vertexArray)
+{
+	if (ChangeBinding(cachedState.vertexArray, vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+	}
+}
+
+void BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	int targetIndex = 0;
+	while (targetIndex < CACHED_TEXTURE_TARGET_COUNT && cachedTextureTargets[targetIndex] != target)
+	{
+		++targetIndex;
+	}
+
+	// Bindings that are not cached are always made, and the cache forgets the active unit
+	if (unit >= STATE_CACHE_TEXTURE_UNITS || targetIndex == CACHED_TEXTURE_TARGET_COUNT)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		cachedState.activeTextureUnit = unit < STATE_CACHE_TEXTURE_UNITS ? unit : UNKNOWN_BINDING;
+		AddFrameCounter(FrameCounter::StateChanges, 2);
+		return;
+	}
+
+	// The texture is already bound to this unit, so the active unit does not matter
+	if (cachedState.textures[unit][targetIndex] == texture)
+	{
+		AddFrameCounter(FrameCounter::StateChangesSkipped);
+		return;
+	}
+
+	if (ChangeBinding(cachedState.activeTextureUnit, unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	ChangeBinding(cachedState.textures[unit][targetIndex], texture);
+	glBindTexture(target, texture);
+}
+
+void InvalidateStateCache()
+{
+	cachedState = CachedState();
+}
@@ -0,0 +1,151 @@
+#include <gdev/StreamBuffer.h>
+
+#include <gdev/Benchmark.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+StreamBuffer CreateStreamBuffer(GLsizeiptr frameSize)
+{
+	GLint uniformAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+
+	StreamBuffer buffer;
+	buffer.frameSize = frameSize;
+	buffer.uniformAlignment = uniformAlignment;
+
+	// GL_COPY_WRITE_BUFFER is not used by anything else, so mapping through it leaves the other bindings alone
+	glGenBuffers(1, &buffer.id);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+	glBufferData(GL_COPY_WRITE_BUFFER, frameSize * STREAM_BUFFER_FRAME_COUNT, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	return buffer;
+}
+
+/**
+ * @brief Waits until the GPU is done with the part of the buffer that the current frame writes.
+ * @param[in,out] buffer Buffer to wait for
+ */
+static void WaitForStreamBufferFrame(StreamBuffer& buffer)
+{
+	GLsync& fence = buffer.fences[buffer.frame];
+	if (fence == nullptr)
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		// Flush the fence the first time, in case the frame that it ends has not been sent to the GPU yet
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+	if (result == GL_WAIT_FAILED)
+	{
+		std::cerr << "Waiting for a stream buffer fence failed" << std::endl;
+	}
+	std::chrono::steady_clock::duration stall = std::chrono::steady_clock::now() - start;
+	AddFrameCounter(FrameCounter::StreamBufferStallMicroseconds,
+		std::chrono::duration_cast<std::chrono::microseconds>(stall).count());
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void* AllocateStreamBuffer(StreamBuffer& buffer, GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset)
+{
+	// Offsets are aligned from the start of the buffer, and the part of each frame starts wherever frameSize puts it
+	GLintptr frameStart = buffer.frame * buffer.frameSize;
+	GLintptr start = (frameStart + buffer.writeOffset + alignment - 1) / alignment * alignment - frameStart;
+	if (start + size > buffer.frameSize)
+	{
+		std::cerr << "Stream buffer is full (" << buffer.frameSize << " bytes per frame)" << std::endl;
+		return nullptr;
+	}
+
+	if (buffer.mapped == nullptr)
+	{
+		if (buffer.writeOffset == 0)
+		{
+			WaitForStreamBufferFrame(buffer);
+		}
+
+		// The rest of the part is mapped at once, and only the bytes that were written are flushed when unmapping
+		buffer.mappedOffset = start;
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+		buffer.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, frameStart + start, buffer.frameSize - start,
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		if (buffer.mapped == nullptr)
+		{
+			std::cerr << "Unable to map the stream buffer" << std::endl;
+			return nullptr;
+		}
+	}
+
+	buffer.writeOffset = start + size;
+	offset = frameStart + start;
+	AddFrameCounter(FrameCounter::StreamBufferBytes, static_cast<unsigned long long>(size));
+	return buffer.mapped + (start - buffer.mappedOffset);
+}
+
+GLintptr WriteStreamBuffer(StreamBuffer& buffer, const void* data, GLsizeiptr size, GLsizeiptr alignment)
+{
+	GLintptr offset = -1;
+	void* destination = AllocateStreamBuffer(buffer, size, alignment, offset);
+	if (destination == nullptr)
+	{
+		return -1;
+	}
+	std::memcpy(destination, data, size);
+	return offset;
+}
+
+void UnmapStreamBuffer(StreamBuffer& buffer)
+{
+	if (buffer.mapped == nullptr)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+	glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, buffer.writeOffset - buffer.mappedOffset);
+	if (glUnmapBuffer(GL_COPY_WRITE_BUFFER) != GL_TRUE)
+	{
+		std::cerr << "The contents of the stream buffer were lost while it was mapped" << std::endl;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	buffer.mapped = nullptr;
+}
+
+void EndStreamBufferFrame(StreamBuffer& buffer)
+{
+	UnmapStreamBuffer(buffer);
+
+	// The first write of the frame waited for and deleted the old fence of this part.
+	// A frame that wrote nothing keeps the old fence, since the GPU may still be reading what it protects.
+	if (buffer.writeOffset > 0)
+	{
+		buffer.fences[buffer.frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	buffer.frame = (buffer.frame + 1) % STREAM_BUFFER_FRAME_COUNT;
+	buffer.writeOffset = 0;
+}
+
+void DeleteStreamBuffer(StreamBuffer& buffer)
+{
+	UnmapStreamBuffer(buffer);
+	for (GLsync fence : buffer.fences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+		}
+	}
+	glDeleteBuffers(1, &buffer.id);
+	buffer = StreamBuffer();
+}
@@ -0,0 +1,221 @@
+#include <gdev/TextureLoader.h>
+
+#include <gdev/StateCache.h>
+
+#include <cstring>
+#include <iostream>
+
+#include <stb_image.h>
+
+TextureLoader::TextureLoader(int threadCount, bool generateMipmaps)
+	: generateMipmaps(generateMipmaps)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	threadCount = threadCount > 0 ? threadCount : 1;
+
+	for (int i = 0; i < threadCount; ++i)
+	{
+		workers.emplace_back(&TextureLoader::WorkerMain, this);
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueChanged.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	// Drop the images that were never uploaded
+	for (ImageJob* job : queuedJobs)
+	{
+		delete job;
+	}
+	for (ImageJob* job : decodedJobs)
+	{
+		delete job;
+	}
+}
+
+GLuint TextureLoader::Load(const std::string& filePath, bool flipVertically)
+{
+	ImageJob* job = new ImageJob();
+	job->filePath = filePath;
+	job->flipVertically = flipVertically;
+	glGenTextures(1, &job->texture);
+	GLuint texture = job->texture;
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		queuedJobs.push_back(job);
+	}
+	queueChanged.notify_one();
+
+	++pendingJobCount;
+	return texture;
+}
+
+void TextureLoader::WorkerMain()
+{
+	for (;;)
+	{
+		ImageJob* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueChanged.wait(lock, [this]() { return stopping || !queuedJobs.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			job = queuedJobs.front();
+			queuedJobs.pop_front();
+		}
+
+		if (IsCookedTexturePath(job->filePath))
+		{
+			// Cooked textures are used straight from the mapped file
+			if (OpenMappedFile(job->cookedFile, job->filePath) && ReadCookedTexture(job->cookedFile.data, job->cookedFile.size, job->info))
+			{
+				job->levelData = job->cookedFile.data;
+				if (!generateMipmaps)
+				{
+					job->info.levels.resize(1);
+				}
+			}
+		}
+		else
+		{
+			// The flip setting is per thread, so the workers do not affect each other (or the rest of the program)
+			stbi_set_flip_vertically_on_load_thread(job->flipVertically ? 1 : 0);
+
+			// Always decode to RGBA, whose rows are 4-byte aligned like GL_UNPACK_ALIGNMENT expects
+			int width = 0;
+			int height = 0;
+			int channelCount = 0;
+			unsigned char* pixels = stbi_load(job->filePath.c_str(), &width, &height, &channelCount, STBI_rgb_alpha);
+			if (pixels != nullptr)
+			{
+				// The smaller levels are built here too, so the OpenGL thread only has to upload them
+				int levelCount = generateMipmaps ? GetMipLevelCount(width, height) : 1;
+				job->pixels = BuildMipChain(pixels, width, height, levelCount, job->info.levels);
+				job->levelData = job->pixels.data();
+				stbi_image_free(pixels);
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			decodedJobs.push_back(job);
+		}
+		jobDecoded.notify_one();
+	}
+}
+
+int TextureLoader::Update()
+{
+	// Take every decoded image at once, so the workers are not kept waiting for the lock during the uploads
+	std::vector<ImageJob*> jobs;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		jobs.swap(decodedJobs);
+	}
+
+	int uploadedCount = 0;
+	for (ImageJob* job : jobs)
+	{
+		if (job->levelData != nullptr)
+		{
+			Upload(*job);
+			++uploadedCount;
+		}
+		else
+		{
+			std::cerr << "Failed to load " << job->filePath << std::endl;
+		}
+
+		delete job;
+		--pendingJobCount;
+	}
+
+	return uploadedCount;
+}
+
+void TextureLoader::WaitAll()
+{
+	Update();
+	while (pendingJobCount > 0)
+	{
+		// Sleep until a worker has decoded another image, instead of spinning on a core the workers could use
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			jobDecoded.wait(lock, [this]() { return !decodedJobs.empty(); });
+		}
+		Update();
+	}
+
+	glDeleteBuffers(1, &uploadBuffer);
+	uploadBuffer = 0;
+}
+
+void TextureLoader::Upload(const ImageJob& job)
+{
+	// The levels are stored one after another, so they can be copied at once
+	const std::vector<MipLevel>& levels = job.info.levels;
+	size_t chainOffset = levels.front().offset;
+	GLsizeiptr chainSize = static_cast<GLsizeiptr>(levels.back().offset + levels.back().size - chainOffset);
+	GLint levelCount = static_cast<GLint>(levels.size());
+
+	// Copy the whole mip chain into a pixel buffer object, and let OpenGL read the levels from there.
+	// Re-specifying the buffer storage lets the driver hand us fresh memory instead of waiting for the previous upload.
+	if (uploadBuffer == 0)
+	{
+		glGenBuffers(1, &uploadBuffer);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, chainSize, nullptr, GL_STREAM_DRAW);
+	void* mappedPixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, chainSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mappedPixels != nullptr)
+	{
+		std::memcpy(mappedPixels, job.levelData + chainOffset, chainSize);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	// Our texture is 2D, so we bind our texture to the GL_TEXTURE_2D target
+	BindTexture(0, GL_TEXTURE_2D, job.texture);
+
+	// Set the filtering methods for magnification and minification.
+	// With mipmaps, minified textures blend the two closest levels (trilinear filtering)
+	// instead of skipping over texels of the full-size image.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+	// Set the wrapping method for the s-axis (x-axis) and t-axis (y-axis)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// With a pixel buffer bound, the last argument is an offset into the buffer instead of a pointer
+	for (GLint i = 0; i < levelCount; ++i)
+	{
+		const MipLevel& level = levels[i];
+		const void* levelPixels = mappedPixels != nullptr ? reinterpret_cast<const void*>(level.offset - chainOffset) : job.levelData + level.offset;
+		glTexImage2D(GL_TEXTURE_2D, i, job.info.internalFormat, level.width, level.height, 0, job.info.pixelFormat, job.info.pixelType, levelPixels);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	BindTexture(0, GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,32 @@
+#include <gdev/Transform.h>
+
+#include <cmath>
+
+glm::mat3 ComputeNormalMatrix(const glm::mat4& modelMatrix)
+{
+	glm::mat3 linear(modelMatrix);
+	glm::vec3 lengthsSquared(glm::dot(linear[0], linear[0]), glm::dot(linear[1], linear[1]), glm::dot(linear[2], linear[2]));
+
+	// If the axes are still perpendicular after the transform, the matrix is a rotation times a scale (R * S),
+	// and transpose(inverse(R * S)) = R * inverse(S), so each axis only needs to be divided by its squared length
+	const float epsilon = 1.0e-5f;
+	float maxLengthSquared = glm::max(lengthsSquared.x, glm::max(lengthsSquared.y, lengthsSquared.z));
+	float tolerance = epsilon * maxLengthSquared;
+	if (std::fabs(glm::dot(linear[0], linear[1])) <= tolerance
+		&& std::fabs(glm::dot(linear[1], linear[2])) <= tolerance
+		&& std::fabs(glm::dot(linear[2], linear[0])) <= tolerance)
+	{
+		// Rigid transform: the rotation is its own inverse transpose
+		if (glm::all(glm::lessThanEqual(glm::abs(lengthsSquared - 1.0f), glm::vec3(epsilon))))
+		{
+			return linear;
+		}
+
+		return glm::mat3(linear[0] / lengthsSquared.x, linear[1] / lengthsSquared.y, linear[2] / lengthsSquared.z);
+	}
+
+	// General case: the inverse transpose is the cofactor matrix divided by the determinant
+	glm::mat3 cofactors(glm::cross(linear[1], linear[2]), glm::cross(linear[2], linear[0]), glm::cross(linear[0], linear[1]));
+	float determinant = glm::dot(linear[0], cofactors[0]);
+	return cofactors * (1.0f / determinant);
+}
@@ -0,0 +1,48 @@
+#include <gdev/UniformBuffer.h>
+
+#include <gdev/Benchmark.h>
+
+UniformBuffer CreateUniformBuffer(GLuint bindingPoint, GLsizeiptr elementSize, GLsizei elementCount, GLenum usage)
+{
+	// Each copy has to start at a multiple of the offset alignment to be bindable with glBindBufferRange()
+	GLint offsetAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+
+	UniformBuffer buffer;
+	buffer.bindingPoint = bindingPoint;
+	buffer.elementSize = elementSize;
+	buffer.stride = (elementSize + offsetAlignment - 1) / offsetAlignment * offsetAlignment;
+	buffer.elementCount = elementCount;
+
+	glGenBuffers(1, &buffer.id);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer.id);
+	glBufferData(GL_UNIFORM_BUFFER, buffer.stride * elementCount, nullptr, usage);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	if (elementCount == 1)
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer.id);
+	}
+
+	return buffer;
+}
+
+void UpdateUniformBuffer(const UniformBuffer& buffer, GLsizei elementIndex, const void* data)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer.id);
+	glBufferSubData(GL_UNIFORM_BUFFER, buffer.stride * elementIndex, buffer.elementSize, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	AddFrameCounter(FrameCounter::UniformBufferUpdates);
+}
+
+void BindUniformBuffer(const UniformBuffer& buffer, GLsizei elementIndex)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, buffer.bindingPoint, buffer.id, buffer.stride * elementIndex, buffer.elementSize);
+}
+
+void DeleteUniformBuffer(UniformBuffer& buffer)
+{
+	glDeleteBuffers(1, &buffer.id);
+	buffer = UniformBuffer();
+}
@@ -0,0 +1,209 @@
+#include <gdev/VertexLayout.h>
+
+#include <glm/gtc/packing.hpp>
+
+#include <cstring>
+#include <iostream>
+
+/**
+ * Struct containing how an attribute format is passed to glVertexAttribPointer()
+ */
+struct VertexAttributeFormatInfo
+{
+	GLint componentCount;
+	GLenum type;
+	GLboolean normalized;
+	GLuint size;	// Size in bytes
+};
+
+// In the same order as the VertexAttributeFormat enum
+static const VertexAttributeFormatInfo formatInfos[] =
+{
+	{ 2, GL_FLOAT, GL_FALSE, 8 },						// Float2
+	{ 3, GL_FLOAT, GL_FALSE, 12 },						// Float3
+	{ 4, GL_FLOAT, GL_FALSE, 16 },						// Float4
+	{ 2, GL_HALF_FLOAT, GL_FALSE, 4 },					// Half2
+	{ 4, GL_HALF_FLOAT, GL_FALSE, 8 },					// Half4
+	{ 2, GL_SHORT, GL_TRUE, 4 },						// Snorm16x2
+	{ 4, GL_SHORT, GL_TRUE, 8 },						// Snorm16x4
+	{ 4, GL_UNSIGNED_BYTE, GL_TRUE, 4 },				// Unorm8x4
+	{ 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4 },			// Snorm10x3
+};
+
+int AddVertexAttribute(VertexLayout& layout, GLuint location, VertexAttributeFormat format, GLuint stream)
+{
+	if (stream >= static_cast<GLuint>(MAX_VERTEX_STREAMS))
+	{
+		std::cerr << "Vertex stream " << stream << " is out of range" << std::endl;
+		return -1;
+	}
+
+	GLuint size = formatInfos[static_cast<int>(format)].size;
+
+	VertexAttribute attribute;
+	attribute.location = location;
+	attribute.format = format;
+	attribute.offset = static_cast<GLuint>(layout.stride);
+	attribute.stream = stream;
+	attribute.streamOffset = static_cast<GLuint>(layout.streamStrides[stream]);
+
+	layout.attributes.push_back(attribute);
+	layout.stride += size;
+	layout.streamStrides[stream] += size;
+	if (static_cast<int>(stream) >= layout.streamCount)
+	{
+		layout.streamCount = static_cast<int>(stream) + 1;
+	}
+	return static_cast<int>(layout.attributes.size()) - 1;
+}
+
+void PackVertexAttribute(const VertexLayout& layout, int attributeIndex, const glm::vec4& value, unsigned char* vertex)
+{
+	const VertexAttribute& attribute = layout.attributes[attributeIndex];
+	unsigned char* destination = vertex + attribute.offset;
+
+	switch (attribute.format)
+	{
+	case VertexAttributeFormat::Float2:
+	case VertexAttributeFormat::Float3:
+	case VertexAttributeFormat::Float4:
+		std::memcpy(destination, &value[0], formatInfos[static_cast<int>(attribute.format)].size);
+		break;
+	case VertexAttributeFormat::Half2:
+	{
+		glm::uint packed = glm::packHalf2x16(glm::vec2(value));
+		std::memcpy(destination, &packed, sizeof(packed));
+		break;
+	}
+	case VertexAttributeFormat::Half4:
+	{
+		glm::uint64 packed = glm::packHalf4x16(value);
+		std::memcpy(destination, &packed, sizeof(packed));
+		break;
+	}
+	case VertexAttributeFormat::Snorm16x2:
+	{
+		glm::uint packed = glm::packSnorm2x16(glm::vec2(value));
+		std::memcpy(destination, &packed, sizeof(packed));
+		break;
+	}
+	case VertexAttributeFormat::Snorm16x4:
+	{
+		glm::uint64 packed = glm::packSnorm4x16(value);
+		std::memcpy(destination, &packed, sizeof(packed));
+		break;
+	}
+	case VertexAttributeFormat::Unorm8x4:
+	{
+		glm::uint packed = glm::packUnorm4x8(value);
+		std::memcpy(destination, &packed, sizeof(packed));
+		break;
+	}
+	case VertexAttributeFormat::Snorm10x3:
+	{
+		glm::uint packed = glm::packSnorm3x10_1x2(glm::vec4(glm::vec3(value), 0.0f));
+		std::memcpy(destination, &packed, sizeof(packed));
+		break;
+	}
+	}
+}
+
+glm::vec4 UnpackVertexAttribute(const VertexLayout& layout, int attributeIndex, const unsigned char* vertex)
+{
+	const VertexAttribute& attribute = layout.attributes[attributeIndex];
+	const unsigned char* source = vertex + attribute.offset;
+
+	glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+	glm::uint packed = 0;
+	glm::uint64 packed64 = 0;
+	switch (attribute.format)
+	{
+	case VertexAttributeFormat::Float2:
+	case VertexAttributeFormat::Float3:
+	case VertexAttributeFormat::Float4:
+		std::memcpy(&value[0], source, formatInfos[static_cast<int>(attribute.format)].size);
+		break;
+	case VertexAttributeFormat::Half2:
+		std::memcpy(&packed, source, sizeof(packed));
+		value = glm::vec4(glm::unpackHalf2x16(packed), 0.0f, 1.0f);
+		break;
+	case VertexAttributeFormat::Half4:
+		std::memcpy(&packed64, source, sizeof(packed64));
+		value = glm::unpackHalf4x16(packed64);
+		break;
+	case VertexAttributeFormat::Snorm16x2:
+		std::memcpy(&packed, source, sizeof(packed));
+		value = glm::vec4(glm::unpackSnorm2x16(packed), 0.0f, 1.0f);
+		break;
+	case VertexAttributeFormat::Snorm16x4:
+		std::memcpy(&packed64, source, sizeof(packed64));
+		value = glm::unpackSnorm4x16(packed64);
+		break;
+	case VertexAttributeFormat::Unorm8x4:
+		std::memcpy(&packed, source, sizeof(packed));
+		value = glm::unpackUnorm4x8(packed);
+		break;
+	case VertexAttributeFormat::Snorm10x3:
+		std::memcpy(&packed, source, sizeof(packed));
+		value = glm::vec4(glm::vec3(glm::unpackSnorm3x10_1x2(packed)), 1.0f);
+		break;
+	}
+	return value;
+}
+
+int FindVertexAttribute(const VertexLayout& layout, GLuint location)
+{
+	for (size_t i = 0; i < layout.attributes.size(); ++i)
+	{
+		if (layout.attributes[i].location == location)
+		{
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+void ExtractVertexStream(const VertexLayout& layout, const unsigned char* vertices, size_t vertexCount, int stream,
+	std::vector<unsigned char>& streamData)
+{
+	streamData.resize(vertexCount * layout.streamStrides[stream]);
+	ExtractVertexStream(layout, vertices, vertexCount, stream, streamData.data());
+}
+
+void ExtractVertexStream(const VertexLayout& layout, const unsigned char* vertices, size_t vertexCount, int stream,
+	unsigned char* streamData)
+{
+	size_t streamStride = layout.streamStrides[stream];
+	for (const VertexAttribute& attribute : layout.attributes)
+	{
+		if (attribute.stream != static_cast<GLuint>(stream))
+		{
+			continue;
+		}
+
+		GLuint size = formatInfos[static_cast<int>(attribute.format)].size;
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			std::memcpy(&streamData[i * streamStride + attribute.streamOffset], vertices + i * layout.stride + attribute.offset, size);
+		}
+	}
+}
+
+void SetVertexLayout(const VertexLayout& layout, const GLuint* vertexBuffers, GLuint streamMask, const GLintptr* streamOffsets)
+{
+	for (const VertexAttribute& attribute : layout.attributes)
+	{
+		if ((streamMask & (1u << attribute.stream)) == 0)
+		{
+			continue;
+		}
+
+		// glVertexAttribPointer() reads from the buffer that is bound to GL_ARRAY_BUFFER
+		const VertexAttributeFormatInfo& info = formatInfos[static_cast<int>(attribute.format)];
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[attribute.stream]);
+		glEnableVertexAttribArray(attribute.location);
+		GLintptr offset = (streamOffsets != nullptr ? streamOffsets[attribute.stream] : 0) + attribute.streamOffset;
+		glVertexAttribPointer(attribute.location, info.componentCount, info.type, info.normalized,
+			layout.streamStrides[attribute.stream], reinterpret_cast<const void*>(offset));
+	}
+}
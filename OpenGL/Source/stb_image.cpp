@@ -0,0 +1,3 @@
+// The stb_image implementation is compiled here, so no other file should define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
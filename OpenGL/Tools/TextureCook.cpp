@@ -0,0 +1,94 @@
+// Offline texture cooker: converts images (.jpg, .png, ...) into cooked textures (.gtex) that can be
+// memory-mapped and uploaded without decoding. See CookedTexture.h for the file layout.
+//
+// Usage: TextureCook [--rgb565] [--no-mipmaps] [--no-flip] image...
+// Each image is written next to itself with the .gtex extension (e.g. pepe.jpg -> pepe.gtex).
+//
+// Built by the Texture Cook project (Projects/Texture Cook), together with Source/stb_image.cpp, Source/MipChain.cpp
+// and Source/CookedTexture.cpp. The Lighting solution builds it and cooks its textures; see its README.txt.
+
+#include <gdev/CookedTexture.h>
+#include <gdev/MipChain.h>
+
+#include <stb_image.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Main function
+ * @param[in] argc Number of command-line arguments
+ * @param[in] argv Command-line arguments (options, then the images to cook)
+ * @return 0 if every image was cooked, 1 otherwise
+ */
+int main(int argc, char** argv)
+{
+	CookedTextureFormat format = CookedTextureFormat::RGBA8;
+	bool mipmaps = true;
+	bool flipVertically = true;
+	std::vector<std::string> imagePaths;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--rgb565") == 0)
+		{
+			format = CookedTextureFormat::RGB565;
+		}
+		else if (std::strcmp(argv[i], "--no-mipmaps") == 0)
+		{
+			mipmaps = false;
+		}
+		else if (std::strcmp(argv[i], "--no-flip") == 0)
+		{
+			flipVertically = false;
+		}
+		else
+		{
+			imagePaths.push_back(argv[i]);
+		}
+	}
+
+	if (imagePaths.empty())
+	{
+		std::cerr << "Usage: TextureCook [--rgb565] [--no-mipmaps] [--no-flip] image..." << std::endl;
+		return 1;
+	}
+
+	// Cooked textures are flipped the same way TextureLoader flips images, so they need no work at load time
+	stbi_set_flip_vertically_on_load(flipVertically);
+
+	int result = 0;
+	for (const std::string& imagePath : imagePaths)
+	{
+		int width, height, channelCount;
+		unsigned char* pixels = stbi_load(imagePath.c_str(), &width, &height, &channelCount, STBI_rgb_alpha);
+		if (pixels == nullptr)
+		{
+			std::cerr << "Failed to load " << imagePath << std::endl;
+			result = 1;
+			continue;
+		}
+
+		std::vector<MipLevel> levels;
+		int levelCount = mipmaps ? GetMipLevelCount(width, height) : 1;
+		std::vector<unsigned char> chain = BuildMipChain(pixels, width, height, levelCount, levels);
+		stbi_image_free(pixels);
+
+		size_t extension = imagePath.find_last_of('.');
+		size_t lastSlash = imagePath.find_last_of("/\\");
+		bool hasExtension = extension != std::string::npos && (lastSlash == std::string::npos || extension > lastSlash);
+		std::string cookedPath = (hasExtension ? imagePath.substr(0, extension) : imagePath) + COOKED_TEXTURE_EXTENSION;
+
+		if (!WriteCookedTexture(cookedPath, chain, levels, format))
+		{
+			result = 1;
+			continue;
+		}
+		std::cout << imagePath << " -> " << cookedPath << " (" << width << "x" << height << ", "
+			<< levels.size() << " levels)" << std::endl;
+	}
+
+	return result;
+}